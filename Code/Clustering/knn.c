@@ -9,8 +9,8 @@
    
 #include "knn.h"
 
-int knn_mfccs_group(float** test, int test_length, int k, char* ph);
-int knn_mfccs_voice(float** test, int test_length, int k, char* ph);
+int knn_mfccs_group(const struct Test_Features* test, int k, char* ph, struct Score_Context* ctx);
+int knn_mfccs_voice(const struct Test_Features* test, int k, char* ph, struct Score_Context* ctx);
 
 /**
  * \fn guesscomp()
@@ -23,27 +23,187 @@ int guesscomp(const void * a, const void * b)
 	return (fa > fb) - (fa < fb);
 }
 
+/**
+ * \fn rankcomp()
+ * \brief As \fn guesscomp() with equal distances kept in their original order, so the k best do not depend on how the guesses were sorted before
+ */
+static int rankcomp(const void * a, const void * b)
+{
+	const struct Guess* ga = (const struct Guess*)a;
+	const struct Guess* gb = (const struct Guess*)b;
+	if(ga->diff != gb->diff) {
+		return (ga->diff > gb->diff) - (ga->diff < gb->diff);
+	}
+	return (ga->order > gb->order) - (ga->order < gb->order);
+}
+
+/**
+ * \fn kbest_push()
+ * \brief Offers a distance to a bounded max-heap holding the @k smallest distances seen
+ * @heap The heap of at most @k distances, the largest at the root
+ * @size The amount of distances currently in @heap
+ *
+ * Once @heap is full its root is the k-th best distance, the cutoff used by \var ABANDON and \var LB.
+ */
+static void kbest_push(double* heap, int* size, int k, double diff)
+{
+	int i = 0;
+	if(*size < k) {
+		i = (*size)++;
+		while(i > 0 && heap[(i - 1) / 2] < diff) {
+			heap[i] = heap[(i - 1) / 2];
+			i = (i - 1) / 2;
+		}
+		heap[i] = diff;
+		return;
+	}
+	if(diff >= heap[0]) {
+		return;
+	}
+	for(;;) {
+		int c = 2 * i + 1;
+		if(c >= k) {
+			break;
+		}
+		if(c + 1 < k && heap[c + 1] > heap[c]) {
+			c++;
+		}
+		if(heap[c] <= diff) {
+			break;
+		}
+		heap[i] = heap[c];
+		i = c;
+	}
+	heap[i] = diff;
+}
+
+/**
+ * \fn diagonal_estimate()
+ * \brief A cheap lock-step distance between the test and a prototype, used by \var ORDER to compare the most likely prototypes first
+ */
+static double diagonal_estimate(const struct Test_Features* test, struct Phoneme* phoneme, int p)
+{
+	int trunc = floor((glbl_banks) * glbl_test_trunc);
+	int frames = min(test->mfcc_length, phoneme->size[p]) / trunc;
+	double estimate = 0;
+	for(int i = 1; i < frames; i++) {
+		estimate += frame_distance(&test->mfcc[i * trunc], &phoneme->mfcc[p][i * trunc], trunc, DIST_L1);
+	}
+	return estimate;
+}
+
+/**
+ * \fn verify_guesses()
+ * \brief Scores the guesses \fn score_guesses() skipped in full, counting the test as mismatched if the @k best change
+ * @gs The guesses as \fn score_guesses() left them, DBL_MAX for those skipped
+ */
+static void verify_guesses(const struct Test_Features* test, const struct Guess* gs, int to_test, int k, struct Score_Context* ctx)
+{
+	struct Guess* bounded = (struct Guess*)malloc(sizeof(struct Guess) * to_test);
+	struct Guess* exact = (struct Guess*)malloc(sizeof(struct Guess) * to_test);
+	if(bounded == NULL || exact == NULL) {
+		printf("Failed to malloc the guesses verifying the bounds\n");
+		free(bounded);
+		free(exact);
+		return;
+	}
+	for(int i = 0; i < to_test; i++) {
+		bounded[i] = gs[i];
+		exact[i] = gs[i];
+		if(gs[i].diff == DBL_MAX) {
+			exact[i].diff = dtw_frame_result_bounded(test, gs[i].ref, gs[i].ref_indx, glbl_dtw_window, ctx, DBL_MAX);
+		}
+	}
+	qsort(bounded, to_test, sizeof(struct Guess), rankcomp);
+	qsort(exact, to_test, sizeof(struct Guess), rankcomp);
+	for(int i = 0; i < k && i < to_test; i++) {
+		if(bounded[i].order != exact[i].order || bounded[i].diff != exact[i].diff) {
+			printf("The bounds changed the %d best guess, %s at %f instead of %s at %f\n", i + 1,
+			       bounded[i].ref->index->name, bounded[i].diff, exact[i].ref->index->name, exact[i].diff);
+			ctx->mismatched++;
+			break;
+		}
+	}
+	free(bounded);
+	free(exact);
+}
+
+/**
+ * \fn score_guesses()
+ * \brief Scores each guess in @gs with DTW, skipping those which can no longer be among the @k best
+ * @gs The guesses, with their phoneme and reference index set
+ *
+ * With \var LB the cascade \fn lb_kim(), \fn lb_keogh() and DTW is run in order of cost against
+ * the k-th best distance so far, and with \var ABANDON DTW itself stops once it passes it.
+ * Skipped guesses are given DBL_MAX and so are never voted for. Every guess is counted as used, scored
+ * or not, so the counts match scoring them all, and \var VERIFY checks the k best against doing so.
+ */
+static void score_guesses(const struct Test_Features* test, struct Guess* gs, int to_test, int k, struct Score_Context* ctx)
+{
+	int trunc = floor((glbl_banks) * glbl_test_trunc);
+
+	for(int i = 0; i < to_test; i++) {
+		gs[i].order = i;
+	}
+	// Comparing the closest estimates first tightens the cutoff sooner
+	if((ABANDON || LB) && ORDER) {
+		for(int i = 0; i < to_test; i++) {
+			gs[i].diff = diagonal_estimate(test, gs[i].ref, gs[i].ref_indx);
+		}
+		qsort(gs, to_test, sizeof(struct Guess), rankcomp);
+	}
+
+	double* best = ((ABANDON || LB) && k > 0) ? (double*)malloc(sizeof(double) * k) : NULL;
+	int best_count = 0;
+	for(int i = 0; i < to_test; i++) {
+		struct Phoneme* ref = gs[i].ref;
+		int p = gs[i].ref_indx;
+		double cutoff = (best != NULL && best_count == k) ? best[0] : DBL_MAX;
+		ctx->used[ref->index->i][p]++;
+		// The bounds only hold against a prototype of the same length
+		if(LB && cutoff != DBL_MAX && ref->size[p] == test->mfcc_length) {
+			if(lb_kim(test, ref->mfcc[p], ref->env[p], trunc) > cutoff) {
+				ctx->lb_kim_pruned++;
+				gs[i].diff = DBL_MAX;
+				continue;
+			}
+			if(lb_keogh(test, ref->env[p], trunc, cutoff) > cutoff) {
+				ctx->lb_keogh_pruned++;
+				gs[i].diff = DBL_MAX;
+				continue;
+			}
+		}
+		gs[i].diff = dtw_frame_result_bounded(test, ref, p, glbl_dtw_window, ctx, ABANDON ? cutoff : DBL_MAX);
+		if(best != NULL) {
+			kbest_push(best, &best_count, k, gs[i].diff);
+		}
+	}
+	free(best);
+	if(VERIFY && (ABANDON || LB)) {
+		verify_guesses(test, gs, to_test, k, ctx);
+	}
+}
+
 /** 
  * \fn knn_mfccs()
  * \brief The base KNN function, used to find the final result
  * @test The data which contains the test MFCC, and frame-by-frame zero cross and short time energy arrays
- * @test_length The length of the MFCC as a 1D array
  * @k The amount of guess to be considered in KNN
  * @ph The test phonemes string used only for keeping track of correct and incorrect guesses
  * @prev_ph Used in the \file gram.c grammar functions
  */
-int knn_mfccs(float** test, int test_length, int k, char* ph)
+int knn_mfccs(const struct Test_Features* test, int k, char* ph, struct Score_Context* ctx)
 {
+	int test_length = test->length;
 	time_t started = time(NULL);
 	int j = 1;
 	while(strcmp(p_codes[j], "\0") != 0) {
 		j++;	
 	}
-	num_ph = j;
 	int grp = -1;
 	int start = 0, end = 0;
 	if(GROUP) {
-		grp = knn_mfccs_group(test, test_length, k, ph);
+		grp = knn_mfccs_group(test, k, ph, ctx);
 		if      (grp == 0) { start = 1;  end = 7;       }
 		else if (grp == 1) { start = 7;  end = 9;       }
 		else if (grp == 2) { start = 9;  end = 16;      }
@@ -85,7 +245,6 @@ int knn_mfccs(float** test, int test_length, int k, char* ph)
 				printf("Iterating removed all sequences for :: %s :: Ending tests\n", phones[i]->index->name);
 				exit(-1);
 			}
-			gs[l].diff = dtw_frame_result(test[0], test_length, phones[i], indx, glbl_dtw_window);
 			gs[l].guess = i;
 			gs[l].ref_indx = indx;
 			gs[l].ref = phones[i];
@@ -93,7 +252,6 @@ int knn_mfccs(float** test, int test_length, int k, char* ph)
 		} else {
 			for(int j = 0; j < phones[i]->size_count; j++) {
 				if(phones[i]->size[j] != 0) {
-					gs[l].diff = dtw_frame_result(test[0], test_length, phones[i], j, glbl_dtw_window);
 					gs[l].guess = i;
 					gs[l].ref_indx = j;
 					gs[l].ref = phones[i];
@@ -102,25 +260,28 @@ int knn_mfccs(float** test, int test_length, int k, char* ph)
 			}
 		}
 	}
-		
-	qsort(gs, to_test, sizeof(struct Guess), guesscomp);
-	int* modes = (int*)calloc(num_ph, sizeof(int));
-	
-	for(int i = 0; i < num_ph; i++) {
-		modes[i] = 0;
-	}
+	// Removed sequences are counted in n but never filled in
+	to_test = l;
 	if(k >= to_test) {
 		k = floor(to_test / 3);
 		if(k <= 0) {
 			k = 1;
 		}
 	}
+	score_guesses(test, gs, to_test, k, ctx);
+		
+	qsort(gs, to_test, sizeof(struct Guess), rankcomp);
+	int* modes = (int*)calloc(num_ph, sizeof(int));
+	
+	for(int i = 0; i < num_ph; i++) {
+		modes[i] = 0;
+	}
 	for(int i = 0; i < k; i++) {
 		modes[gs[i].guess]++;
 		if(strcmp(gs[i].ref->index->name, ph) != 0) {
-			gs[i].ref->error[gs[i].ref_indx]++;
+			ctx->error[gs[i].guess][gs[i].ref_indx]++;
 		} else {
-			gs[i].ref->correct[gs[i].ref_indx]++;
+			ctx->correct[gs[i].guess][gs[i].ref_indx]++;
 		}
 	}
 	int most = 0, final = 0;
@@ -134,16 +295,15 @@ int knn_mfccs(float** test, int test_length, int k, char* ph)
 	free(modes);
 	result = final;
 	time_t ended = time(NULL);
-	total_test_time += (ended - started);
-	total_dtw_tests++;
+	ctx->total_test_time += (ended - started);
+	ctx->total_dtw_tests++;
 	return result;
 }
 
 /** 
  * \fn knn_mfccs_size()
  * \brief The base KNN function, used to find the final result
- * @total_test The data which contains the test MFCC, and frame-by-frame zero cross and short time energy arrays
- * @test_length The length of the MFCC as a 1D array
+ * @test The data which contains the test MFCC, and frame-by-frame zero cross and short time energy arrays
  * @k The amount of guess to be considered in KNN
  * @ph The test phonemes string used only for keeping track of correct and incorrect guesses
  * @prev_ph Used in the \file gram.c grammar functions
@@ -151,16 +311,15 @@ int knn_mfccs(float** test, int test_length, int k, char* ph)
  *
  * Unlike \fn knn_mfccs() this version only compares those of the same size
  */
-int knn_mfccs_size(float** total_test, int test_length, int k, char* ph)
+int knn_mfccs_size(const struct Test_Features* test, int k, char* ph, struct Score_Context* ctx)
 {
 	time_t started = time(NULL);
-	float* test = total_test[0];
+	int test_length = test->length;
 	int j = 1;
 	//int trunc = floor(glbl_banks * glbl_test_trunc);
 	while(strcmp(p_codes[j], "\0") != 0) {
 		j++;	
 	}
-	num_ph = j;
 	
 	int grp = -1;
 	int start = 0, end = 0;
@@ -207,7 +366,7 @@ int knn_mfccs_size(float** total_test, int test_length, int k, char* ph)
 		/* 	} */
 		/* } */
 
-		grp = knn_mfccs_group(total_test, test_length, k, ph);
+		grp = knn_mfccs_group(test, k, ph, ctx);
 
 		// free(ste_group);
 		// free(zc_group);
@@ -227,7 +386,7 @@ int knn_mfccs_size(float** total_test, int test_length, int k, char* ph)
 		else               { return (num_ph - 1);       } // return num_ph - 1?
 	} else if (VOICED && !(GROUP)) {
 		ZC = 1;
-		grp = knn_mfccs_voice(total_test, test_length, k, ph);
+		grp = knn_mfccs_voice(test, k, ph, ctx);
 		ZC = 0;
 		if(grp == -1) {
 			printf("Whoops... \n");
@@ -244,13 +403,7 @@ int knn_mfccs_size(float** total_test, int test_length, int k, char* ph)
 	int result = 0, n = 0, to_test = 0;
 	int mfcc_length = mfcc_size(test_length);
 	int n_ph = (end - start);
-	for(int i = start; i < end; i++) {
-		for(int j = 0; j < phones[i]->size_count; j++) {
-			if(phones[i]->size[j] != 0 && mfcc_length == phones[i]->size[j]) {
-				n++;
-			}
-		}
-	}
+	const struct Proto_Ref* same = prototypes_of_size(mfcc_length, start, end, &n);
 	int NONE = 0;
 	if(n == 0) {
 		n = (n_ph);
@@ -261,42 +414,25 @@ int knn_mfccs_size(float** total_test, int test_length, int k, char* ph)
 	struct Guess* gs = (struct Guess*)malloc(sizeof(struct Guess) * to_test);
 	int l = 0;
 	
-	for(int i = start; i < end; i++) {
-		if(NONE == 1) {
-			int sml = INT_MAX, indx = 0;
-			for(int j = 0; j < phones[i]->size_count; j++) {
-				if(abs(mfcc_length - phones[i]->size[j]) < sml && phones[i]->size[j] != 0) {
-					sml = abs(mfcc_length - phones[i]->size[j]);
-					indx = j;
-				}
-			}
-			if(phones[i]->size[indx] == 0) {
+	if(NONE == 1) {
+		for(int i = start; i < end; i++) {
+			int indx = nearest_prototype(i, mfcc_length, 0);
+			if(indx < 0) {
 				printf("Iterating removed all sequences for :: %s :: Ending tests\n", phones[i]->index->name);
 				exit(-1);
 			}
-			gs[l].diff = dtw_frame_result(test, test_length, phones[i], indx, glbl_dtw_window);
 			gs[l].guess = i;
 			gs[l].ref_indx = indx;
 			gs[l].ref = phones[i];
 			l++;
-		} else {
-			for(int j = 0; j < phones[i]->size_count; j++) {
-				if(phones[i]->size[j] != 0 && mfcc_length == phones[i]->size[j]) {
-					gs[l].diff = dtw_frame_result(test, test_length, phones[i], j, glbl_dtw_window);
-					gs[l].guess = i;
-					gs[l].ref_indx = j;
-					gs[l].ref = phones[i];
-					l++;
-				}
-			}
 		}
-	}
-		
-	qsort(gs, to_test, sizeof(struct Guess), guesscomp);
-	int* modes = (int*)calloc(num_ph, sizeof(int));
-	
-	for(int i = 0; i < num_ph; i++) {
-		modes[i] = 0;
+	} else {
+		for(int m = 0; m < n; m++) {
+			gs[l].guess = same[m].phoneme;
+			gs[l].ref_indx = same[m].ref;
+			gs[l].ref = phones[same[m].phoneme];
+			l++;
+		}
 	}
 	if(k >= to_test) {
 		k = floor(to_test / 3);
@@ -304,14 +440,23 @@ int knn_mfccs_size(float** total_test, int test_length, int k, char* ph)
 			k = 1;
 		}
 	}
+
+	score_guesses(test, gs, to_test, k, ctx);
+		
+	qsort(gs, to_test, sizeof(struct Guess), rankcomp);
+	int* modes = (int*)calloc(num_ph, sizeof(int));
+	
+	for(int i = 0; i < num_ph; i++) {
+		modes[i] = 0;
+	}
 	for(int i = 0; i < k; i++) {
 		modes[gs[i].guess]++;
 		if(ph == NULL)
 			continue;
 		if(strcmp(gs[i].ref->index->name, ph) != 0) {
-			gs[i].ref->error[gs[i].ref_indx]++;
+			ctx->error[gs[i].guess][gs[i].ref_indx]++;
 		} else {
-			gs[i].ref->correct[gs[i].ref_indx]++;
+			ctx->correct[gs[i].guess][gs[i].ref_indx]++;
 		}
 	}
 	int most = 0, final = 0;
@@ -328,8 +473,8 @@ int knn_mfccs_size(float** total_test, int test_length, int k, char* ph)
 	
 	
 	time_t ended = time(NULL);
-	total_test_time += (ended - started);
-	total_dtw_tests++;
+	ctx->total_test_time += (ended - started);
+	ctx->total_dtw_tests++;
 	return result;
 }
 
@@ -337,7 +482,6 @@ int knn_mfccs_size(float** total_test, int test_length, int k, char* ph)
  * \fn knn_mfccs_group()
  * \brief The KNN function used to determine the phoneme group
  * @test The data which contains the test MFCC, and frame-by-frame zero cross and short time energy arrays
- * @test_length The length of the MFCC as a 1D array
  * @k The amount of guess to be considered in KNN
  * @ph The test phonemes string used only for keeping track of correct and incorrect guesses
  * @prev_ph Used in the \file gram.c grammar functions
@@ -345,14 +489,14 @@ int knn_mfccs_size(float** total_test, int test_length, int k, char* ph)
  *
  * This function decides which group a phoneme is in i.e. stop, nasal, etc. and the result is to be handled in another function
  */
-int knn_mfccs_group(float** test, int test_length, int k, char* ph)
+int knn_mfccs_group(const struct Test_Features* test, int k, char* ph, struct Score_Context* ctx)
 {
+	int test_length = test->length;
 	k = glbl_group_k;
 	int j = 1;
 	while(strcmp(p_codes[j], "\0") != 0) {
 		j++;	
 	}
-	num_ph = j;
 
 	int grp = -1;
 	int start = 0, end = 0;
@@ -376,7 +520,7 @@ int knn_mfccs_group(float** test, int test_length, int k, char* ph)
 		/* free(ste_group); */
 		/* free(zc_group); */
 		ZC = 1;
-		grp = knn_mfccs_voice(test, test_length, k, ph);
+		grp = knn_mfccs_voice(test, k, ph, ctx);
 		ZC = 0;
 		if(grp == -1) {
 			printf("Whoops... \n");
@@ -393,15 +537,7 @@ int knn_mfccs_group(float** test, int test_length, int k, char* ph)
 	int result = 0, n = 0, to_test = 0;
 	int mfcc_length = mfcc_size(test_length);
 	int n_ph = (end - start);
-	for(int i = start; i < end; i++) {
-		for(int j = 0; j < phones[i]->size_count; j++) {
-			if(mfcc_length == phones[i]->size[j]) {
-				n++;
-				// break;
-			}
-		}
-
-	}
+	const struct Proto_Ref* same = prototypes_of_size(mfcc_length, start, end, &n);
 	if(n < (n_ph)) {
 		n = (n_ph);
 	}
@@ -409,37 +545,28 @@ int knn_mfccs_group(float** test, int test_length, int k, char* ph)
 	struct Guess* gs = (struct Guess*)malloc(sizeof(struct Guess) * to_test);
 	int l = 0;
 	
-	for(int i = start; i < end; i++) {
-		if(to_test == n_ph) {
-			int sml = INT_MAX, indx = 0;
-			for(int j = 0; j < phones[i]->size_count; j++) {
-				if(abs(mfcc_length - phones[i]->size[j]) < sml && phones[i]->size[j] != 0) {
-					sml = abs(mfcc_length - phones[i]->size[j]);
-					indx = j;
-				}
-			}
+	if(to_test == n_ph) {
+		for(int i = start; i < end; i++) {
+			int indx = max(nearest_prototype(i, mfcc_length, 0), 0);
 			if(STE || ZC || DELTA || DELTA_DELTA) {
-				gs[l].diff = dtw_frame_result_group(test, test_length, phones[i], indx, glbl_dtw_window);
+				gs[l].diff = dtw_frame_result_group(test, phones[i], indx, glbl_dtw_window, ctx);
 			} else {
-				gs[l].diff = dtw_frame_result(test[0], test_length, phones[i], indx, glbl_dtw_window);
+				gs[l].diff = dtw_frame_result(test, phones[i], indx, glbl_dtw_window, ctx);
 			}
 			gs[l].guess = i;
 			l++;
-		} else {
-			for(int j = 0; j < phones[i]->size_count; j++) {
-				if(mfcc_length == phones[i]->size[j]) {
-					if(STE || ZC || DELTA || DELTA_DELTA) {
-						gs[l].diff = dtw_frame_result_group(test, test_length, phones[i], j, glbl_dtw_window);
-					} else {
-						gs[l].diff = dtw_frame_result(test[0], test_length, phones[i], j, glbl_dtw_window);
-					}
-					gs[l].guess = i;
-					l++;
-					// break;
-				}
+		}
+	} else {
+		for(int m = 0; m < n; m++) {
+			int i = same[m].phoneme;
+			if(STE || ZC || DELTA || DELTA_DELTA) {
+				gs[l].diff = dtw_frame_result_group(test, phones[i], same[m].ref, glbl_dtw_window, ctx);
+			} else {
+				gs[l].diff = dtw_frame_result(test, phones[i], same[m].ref, glbl_dtw_window, ctx);
 			}
+			gs[l].guess = i;
+			l++;
 		}
-
 	}
 	// {"STOP", "AFRI", "FRIC", "NASL", "SEMV", "VOWL", "OTHR"};
 
@@ -471,7 +598,7 @@ int knn_mfccs_group(float** test, int test_length, int k, char* ph)
 			}
 		}
 
-		group_matrix[phones[indx]->index->group_i][final]++;
+		ctx->group_matrix[phones[indx]->index->group_i][final]++;
 	}
 	
 	free(gs);
@@ -484,7 +611,6 @@ int knn_mfccs_group(float** test, int test_length, int k, char* ph)
  * \fn knn_mfccs_voice()
  * \brief The KNN function used to determine the phoneme voice type
  * @test The data which contains the test MFCC, and frame-by-frame zero cross and short time energy arrays
- * @test_length The length of the MFCC as a 1D array
  * @k The amount of guess to be considered in KNN
  * @ph The test phonemes string used only for keeping track of correct and incorrect guesses
  * @prev_ph Used in the \file gram.c grammar functions
@@ -492,25 +618,17 @@ int knn_mfccs_group(float** test, int test_length, int k, char* ph)
  *
  * This function decides whether a test sequence is voiced, unvoiced or silence and the result is to be handled in another function
  */
-int knn_mfccs_voice(float** test, int test_length, int k, char* ph)
+int knn_mfccs_voice(const struct Test_Features* test, int k, char* ph, struct Score_Context* ctx)
 {
+	int test_length = test->length;
 	k = glbl_voice_k;
 	int j = 1;
 	while(strcmp(p_codes[j], "\0") != 0) {
 		j++;	
 	}
-	num_ph = j;
 	int result = 0, n = 0, to_test = 0;
 	int mfcc_length = mfcc_size(test_length);
-	for(int i = 1; i < num_ph; i++) {
-		for(int j = 0; j < phones[i]->size_count; j++) {
-			if(mfcc_length == phones[i]->size[j]) {
-				n++;
-				// break;
-			}
-		}
-
-	}
+	const struct Proto_Ref* same = prototypes_of_size(mfcc_length, 1, num_ph, &n);
 	if(n < (num_ph - 1)) {
 		n = (num_ph - 1);
 	}
@@ -518,37 +636,28 @@ int knn_mfccs_voice(float** test, int test_length, int k, char* ph)
 	struct Guess* gs = (struct Guess*)malloc(sizeof(struct Guess) * to_test);
 	int l = 0;
 	
-	for(int i = 1; i < num_ph; i++) {
-		if(to_test == (num_ph - 1)) {
-			int sml = INT_MAX, indx = 0;
-			for(int j = 0; j < phones[i]->size_count; j++) {
-				if(abs(mfcc_length - phones[i]->size[j]) < sml && phones[i]->size[j] != 0) {
-					sml = abs(mfcc_length - phones[i]->size[j]);
-					indx = j;
-				}
-			}
+	if(to_test == (num_ph - 1)) {
+		for(int i = 1; i < num_ph; i++) {
+			int indx = max(nearest_prototype(i, mfcc_length, 0), 0);
 			if(STE || ZC || DELTA || DELTA_DELTA) {
-				gs[l].diff = dtw_frame_result_group(test, test_length, phones[i], indx, glbl_dtw_window);
+				gs[l].diff = dtw_frame_result_group(test, phones[i], indx, glbl_dtw_window, ctx);
 			} else {
-				gs[l].diff = dtw_frame_result(test[0], test_length, phones[i], indx, glbl_dtw_window);
+				gs[l].diff = dtw_frame_result(test, phones[i], indx, glbl_dtw_window, ctx);
 			}
 			gs[l].guess = i;
 			l++;
-		} else {
-			for(int j = 0; j < phones[i]->size_count; j++) {
-				if(mfcc_length == phones[i]->size[j]) {
-					if(STE || ZC || DELTA || DELTA_DELTA) {
-						gs[l].diff = dtw_frame_result_group(test, test_length, phones[i], j, glbl_dtw_window);
-					} else {
-						gs[l].diff = dtw_frame_result(test[0], test_length, phones[i], j, glbl_dtw_window);
-					}
-					gs[l].guess = i;
-					l++;
-					// break;
-				}
+		}
+	} else {
+		for(int m = 0; m < n; m++) {
+			int i = same[m].phoneme;
+			if(STE || ZC || DELTA || DELTA_DELTA) {
+				gs[l].diff = dtw_frame_result_group(test, phones[i], same[m].ref, glbl_dtw_window, ctx);
+			} else {
+				gs[l].diff = dtw_frame_result(test, phones[i], same[m].ref, glbl_dtw_window, ctx);
 			}
+			gs[l].guess = i;
+			l++;
 		}
-
 	}
 	// {"STOP", "AFRI", "FRIC", "NASL", "SEMV", "VOWL", "OTHR"};
 
@@ -580,7 +689,7 @@ int knn_mfccs_voice(float** test, int test_length, int k, char* ph)
 			}
 		}
 	
-		voice_matrix[phones[indx]->index->voice][final]++;
+		ctx->voice_matrix[phones[indx]->index->voice][final]++;
 	}
 	
 	free(gs);
@@ -589,14 +698,13 @@ int knn_mfccs_voice(float** test, int test_length, int k, char* ph)
 	return result;
 }
 
-int knn_mfccs_voice_time(float* test, int test_length, int k, char* ph)
+int knn_mfccs_voice_time(float* test, int test_length, int k, char* ph, struct Score_Context* ctx)
 {
 	k = glbl_group_k;
 	int j = 1;
 	while(strcmp(p_codes[j], "\0") != 0) {
 		j++;	
 	}
-	num_ph = j;
 	int result = 0, n = 0, to_test = 0;
 	int mfcc_length = test_length;
 	for(int i = 1; i < num_ph; i++) {
@@ -624,13 +732,13 @@ int knn_mfccs_voice_time(float* test, int test_length, int k, char* ph)
 					indx = j;
 				}
 			}
-			gs[l].diff = dtw_frame_result_group_time(test, test_length, phones[i], indx, glbl_dtw_window);
+			gs[l].diff = dtw_frame_result_group_time(test, test_length, phones[i], indx, glbl_dtw_window, ctx);
 			gs[l].guess = i;
 			l++;
 		} else {
 			for(int j = 0; j < phones[i]->raw_count; j++) {
 				// if(mfcc_length == phones[i]->raw_sizes[j]) {
-					gs[l].diff = dtw_frame_result_group_time(test, test_length, phones[i], j, glbl_dtw_window);
+					gs[l].diff = dtw_frame_result_group_time(test, test_length, phones[i], j, glbl_dtw_window, ctx);
 					gs[l].guess = i;
 					l++;
 					// break;
@@ -669,7 +777,7 @@ int knn_mfccs_voice_time(float* test, int test_length, int k, char* ph)
 			}
 		}
 	
-		voice_matrix[phones[indx]->index->voice][final]++;
+		ctx->voice_matrix[phones[indx]->index->voice][final]++;
 	}
 	
 	free(gs);
@@ -691,14 +799,13 @@ int knn_mfccs_voice_time(float* test, int test_length, int k, char* ph)
  * This function decides whether a test sequence is voiced, unvoiced or silence and the result is to be handled in another function
  * Unlike \fn knn_mfccs_group() this function uses a time domain signal only to find out the group.
  */
-int knn_mfccs_group_time(float* test, int test_length, int k, char* ph)
+int knn_mfccs_group_time(float* test, int test_length, int k, char* ph, struct Score_Context* ctx)
 {
 	k = glbl_group_k;
 	int j = 1;
 	while(strcmp(p_codes[j], "\0") != 0) {
 		j++;	
 	}
-	num_ph = j;
 	int result = 0, n = 0, to_test = 0;
 	int mfcc_length = test_length;
 	for(int i = 1; i < num_ph; i++) {
@@ -726,13 +833,13 @@ int knn_mfccs_group_time(float* test, int test_length, int k, char* ph)
 					indx = j;
 				}
 			}
-			gs[l].diff = dtw_frame_result_group_time(test, test_length, phones[i], indx, glbl_dtw_window);
+			gs[l].diff = dtw_frame_result_group_time(test, test_length, phones[i], indx, glbl_dtw_window, ctx);
 			gs[l].guess = i;
 			l++;
 		} else {
 			for(int j = 0; j < phones[i]->raw_count; j++) {
 				if(mfcc_length == phones[i]->raw_sizes[j]) {
-					gs[l].diff = dtw_frame_result_group_time(test, test_length, phones[i], j, glbl_dtw_window);
+					gs[l].diff = dtw_frame_result_group_time(test, test_length, phones[i], j, glbl_dtw_window, ctx);
 					gs[l].guess = i;
 					l++;
 					// break;
@@ -770,7 +877,7 @@ int knn_mfccs_group_time(float* test, int test_length, int k, char* ph)
 			}
 		}
 
-		group_matrix[phones[indx]->index->group_i][final]++;
+		ctx->group_matrix[phones[indx]->index->group_i][final]++;
 	}
 	
 	free(gs);
@@ -792,7 +899,7 @@ int knn_mfccs_group_time(float* test, int test_length, int k, char* ph)
  * This function decides whether a test sequence is voiced, unvoiced or silence and the result is to be handled in another function.
  * Unlike \fn knn_mfccs_voice() this function uses a time domain signal only to find out the voice type.
  */
-int k_means(float* test, int test_length, int k)
+int k_means(const struct Test_Features* test, int k, struct Score_Context* ctx)
 {
 	time_t started = time(NULL);
 
@@ -800,7 +907,6 @@ int k_means(float* test, int test_length, int k)
 	while(strcmp(p_codes[j], "\0") != 0) {
 		j++;	
 	}
-	num_ph = j;
 	int result = 0, n = 0, to_test = 0;
 	// int trunc = floor(glbl_banks * glbl_test_trunc);
 	// int mfcc_len = mfcc_size(test_length);
@@ -815,7 +921,7 @@ int k_means(float* test, int test_length, int k)
 	}
 	int l = 0;
 	for(int i = 1; i < num_ph; i++) {
-		gs[l].diff = dtw_clust_result(test, test_length, phones[i], 0, 0, glbl_dtw_window);
+		gs[l].diff = dtw_clust_result(test, phones[i], 0, 0, glbl_dtw_window, ctx);
 		gs[l].guess = i;
 		l++;
 	}
@@ -846,8 +952,8 @@ int k_means(float* test, int test_length, int k)
 	free(gs);
 	free(modes);
 	time_t ended = time(NULL);
-	total_test_time += (ended - started);
-	total_dtw_tests++;
+	ctx->total_test_time += (ended - started);
+	ctx->total_dtw_tests++;
 	result = final;
 	return result;
 }
@@ -12,22 +12,24 @@
  * @guess index guessed, can be the phoneme, group or voice
  * @diff the difference result used for sorting
  * @ref_indx the MFCC index used to produce the result - used for storing the amount of correct and incorrect guesses for the MFCC
+ * @order the guess's position before any sorting, breaking ties in \fn rankcomp()
  */ 
 struct Guess {
 	int guess;
 	double diff;
 	int ref_indx;
+	int order;
 	struct Phoneme* ref;
 };
 
 #include "../Dynamic_Time_Warping/dtw.h"
 #include "cluster.h"
 
-int knn_mfccs(float** test, int test_length, int k, char* ph);
-int knn_mfccs_size(float** total_test, int test_length, int k, char* ph);
-int k_means(float* test, int test_length, int k);
+int knn_mfccs(const struct Test_Features* test, int k, char* ph, struct Score_Context* ctx);
+int knn_mfccs_size(const struct Test_Features* test, int k, char* ph, struct Score_Context* ctx);
+int k_means(const struct Test_Features* test, int k, struct Score_Context* ctx);
 int knn_mfccs_size_noref(float** test, int test_length, int k, char* ph);
-int knn_mfccs_voice_time(float* test, int test_length, int k, char* ph);
-int knn_mfccs_group_time(float* test, int test_length, int k, char* ph);
+int knn_mfccs_voice_time(float* test, int test_length, int k, char* ph, struct Score_Context* ctx);
+int knn_mfccs_group_time(float* test, int test_length, int k, char* ph, struct Score_Context* ctx);
 
 #endif
@@ -1,4 +1,4 @@
 #!/bin/bash
 
-    eval "gcc -O3 -g -std=c11 ./dtw.c ../Training/train.c ../Misc/realloc.c ../Testing/test.c ../Seperation/cross_rate.c  ../Seperation/ste.c ../Feature_Extraction/*.c ../Seperation/bounds.c ../Clustering/cluster.c ../Clustering/knn.c -D_XOPEN_SOURCE=600 -pthread -onan -o dtw.exe -lm;"
+    eval "gcc -O3 -g -std=c11 ./dtw.c ./distance.c ./lower_bound.c ./prototypes.c ./model.c ../Training/train.c ../Misc/realloc.c ../Misc/wav.c ../Misc/corpus.c ../Testing/test.c ../Seperation/cross_rate.c  ../Seperation/ste.c ../Feature_Extraction/*.c ../Seperation/bounds.c ../Seperation/feature_index.c ../Clustering/cluster.c ../Clustering/knn.c -D_XOPEN_SOURCE=600 -pthread -onan -o dtw.exe -lm;"
 
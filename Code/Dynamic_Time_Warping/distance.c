@@ -0,0 +1,160 @@
+/**
+ * @file   distance.c
+ * @brief  Scalar and vectorised frame distance kernels
+ *
+ * The SSE2 and AVX2 kernels are only built for x86. The widest kernel the CPU supports
+ * is picked at runtime by \fn distance_init(); until then, and on every other architecture,
+ * the scalar kernels are used. Frames whose length is not a multiple of the vector width
+ * finish with one extra vector over a zero padded copy of the tail.
+ */
+
+#include <string.h>
+#include <math.h>
+#include "distance.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define DIST_X86
+#include <immintrin.h>
+#endif
+
+static double l1_scalar(const float* a, const float* b, int n)
+{
+	double cost = 0;
+	for(int m = 0; m < n; m++) {
+		cost += fabs(a[m] - b[m]);
+	}
+	return cost;
+}
+
+static double sq_l2_scalar(const float* a, const float* b, int n)
+{
+	double cost = 0;
+	for(int m = 0; m < n; m++) {
+		double diff = a[m] - b[m];
+		cost += diff * diff;
+	}
+	return cost;
+}
+
+frame_kernel dist_kernels[2] = { l1_scalar, sq_l2_scalar };
+const char* dist_kernel_name = "scalar";
+
+#ifdef DIST_X86
+
+#define SSE_WIDTH 4
+#define AVX_WIDTH 8
+
+__attribute__((target("sse2")))
+static inline void sse2_accumulate(__m128 diff, __m128d* lo, __m128d* hi, int squared)
+{
+	__m128d d_lo = _mm_cvtps_pd(diff);
+	__m128d d_hi = _mm_cvtps_pd(_mm_movehl_ps(diff, diff));
+	if(squared) {
+		d_lo = _mm_mul_pd(d_lo, d_lo);
+		d_hi = _mm_mul_pd(d_hi, d_hi);
+	} else {
+		__m128d sign = _mm_set1_pd(-0.0);
+		d_lo = _mm_andnot_pd(sign, d_lo);
+		d_hi = _mm_andnot_pd(sign, d_hi);
+	}
+	*lo = _mm_add_pd(*lo, d_lo);
+	*hi = _mm_add_pd(*hi, d_hi);
+}
+
+__attribute__((target("sse2")))
+static inline double sse2_distance(const float* a, const float* b, int n, int squared)
+{
+	__m128d lo = _mm_setzero_pd(), hi = _mm_setzero_pd();
+	int m = 0;
+	for(; m + SSE_WIDTH <= n; m += SSE_WIDTH) {
+		sse2_accumulate(_mm_sub_ps(_mm_loadu_ps(&a[m]), _mm_loadu_ps(&b[m])), &lo, &hi, squared);
+	}
+	if(m < n) {
+		float pad_a[SSE_WIDTH] = {0}, pad_b[SSE_WIDTH] = {0};
+		memcpy(pad_a, &a[m], (n - m) * sizeof(float));
+		memcpy(pad_b, &b[m], (n - m) * sizeof(float));
+		sse2_accumulate(_mm_sub_ps(_mm_loadu_ps(pad_a), _mm_loadu_ps(pad_b)), &lo, &hi, squared);
+	}
+	lo = _mm_add_pd(lo, hi);
+	return _mm_cvtsd_f64(_mm_add_sd(lo, _mm_unpackhi_pd(lo, lo)));
+}
+
+static double l1_sse2(const float* a, const float* b, int n)
+{
+	return sse2_distance(a, b, n, 0);
+}
+
+static double sq_l2_sse2(const float* a, const float* b, int n)
+{
+	return sse2_distance(a, b, n, 1);
+}
+
+__attribute__((target("avx2")))
+static inline void avx2_accumulate(__m256 diff, __m256d* lo, __m256d* hi, int squared)
+{
+	__m256d d_lo = _mm256_cvtps_pd(_mm256_castps256_ps128(diff));
+	__m256d d_hi = _mm256_cvtps_pd(_mm256_extractf128_ps(diff, 1));
+	if(squared) {
+		*lo = _mm256_add_pd(*lo, _mm256_mul_pd(d_lo, d_lo));
+		*hi = _mm256_add_pd(*hi, _mm256_mul_pd(d_hi, d_hi));
+	} else {
+		__m256d sign = _mm256_set1_pd(-0.0);
+		*lo = _mm256_add_pd(*lo, _mm256_andnot_pd(sign, d_lo));
+		*hi = _mm256_add_pd(*hi, _mm256_andnot_pd(sign, d_hi));
+	}
+}
+
+__attribute__((target("avx2")))
+static inline double avx2_distance(const float* a, const float* b, int n, int squared)
+{
+	__m256d lo = _mm256_setzero_pd(), hi = _mm256_setzero_pd();
+	int m = 0;
+	for(; m + AVX_WIDTH <= n; m += AVX_WIDTH) {
+		avx2_accumulate(_mm256_sub_ps(_mm256_loadu_ps(&a[m]), _mm256_loadu_ps(&b[m])), &lo, &hi, squared);
+	}
+	if(m < n) {
+		float pad_a[AVX_WIDTH] = {0}, pad_b[AVX_WIDTH] = {0};
+		memcpy(pad_a, &a[m], (n - m) * sizeof(float));
+		memcpy(pad_b, &b[m], (n - m) * sizeof(float));
+		avx2_accumulate(_mm256_sub_ps(_mm256_loadu_ps(pad_a), _mm256_loadu_ps(pad_b)), &lo, &hi, squared);
+	}
+	lo = _mm256_add_pd(lo, hi);
+	__m128d sum = _mm_add_pd(_mm256_castpd256_pd128(lo), _mm256_extractf128_pd(lo, 1));
+	return _mm_cvtsd_f64(_mm_add_sd(sum, _mm_unpackhi_pd(sum, sum)));
+}
+
+__attribute__((target("avx2")))
+static double l1_avx2(const float* a, const float* b, int n)
+{
+	return avx2_distance(a, b, n, 0);
+}
+
+__attribute__((target("avx2")))
+static double sq_l2_avx2(const float* a, const float* b, int n)
+{
+	return avx2_distance(a, b, n, 1);
+}
+
+#endif
+
+/** 
+ * @brief Selects the widest distance kernels supported by the CPU
+ *
+ * The CPU features are read with cpuid through \fn __builtin_cpu_supports(), which also
+ * accounts for the OS saving the AVX registers. Should be called once before any threads are made.
+ */
+void distance_init(void)
+{
+#ifdef DIST_X86
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("avx2")) {
+		dist_kernels[DIST_L1] = l1_avx2;
+		dist_kernels[DIST_SQ_L2] = sq_l2_avx2;
+		dist_kernel_name = "avx2";
+	} else if(__builtin_cpu_supports("sse2")) {
+		dist_kernels[DIST_L1] = l1_sse2;
+		dist_kernels[DIST_SQ_L2] = sq_l2_sse2;
+		dist_kernel_name = "sse2";
+	}
+#endif
+}
@@ -0,0 +1,31 @@
+#ifndef DISTANCE_H
+#define DISTANCE_H
+
+/**
+ * @file   distance.h
+ * @brief  The frame distance kernels used in the innermost loop of DTW
+ *
+ * A frame is one row of an MFCC, i.e. trunc coefficients. The kernels take the
+ * difference of each coefficient in float, as the scalar loops always did, and
+ * accumulate the absolute or squared difference in double.
+ */
+
+#define DIST_L1    0  /* Sum of absolute differences */
+#define DIST_SQ_L2 1  /* Sum of squared differences */
+
+typedef double (*frame_kernel)(const float* a, const float* b, int n);
+
+extern frame_kernel dist_kernels[2];
+extern const char* dist_kernel_name;
+
+void distance_init(void);
+
+/** 
+ * @brief The distance between two frames of @param n coefficients using @param metric
+ */
+static inline double frame_distance(const float* a, const float* b, int n, int metric)
+{
+	return dist_kernels[metric](a, b, n);
+}
+
+#endif
@@ -13,6 +13,7 @@
 #define _GNU_SOURCE
 #define _USE_MATH_DEFINES
 
+#include <stdatomic.h>
 #include "dtw.h"
 
 int glbl_banks = 40;             /* The number of filter banks used for the MFCC */
@@ -31,6 +32,11 @@ int glbl_test_iter = 1;          /* The number of testing iterations to perform
 int glbl_group_k = 7;            /* The k value for group KNN */
 int glbl_voice_k = 7;            /* The k value for voiced KNN */
 int glbl_frame_limit = INT_MAX;  /* The MFCC frame limit */
+int glbl_test_threads = 1;       /* The number of workers classifying test files, see \fn test() */
+int glbl_mfcc_threads = 0;       /* The number of workers creating MFCCs with \var THREAD; 0 for one per online core */
+char* glbl_save_model = NULL;    /* The file the trained model is saved to, see \fn save_model() */
+char* glbl_load_model = NULL;    /* The file the model is loaded from instead of training, see \fn load_model() */
+int glbl_resample = RESAMPLE_INSERT; /* How signals are padded to whole windows, see \fn resize() */
 
 int glbl_zc_incr;                /* The zero cross threshold amount as an absolute difference */
 int glbl_ste_incr;               /* The short time energy threshold as a percentage difference */
@@ -45,9 +51,6 @@ int largest_index = 0;
 float largest_value = 0;         /* The largest value within the MFCCs. Used for output */
 float smallest_value = FLT_MAX;  /* The smallest value within the MFCCs. Used for output */
 
-short failed = 0;                /* Used to check if a DTW functions returns with an error */
-
-int DTW_ERROR;                   /* If there was an error performing DTW */
 int DELTA       = 0;             /* If delta coefficients should be used */
 int DELTA_DELTA = 0;             /* If delta-delta coefficients should be used */
 int NORM        = 0;             /* If the features should be normalised using min-max */
@@ -78,21 +81,31 @@ int SVM         = 0;             /* If SVM should be used for classification; th
 int EXPORT      = 0;             /* Exports the phonemes for use on the device */
 int THREAD      = 0;             /* Uses threads to create the MFCCs */
 int RAW         = 0;             /* Uses raw time domain signals for some classifications */
+int FUSED       = 0;             /* Combines the MFCC, delta and delta-delta costs in a single DTW pass */
+int ABANDON     = 0;             /* Abandons KNN comparisons which can no longer be among the k best */
+int ORDER       = 0;             /* Compares the cheapest estimated prototypes first when abandoning or pruning */
+int LB          = 0;             /* Prunes KNN prototypes with LB_Kim and LB_Keogh before DTW */
+int VERIFY      = 0;             /* Scores every KNN prototype in full as well, reporting where \var ABANDON or \var LB change the k best */
+int CORPUS      = 0;             /* Trains and tests from the datasets' packed corpora instead of their folders */
+int PACK_CORPUS = 0;             /* Packs the chosen training and testing datasets into corpora and exits */
+
+float glbl_delta_weight       = 1; /* The weight of the delta cost in a \var FUSED pass */
+float glbl_delta_delta_weight = 1; /* The weight of the delta-delta cost in a \var FUSED pass */
 
 int MALE   = 0;                  /* If the male data should be used for testing */
 int FEMALE = 0;                  /* If the female data should be used for testing */
 
 int trained   = 0;               /* The number of raw audio phoneme signals added to the model */
 int tested    = 0;               /* The number of tests performed */
-int mfcced    = 0;               /* The number of MFCCs creared */
+int mfcced    = 0;               /* The number of MFCCs created, summed from the MFCC workers */
 int clustered = 0;               /* The number of clusters created */
 int exported  = 0;               /* The number of MFCCs exported */
 
-double best_so_far = DBL_MAX;    /* The best so far score for DTW; not used during KNN */
-
 time_t avg_test_time          = 0; /* The average test time per phoneme */
 long double total_test_time   = 0; /* The sum of all test times during testing */
 long double total_dtw_tests   = 0; /* The total number of tests performed during testing */
+long abandoned = 0;              /* The number of DTW comparisons abandoned by \var ABANDON */
+long mismatched = 0;             /* The number of KNN tests whose k best \var VERIFY found changed by the bounds */
 
 time_t start = 0;                  /* The program start time; used for output */
 
@@ -118,8 +131,7 @@ int compar(const void* a, const void* b)
 }
 
 void export_phones(void);
-double** init_dtw_matrix(int signal_length, int phone_length, int w);
-void* create_mfcc(void* argv);
+void create_mfcc(int i, int j, struct Mfcc_Plan* plan);
 void* create_clusters(void* argv);
 void clean(void);
 void gen_aoo(void);
@@ -130,6 +142,7 @@ void export_for_jenks(char* p, int coef, float* data, int data_size);
 void read_jenks(void);
 void export_for_pca(void);
 void normal_all(void);
+void envelope_all(void);
 void std_test_output(void);
 void handle_argv(int argc, char* argv[]);
 void cluster(void);
@@ -159,6 +172,7 @@ int main(int argc, char* argv[])
 	
 	start = time(NULL);
 	handle_argv(argc, argv);
+	distance_init();
 	if((MALE + FEMALE + SPKR1 + SPKR1_NOSIL) > 1) {
 		printf("Only one dataset may be chosen.\n If you wish to train both please do not input either...\n");
 		exit(-1);
@@ -170,15 +184,37 @@ int main(int argc, char* argv[])
 	printf(":: INITIALISING PHONEMES  ::  %02d:%02d:%02d  ::\n", hour(difftime(time(NULL), start)), minu(difftime(time(NULL), start)), seco(difftime(time(NULL), start)));
 	dtw_init();
 
-	printf("::   TRAINING PHONEMES    ::  %02d:%02d:%02d  ::\n", hour(difftime(time(NULL), start)), minu(difftime(time(NULL), start)), seco(difftime(time(NULL), start)));
-	train();
-	printf("::         TRAINED        ::  %02d:%02d:%02d  ::  %05d\n", hour(difftime(time(NULL), start)), minu(difftime(time(NULL), start)), seco(difftime(time(NULL), start)), trained);
+	if(PACK_CORPUS) {
+		printf("::    PACKING CORPORA     ::  %02d:%02d:%02d  ::\n", hour(difftime(time(NULL), start)), minu(difftime(time(NULL), start)), seco(difftime(time(NULL), start)));
+		if(pack_corpus(train_folder()) != 0 || pack_corpus(test_folder(NULL)) != 0) {
+			exit(-1);
+		}
+		exit(0);
+	}
 
-	printf("::     CREATING MFCCS     ::  %02d:%02d:%02d  ::\n", hour(difftime(time(NULL), start)), minu(difftime(time(NULL), start)), seco(difftime(time(NULL), start)));
-	if(THREAD) {
-		threaded_mfccs();
+	if(glbl_load_model != NULL) {
+		printf("::     LOADING MODEL      ::  %02d:%02d:%02d  ::  %s\n", hour(difftime(time(NULL), start)), minu(difftime(time(NULL), start)), seco(difftime(time(NULL), start)), glbl_load_model);
+		if(load_model(glbl_load_model) != 0) {
+			printf("Failed to load the model, exiting...\n");
+			exit(-1);
+		}
+		printf("::         LOADED         ::  %02d:%02d:%02d  ::  %05d\n", hour(difftime(time(NULL), start)), minu(difftime(time(NULL), start)), seco(difftime(time(NULL), start)), trained);
 	} else {
-		non_threaded_mfccs();
+		printf("::   TRAINING PHONEMES    ::  %02d:%02d:%02d  ::\n", hour(difftime(time(NULL), start)), minu(difftime(time(NULL), start)), seco(difftime(time(NULL), start)));
+		train();
+		printf("::         TRAINED        ::  %02d:%02d:%02d  ::  %05d\n", hour(difftime(time(NULL), start)), minu(difftime(time(NULL), start)), seco(difftime(time(NULL), start)), trained);
+
+		printf("::     CREATING MFCCS     ::  %02d:%02d:%02d  ::\n", hour(difftime(time(NULL), start)), minu(difftime(time(NULL), start)), seco(difftime(time(NULL), start)));
+		if(THREAD) {
+			threaded_mfccs();
+		} else {
+			non_threaded_mfccs();
+		}
+	}
+	if(glbl_save_model != NULL) {
+		if(save_model(glbl_save_model) == 0) {
+			printf("::      SAVED MODEL       ::  %02d:%02d:%02d  ::  %s\n", hour(difftime(time(NULL), start)), minu(difftime(time(NULL), start)), seco(difftime(time(NULL), start)), glbl_save_model);
+		}
 	}
 
 	
@@ -208,6 +244,12 @@ int main(int argc, char* argv[])
 		normal_all();
 		printf("::    NORMALISING DONE    ::  %02d:%02d:%02d\n", hour(difftime(time(NULL), start)), minu(difftime(time(NULL), start)), seco(difftime(time(NULL), start)));
 	}
+
+	if(LB) {
+		envelope_all();
+	}
+
+	store_prototypes();
 	
 	printf("::    CREATED CLUSTERS    ::  %02d:%02d:%02d  ::  %05d\n", hour(difftime(time(NULL), start)), minu(difftime(time(NULL), start)), seco(difftime(time(NULL), start)), clustered);
 
@@ -227,9 +269,11 @@ int main(int argc, char* argv[])
 				if((phones[i]->correct[j] + phones[i]->error[j]) > 0.0 && phones[i]->size[j] != 0) {
 					float per = phones[i]->correct[j] / (phones[i]->correct[j] + phones[i]->error[j]);
 					if(per < 0.10F && phones[i]->reduced_count > 5 && phones[i]->size != 0) {
-						phones[i]->size[j] = 0;
+						remove_prototype(i, j);
 						phones[i]->reduced_count--;
-						free(phones[i]->mfcc[j]);
+						if(LB) {
+							free_envelope(phones[i]->env[j]);
+						}
 					}
 				}
 			}
@@ -354,21 +398,14 @@ void* create_clusters(void* argv)
 }
 
 /** 
- * \brief Creates all MFCCs for a given phoneme
- * 
- * @param argv The phoneme index to create MFCCs for
+ * \brief Allocates the MFCC, feature and accuracy arrays of a phoneme
  * 
- * @return Not used
+ * @param i The phoneme index
  *
- * Creates all MFCCs from all raw data signals for the phoneme index provided.
+ * Run for every phoneme before any \fn create_mfcc() task, as the tasks of a phoneme fill these arrays in any order.
  */
-void* create_mfcc(void* argv)
+static void prepare_mfccs(int i)
 {
-	pthread_mutex_lock(&lock);
-	mask_sig();
-	pthread_mutex_unlock(&lock);
-	int i = *(int*)argv;
-	// for(int i = 1; i < num_ph; i++) {
 	// MFCCs
 	phones[i]->mfcc = (float**)malloc(sizeof(float*) * phones[i]->size_count);
 	phones[i]->mfcc_delta = (float**)malloc(sizeof(float*) * phones[i]->size_count);
@@ -412,68 +449,83 @@ void* create_mfcc(void* argv)
 			}
 		}
 	}
-	for(int j = 0; j < phones[i]->size_count; j++) {
-		float* signal = (float*)calloc(phones[i]->size[j], sizeof(float));
-		short* short_signal = (short*)calloc(phones[i]->size[j], sizeof(short));
-		float* zc_signal = (float*)calloc(phones[i]->size[j], sizeof(float));
-		for(int n = 0; n < phones[i]->size[j]; n++) {
-			signal[n] = phones[i]->sequence[j][n] / phones[i]->amounts[j];
-			short_signal[n] = signal[n];
-			zc_signal[n] = signal[n];
-		}
+}
 
-		phones[i]->mfcc[j] = mfcc(signal, phones[i]->size[j], glbl_window_width, glbl_banks, glbl_paa_op);
-		
-		int new_size = mfcc_size(phones[i]->size[j]);
-		int extra_size = floor(phones[i]->size[j] / glbl_window_width);
-		phones[i]->feats[j]->coeffs = extra_size;
-		if(EXTRA || (STE) || (ZC)) {
-			phones[i]->feats[j]->zc = (float*)calloc(extra_size, sizeof(float));
-			phones[i]->feats[j]->ste = (float*)calloc(extra_size, sizeof(float));
-			phones[i]->feats[j]->kurtosis = (float*)calloc(extra_size, sizeof(float));
-			phones[i]->feats[j]->entropy = (float*)calloc(extra_size, sizeof(float));
-			for(int m = 0; m < extra_size; m++) {
-				phones[i]->feats[j]->zc[m] = f_cross_rate(&zc_signal[m * glbl_window_width], glbl_window_width);
-				phones[i]->feats[j]->ste[m] = short_time_energy(&short_signal[m * glbl_window_width], glbl_window_width, glbl_window_width);
-				phones[i]->feats[j]->kurtosis[m] = kurtosis(&zc_signal[m * glbl_window_width], glbl_window_width);
-				phones[i]->feats[j]->entropy[m] = log_entropy(&zc_signal[m * glbl_window_width], glbl_window_width);
-			}
-		}
+/** 
+ * \brief Creates the MFCC, deltas and extra features of a single raw data signal
+ * 
+ * @param i The phoneme index
+ * @param j The raw data signal of the phoneme
+ * @param plan The MFCC extractor of the calling thread
+ */
+void create_mfcc(int i, int j, struct Mfcc_Plan* plan)
+{
+	float* signal = (float*)calloc(phones[i]->size[j], sizeof(float));
+	short* short_signal = (short*)calloc(phones[i]->size[j], sizeof(short));
+	float* zc_signal = (float*)calloc(phones[i]->size[j], sizeof(float));
+	for(int n = 0; n < phones[i]->size[j]; n++) {
+		signal[n] = phones[i]->sequence[j][n] / phones[i]->amounts[j];
+		short_signal[n] = signal[n];
+		zc_signal[n] = signal[n];
+	}
 
-		if(DELTA) {
-			phones[i]->mfcc_delta[j] = delta(phones[i]->mfcc[j], new_size);
-			if(DELTA_DELTA) {
-				phones[i]->mfcc_delta_delta[j] = delta_delta(phones[i]->mfcc_delta[j], new_size);
-			}
+	phones[i]->mfcc[j] = mfcc(plan, signal, phones[i]->size[j]);
+	
+	int new_size = mfcc_size(phones[i]->size[j]);
+	int extra_size = floor(phones[i]->size[j] / glbl_window_width);
+	phones[i]->feats[j]->coeffs = extra_size;
+	if(EXTRA || (STE) || (ZC)) {
+		phones[i]->feats[j]->zc = (float*)calloc(extra_size, sizeof(float));
+		phones[i]->feats[j]->ste = (float*)calloc(extra_size, sizeof(float));
+		phones[i]->feats[j]->kurtosis = (float*)calloc(extra_size, sizeof(float));
+		phones[i]->feats[j]->entropy = (float*)calloc(extra_size, sizeof(float));
+		// The energy is of the truncated samples, the crossings and entropy of the float samples
+		struct Feature_Index* zc_index = f_feature_index(zc_signal, phones[i]->size[j]);
+		struct Feature_Index* ste_index = feature_index(short_signal, phones[i]->size[j]);
+		if(zc_index == NULL || ste_index == NULL) {
+			printf("Failed to index the features of '%s'\n", phones[i]->index->name);
+			exit(-1);
 		}
-			
-		// memcpy(phones[i]->norm_mfcc[j], phones[i]->mfcc[j], new_size * sizeof(float));
-							      
-		phones[i]->size[j] = new_size;
-		free(phones[i]->sequence[j]);
-		free(short_signal);
-		free(zc_signal);
-		pthread_mutex_lock(&lock);
-		mfcced++;
-		if(mfcced % 1000 == 0)
-			printf("::         MFCC P#        ::  %02d:%02d:%02d  ::  %05d\n", hour(difftime(time(NULL), start)), minu(difftime(time(NULL), start)), seco(difftime(time(NULL), start)), mfcced);
-		pthread_mutex_unlock(&lock);
+		for(int m = 0; m < extra_size; m++) {
+			phones[i]->feats[j]->zc[m] = index_crossings(zc_index, m * glbl_window_width, glbl_window_width);
+			phones[i]->feats[j]->ste[m] = index_ste(ste_index, m * glbl_window_width, glbl_window_width);
+			phones[i]->feats[j]->kurtosis[m] = kurtosis(&zc_signal[m * glbl_window_width], glbl_window_width);
+			phones[i]->feats[j]->entropy[m] = index_log_entropy(zc_index, m * glbl_window_width, glbl_window_width);
+		}
+		free_feature_index(zc_index);
+		free_feature_index(ste_index);
+	}
 
-				
+	if(DELTA) {
+		phones[i]->mfcc_delta[j] = delta(phones[i]->mfcc[j], new_size);
+		if(DELTA_DELTA) {
+			phones[i]->mfcc_delta_delta[j] = delta_delta(phones[i]->mfcc_delta[j], new_size);
+		}
 	}
+		
+	// memcpy(phones[i]->norm_mfcc[j], phones[i]->mfcc[j], new_size * sizeof(float));
+						      
+	phones[i]->size[j] = new_size;
+	free(phones[i]->sequence[j]);
+	free(signal);
+	free(short_signal);
+	free(zc_signal);
+}
+
+/** 
+ * \brief Frees the raw data of a phoneme and applies \var AVG or \var MEAN_SIZE once all of its MFCCs exist
+ * 
+ * @param i The phoneme index
+ */
+static void finish_mfccs(int i)
+{
 	free(phones[i]->sequence);
-	// }
 
 	if(AVG) {
 		average_mfccs(i);
 	} else if(MEAN_SIZE) {
 		mean_size_mfccs(phones[i]);
 	}
-
-	
-
-	pthread_exit(NULL);
-	return NULL;
 }
 
 /** 
@@ -582,6 +634,33 @@ void dtw_init(void)
 	return;
 } 
 
+/** 
+ * \brief The cost of a single cell when the MFCC, delta and delta-delta are compared in one \var FUSED pass
+ * 
+ * @param signal The test MFCC
+ * @param signal_delta The test delta, NULL if \var DELTA is not set
+ * @param signal_delta_delta The test delta-delta, NULL if \var DELTA_DELTA is not set
+ * @param phoneme The phoneme compared to
+ * @param p The index of the compared MFCC within @param phoneme
+ * @param i The frame of the test
+ * @param j The frame of the phoneme's MFCC
+ * @param trunc The amount of coefficients in a frame
+ * @param metric The metric used for the MFCC; the deltas always use L1 as their separate passes do
+ * 
+ * @return The MFCC cost plus the weighted delta and delta-delta costs
+ */
+static inline double fused_cost(const float* signal, const float* signal_delta, const float* signal_delta_delta, struct Phoneme* phoneme, int p, int i, int j, int trunc, int metric)
+{
+	double cost = frame_distance(&signal[i * trunc], &phoneme->mfcc[p][j * trunc], trunc, metric);
+	if(signal_delta != NULL) {
+		cost += glbl_delta_weight * frame_distance(&signal_delta[i * trunc], &phoneme->mfcc_delta[p][j * trunc], trunc, DIST_L1);
+	}
+	if(signal_delta_delta != NULL) {
+		cost += glbl_delta_delta_weight * frame_distance(&signal_delta_delta[i * trunc], &phoneme->mfcc_delta_delta[p][j * trunc], trunc, DIST_L1);
+	}
+	return cost;
+}
+
 /** 
  * \brief A K-means function for use with @file jenks.py
  * 
@@ -590,10 +669,13 @@ void dtw_init(void)
  * @param phoneme The phoneme to be compared to
  * @param limit The window limit for DTW
  */
-void dtw_clust(float** signal, int signal_length, struct Phoneme* phoneme, short limith)
+void dtw_clust(const struct Test_Features* test, struct Phoneme* phoneme, short limith, struct Score_Context* ctx)
 {
+	struct Dtw_Workspace* ws = &ctx->ws;
+	const float* signal = test->mfcc;
+	int signal_length = test->length;
 	time_t started = time(NULL);
-	phoneme->score = 0;
+	ctx->score[phoneme->index->i] = 0;
 	double temp_last_min = 0,  last_min = 0;
 	int phone_length = 0, w = 0; //  pos = 1;
 	int p = 0;
@@ -611,23 +693,25 @@ void dtw_clust(float** signal, int signal_length, struct Phoneme* phoneme, short
 	w = floor(win * (float)largest);
 	if(signal_length == 0) {
 		printf("Exiting, no signal length() found\n");
-		DTW_ERROR = NO_SIG_LEN;
-		failed = 1;
+		ctx->dtw_error = NO_SIG_LEN;
+		ctx->failed = 1;
 		return;
 	}
 	if(phone_length == 0) {
 		printf("Exiting, no sequence length found : %d : %d\n", phoneme->size[p], phone_length);
-		failed = 1;
+		ctx->failed = 1;
 		return;
 	}
-	double** dtw_matrix = init_dtw_matrix(signal_length, signal_length, w);
+	dtw_workspace_begin(ws, DTW_ROLLING, signal_length, w);
 	for(int i = 1; i <= signal_length - 1; i++) {
+		double* prev = dtw_workspace_row(ws, i - 1);
+		double* curr = dtw_workspace_next_row(ws, i);
 		for(int j = max(1, i-w); j <= min(phone_length - 1, i+w); j++) {
 			for(int m = 0; m < trunc; m++) {
 				double smallest_diff = DBL_MAX;
 				for(int o = 0; o < phoneme->clust[m]->count; o++) {
-					if(fabs(signal[0][(i * trunc) +  m] - phoneme->clust[m]->centroids[o]) < smallest_diff) {
-						smallest_diff = fabs(signal[0][(i * trunc) +  m] - phoneme->clust[m]->centroids[o]);
+					if(fabs(signal[(i * trunc) +  m] - phoneme->clust[m]->centroids[o]) < smallest_diff) {
+						smallest_diff = fabs(signal[(i * trunc) +  m] - phoneme->clust[m]->centroids[o]);
 						if(smallest_diff == 0)
 							goto stop;
 					}
@@ -635,34 +719,32 @@ void dtw_clust(float** signal, int signal_length, struct Phoneme* phoneme, short
 			stop:
 				cost += pow(smallest_diff, 2);
 			}
-			temp_last_min = fmin(dtw_matrix[i-1][j], dtw_matrix[i][j-1]);
-			last_min = fmin(temp_last_min, dtw_matrix[i-1][j-1]);
-			dtw_matrix[i][j] = cost + last_min;
-			score = dtw_matrix[i][j];
+			temp_last_min = fmin(BAND(prev, i-1, j, w), BAND(curr, i, j-1, w));
+			last_min = fmin(temp_last_min, BAND(prev, i-1, j-1, w));
+			BAND(curr, i, j, w) = cost + last_min;
+			score = BAND(curr, i, j, w);
 			cost = 0;
 			// if(fabs(total_score + score) > best_so_far) { goto end; }
 		}
 	}
 
-	phoneme->score = score;
-		
-	for(int i = 0; i < signal_length; i++) {
-		free(dtw_matrix[i]);
-	}
+	ctx->score[phoneme->index->i] = score;
 		
-	free(dtw_matrix);
 	time_t ended = time(NULL);
-	total_test_time += (ended - started);
-	total_dtw_tests++;
+	ctx->total_test_time += (ended - started);
+	ctx->total_dtw_tests++;
 	return;
 }
 
 /** 
  * Similar to \fn dtw_clust() except it returns the result of DTW.
  */
-double dtw_clust_result(float* signal, int signal_length, struct Phoneme* phoneme, int t, int clust, short limit)
+double dtw_clust_result(const struct Test_Features* test, struct Phoneme* phoneme, int t, int clust, short limit, struct Score_Context* ctx)
 {
-	phoneme->score = 0;
+	struct Dtw_Workspace* ws = &ctx->ws;
+	const float* signal = test->mfcc;
+	int signal_length = test->length;
+	ctx->score[phoneme->index->i] = 0;
 	double temp_last_min = 0,  last_min = 0;
 	int phone_length = 0, w = 0;
 	int p = 0;
@@ -680,17 +762,19 @@ double dtw_clust_result(float* signal, int signal_length, struct Phoneme* phonem
 	w = floor(win * (float)largest);
 	if(signal_length == 0) {
 		printf("Exiting, no signal length() found\n");
-		DTW_ERROR = NO_SIG_LEN;
-		failed = 1;
+		ctx->dtw_error = NO_SIG_LEN;
+		ctx->failed = 1;
 		return - 1;
 	}
 	if(phone_length == 0) {
 		printf("Exiting, no sequence length found : %d : %d\n", phoneme->size[p], phone_length);
-		failed = 1;
+		ctx->failed = 1;
 		return - 1;
 	}
-	double** dtw_matrix = init_dtw_matrix(signal_length, phone_length, w);
+	dtw_workspace_begin(ws, DTW_ROLLING, phone_length, w);
 	for(int i = 1; i <= signal_length - 1; i++) {
+		double* prev = dtw_workspace_row(ws, i - 1);
+		double* curr = dtw_workspace_next_row(ws, i);
 		for(int j = max(1, i-w); j <= min(phone_length - 1, i+w); j++) {
 			for(int m = 0; m < trunc; m++) {
 				double smallest_diff = DBL_MAX;
@@ -705,10 +789,10 @@ double dtw_clust_result(float* signal, int signal_length, struct Phoneme* phonem
 			stop:
 				cost += pow(smallest_diff, 2);
 			}
-			temp_last_min = fmin(dtw_matrix[i-1][j], dtw_matrix[i][j-1]);
-			last_min = fmin(temp_last_min, dtw_matrix[i-1][j-1]);
-			dtw_matrix[i][j] = cost + last_min;
-			score = dtw_matrix[i][j];
+			temp_last_min = fmin(BAND(prev, i-1, j, w), BAND(curr, i, j-1, w));
+			last_min = fmin(temp_last_min, BAND(prev, i-1, j-1, w));
+			BAND(curr, i, j, w) = cost + last_min;
+			score = BAND(curr, i, j, w);
 			cost = 0;
 			// if(fabs(total_score + score) > best_so_far) { goto end; }
 		}
@@ -716,11 +800,6 @@ double dtw_clust_result(float* signal, int signal_length, struct Phoneme* phonem
 
 	final_score = score;
 		
-	for(int i = 0; i < signal_length; i++) {
-		free(dtw_matrix[i]);
-	}
-		
-	free(dtw_matrix);
 	return final_score;
 }
 
@@ -732,48 +811,36 @@ double dtw_clust_result(float* signal, int signal_length, struct Phoneme* phonem
  * @param phoneme The phoneme to compare to 
  * @param limit The DTW window limit
  */
-void dtw_frame(float** signal, int signal_length, struct Phoneme* phoneme, short limit)
+void dtw_frame(const struct Test_Features* test, struct Phoneme* phoneme, short limit, struct Score_Context* ctx)
 {
+	struct Dtw_Workspace* ws = &ctx->ws;
+	int signal_length = test->length;
 	time_t started = time(NULL);
-	phoneme->score = 0;
+	ctx->score[phoneme->index->i] = 0;
 	double temp_last_min = 0,  last_min = 0;
 	int phone_length = 0;
 	int w = 0; //  pos = 1;
-	int p = 0, smallest_diff = INT_MAX;
- 	// float coef_diff = FLT_MAX;
+	int p = 0;
 	int mfcc_length = mfcc_size(signal_length);
-	int to_try[phoneme->size_count];
-	int loc = 0;
-	for(int i = 0; i < phoneme->size_count; i++) {
-		if(phoneme->size[i] == 0) {
-			continue;
-		}
-		if((abs(phoneme->size[i] - mfcc_length) <= smallest_diff)) { // 
-			smallest_diff = abs(phoneme->size[i] - mfcc_length);
-			// coef_diff = fabs(signal[0][0] - phoneme->mfcc[i][0]);
-			p = i;
-		}
-		if(smallest_diff == 0) {
-			to_try[loc] = i;
-			loc++;
-		}
-		
-	}
-	if(loc == 0) {
-		to_try[0] = p;
-		loc = 1;
-	}
+	// The prototypes of the test's size, or the nearest sized one
+	int exact = 0;
+	const struct Proto_Ref* same = prototypes_of_size(mfcc_length, phoneme->index->i, phoneme->index->i + 1, &exact);
+	int nearest = max(nearest_prototype(phoneme->index->i, mfcc_length, 1), 0);
+	int loc = (exact > 0) ? exact : 1;
+
+	const float* fused_delta = FUSED ? test->delta : NULL;
+	const float* fused_delta_delta = FUSED ? test->delta_delta : NULL;
 
 	double smallest = DBL_MAX;
 	for(int m = 0; m < loc; m++) {
-		p = to_try[m];
+		p = (exact > 0) ? same[m].ref : nearest;
 		double total_score = 0;
 		int trunc = floor((glbl_banks) * glbl_test_trunc);	
 		signal_length = mfcc_length / trunc;
 		phone_length = phoneme->size[p] / trunc;
 		double score = 0;
 		double cost = 0;
-		phoneme->used[p]++;
+		ctx->used[phoneme->index->i][p]++;
 		/* An MFCC is amount * truncation - trunc = floor((incr / 2) * glbl_test_trunc)*/
 		// w = max(limit, abs(signal_length-phone_length));
 		int largest = max(signal_length, phone_length);
@@ -781,57 +848,46 @@ void dtw_frame(float** signal, int signal_length, struct Phoneme* phoneme, short
 		w = floor(win * (float)largest);
 		if(signal_length == 0) {
 			printf("Exiting, no signal length() found\n");
-			DTW_ERROR = NO_SIG_LEN;
-			failed = 1;
+			ctx->dtw_error = NO_SIG_LEN;
+			ctx->failed = 1;
 			return;
 		}
 		if(phone_length == 0) {
 			printf("Exiting, no sequence length found : %d : %d\n", phoneme->size[p], phone_length);
-			failed = 1;
+			ctx->failed = 1;
 			return;
 		}
-		double** dtw_matrix = init_dtw_matrix(signal_length, phone_length, w);
+		dtw_workspace_begin(ws, DTW_ROLLING, phone_length, w);
 		for(int i = 1; i <= signal_length - 1; i++) {
+			double* prev = dtw_workspace_row(ws, i - 1);
+			double* curr = dtw_workspace_next_row(ws, i);
 			for(int j = max(1, i-w); j <= min(phone_length - 1, i+w); j++) {
-				//double** dtw_matrix = init_dtw_matrix(signal_length, phone_length, w);
-				//for(int i = 1; i < signal_length - 1; i++) {
-				//for(int j = max(1, i-w); j < min(phone_length - 1, i+w); j++) {
-				for(int m = 0; m < trunc; m++) {
-					cost += pow(fabs(signal[0][(i * trunc) +  m] - phoneme->mfcc[p][(j * trunc) +  m]), 2);
-				}
-				temp_last_min = fmin(dtw_matrix[i-1][j], dtw_matrix[i][j-1]);
-				last_min = fmin(temp_last_min, dtw_matrix[i-1][j-1]);
-				dtw_matrix[i][j] = cost + last_min;
-				score = dtw_matrix[i][j];
+				cost += fused_cost(test->mfcc, fused_delta, fused_delta_delta, phoneme, p, i, j, trunc, DIST_SQ_L2);
+				temp_last_min = fmin(BAND(prev, i-1, j, w), BAND(curr, i, j-1, w));
+				last_min = fmin(temp_last_min, BAND(prev, i-1, j-1, w));
+				BAND(curr, i, j, w) = cost + last_min;
+				score = BAND(curr, i, j, w);
 				cost = 0;
 				// if(fabs(total_score + score) > best_so_far) { goto end; }
 			}
 		}
 		total_score += score;
 		
-		for(int i = 0; i < signal_length; i++) {
-			free(dtw_matrix[i]);
-		}
-		
-		free(dtw_matrix);
 
-		if(DELTA) {
-			float* signal_delta = delta(signal[0], mfcc_length);
-			if(NORM) {
-				normalise_delta(signal_delta, mfcc_length);
-			}
-			dtw_matrix = init_dtw_matrix(signal_length, phone_length, w);
+		if(DELTA && !(FUSED)) {
+			const float* signal_delta = test->delta;
+			dtw_workspace_begin(ws, DTW_ROLLING, phone_length, w);
 			score = 0;
 			for(int i = 1; i < signal_length - 1; i++) {
+				double* prev = dtw_workspace_row(ws, i - 1);
+				double* curr = dtw_workspace_next_row(ws, i);
 				for(int j = max(1, i-w); j < min(phone_length - 1, i+w); j++) {
-					for(int m = 0; m < trunc; m++) {
-						cost += fabs(signal_delta[(i * trunc) +  m] - phoneme->mfcc_delta[p][(j * trunc) +  m]);
-					}
+					cost += frame_distance(&signal_delta[i * trunc], &phoneme->mfcc_delta[p][j * trunc], trunc, DIST_L1);
 
-					temp_last_min = fmin(dtw_matrix[i-1][j], dtw_matrix[i][j-1]);
-					last_min = fmin(temp_last_min, dtw_matrix[i-1][j-1]);
-					dtw_matrix[i][j] = cost + last_min;
-					score = dtw_matrix[i][j];
+					temp_last_min = fmin(BAND(prev, i-1, j, w), BAND(curr, i, j-1, w));
+					last_min = fmin(temp_last_min, BAND(prev, i-1, j-1, w));
+					BAND(curr, i, j, w) = cost + last_min;
+					score = BAND(curr, i, j, w);
 					cost = 0;
 					// if(fabs(score) > best_so_far) { goto end; }
 				}
@@ -839,29 +895,20 @@ void dtw_frame(float** signal, int signal_length, struct Phoneme* phoneme, short
 
 			total_score += score;
 		
-			for(int i = 0; i < signal_length; i++) {
-				free(dtw_matrix[i]);
-			}
-		
-			free(dtw_matrix);
-			free(signal_delta); 
 		}
-		if(DELTA_DELTA) {
-			float* signal_delta_delta = delta(signal[0], mfcc_length);
-			if(NORM) {
-				normalise_delta_delta(signal_delta_delta, mfcc_length);
-			}
-			dtw_matrix = init_dtw_matrix(signal_length, phone_length, w);
+		if(DELTA_DELTA && !(FUSED)) {
+			const float* signal_delta_delta = test->delta_delta;
+			dtw_workspace_begin(ws, DTW_ROLLING, phone_length, w);
 			score = 0;
 			for(int i = 1; i < signal_length - 1; i++) {
+				double* prev = dtw_workspace_row(ws, i - 1);
+				double* curr = dtw_workspace_next_row(ws, i);
 				for(int j = max(1, i-w); j < min(phone_length - 1, i+w); j++) {
-					for(int m = 0; m < trunc; m++) {
-						cost += fabs(signal_delta_delta[(i * trunc) +  m] - phoneme->mfcc_delta_delta[p][(j * trunc) +  m]);
-					}
-					temp_last_min = fmin(dtw_matrix[i-1][j], dtw_matrix[i][j-1]);
-					last_min = fmin(temp_last_min, dtw_matrix[i-1][j-1]);
-					dtw_matrix[i][j] = cost + last_min;
-					score = dtw_matrix[i][j];
+					cost += frame_distance(&signal_delta_delta[i * trunc], &phoneme->mfcc_delta_delta[p][j * trunc], trunc, DIST_L1);
+					temp_last_min = fmin(BAND(prev, i-1, j, w), BAND(curr, i, j-1, w));
+					last_min = fmin(temp_last_min, BAND(prev, i-1, j-1, w));
+					BAND(curr, i, j, w) = cost + last_min;
+					score = BAND(curr, i, j, w);
 					cost = 0;
 					// if(fabs(score) > best_so_far) { goto end; }
 				}
@@ -871,31 +918,44 @@ void dtw_frame(float** signal, int signal_length, struct Phoneme* phoneme, short
 			total_score += score;
 // end:
 
-			for(int i = 0; i < signal_length; i++) {
-				free(dtw_matrix[i]);
-			}
-			free(dtw_matrix); 
-			free(signal_delta_delta);
 		}
 		if(fabs(total_score) < smallest || m == 0) {
 			smallest = fabs(total_score);
-			phoneme->score = smallest;
+			ctx->score[phoneme->index->i] = smallest;
 		}
 	}
 
 	time_t ended = time(NULL);
-	total_test_time += (ended - started);
-	total_dtw_tests++;
+	ctx->total_test_time += (ended - started);
+	ctx->total_dtw_tests++;
 	return;
 }
 
 /**
  * \brief Similar to \fn dtw_frame() except the result is returned.
  */
-double dtw_frame_result(float* signal, int signal_length, struct Phoneme* phoneme, int p, short limit)
+double dtw_frame_result(const struct Test_Features* test, struct Phoneme* phoneme, int p, short limit, struct Score_Context* ctx)
+{
+	ctx->used[phoneme->index->i][p]++;
+	return dtw_frame_result_bounded(test, phoneme, p, limit, ctx, DBL_MAX);
+}
+
+/**
+ * \brief \fn dtw_frame_result() which gives up once the result is known to exceed @cutoff
+ * @cutoff The distance the result must be under to be of use, DBL_MAX to never abandon
+ *
+ * Every cost is non-negative, so the smallest cell of a row bounds the final score from below.
+ * Once that minimum plus the score of any earlier pass exceeds @cutoff the comparison is
+ * abandoned and DBL_MAX returned, which can never be chosen over a result under @cutoff.
+ * The comparison is not counted in @ctx's used, the caller counts it whether it was scored or not.
+ */
+double dtw_frame_result_bounded(const struct Test_Features* test, struct Phoneme* phoneme, int p, short limit, struct Score_Context* ctx, double cutoff)
 {
+	struct Dtw_Workspace* ws = &ctx->ws;
+	const float* signal = test->mfcc;
+	int signal_length = test->length;
 	
-	phoneme->score = 0;
+	ctx->score[phoneme->index->i] = 0;
 	double temp_last_min = 0,  last_min = 0;
 	int phone_length = 0;
 	int w = 0;
@@ -907,105 +967,104 @@ double dtw_frame_result(float* signal, int signal_length, struct Phoneme* phonem
 	
 	double score = 0;
 	double cost = 0;
-	phoneme->used[p]++;
 	int largest = max(signal_length, phone_length);
 	float win = (float)glbl_dtw_window / 1000;
 	w = floor(win * (float)largest);
 	// printf("Window :: %d :: (%d * %f)\n", w, largest, win);
 	if(signal_length == 0) {
 		printf("Exiting, no signal length() found\n");
-		DTW_ERROR = NO_SIG_LEN;
-		failed = 1;
+		ctx->dtw_error = NO_SIG_LEN;
+		ctx->failed = 1;
 		return -1;
 	}
 	if(phone_length == 0) {
 		printf("Exiting, no sequence length found : %d : %d\n", phoneme->size[p], phone_length);
-		failed = 1;
+		ctx->failed = 1;
 		return -1;
 	}
 	int diff = 1, start = 1;
 
-	double** dtw_matrix = init_dtw_matrix(signal_length, phone_length, w);
+	const float* fused_delta = FUSED ? test->delta : NULL;
+	const float* fused_delta_delta = FUSED ? test->delta_delta : NULL;
+
+	dtw_workspace_begin(ws, DTW_ROLLING, phone_length, w);
 	for(int i = start; i <= signal_length - 1; i++) {
+		double* prev = dtw_workspace_row(ws, i - 1);
+		double* curr = dtw_workspace_next_row(ws, i);
+		double row_min = DBL_MAX;
 		for(int j = max(start, i-w); j <= min(phone_length - diff, i+w); j++) {
-			for(int m = 0; m < trunc; m++) {
-				cost += fabs(signal[(i * trunc) +  m] - phoneme->mfcc[p][(j * trunc) +  m]); // * weight);
-			}
-			temp_last_min = fmin(dtw_matrix[i-1][j], dtw_matrix[i][j-1]);
-			last_min = fmin(temp_last_min, dtw_matrix[i-1][j-1]);
-			dtw_matrix[i][j] = cost + last_min;
-			score = dtw_matrix[i][j];
+			cost += fused_cost(signal, fused_delta, fused_delta_delta, phoneme, p, i, j, trunc, DIST_L1);
+			temp_last_min = fmin(BAND(prev, i-1, j, w), BAND(curr, i, j-1, w));
+			last_min = fmin(temp_last_min, BAND(prev, i-1, j-1, w));
+			BAND(curr, i, j, w) = cost + last_min;
+			score = BAND(curr, i, j, w);
+			row_min = fmin(row_min, score);
 			cost = 0;
 		}
+		if(row_min != DBL_MAX && row_min > cutoff) {
+			ctx->abandoned++;
+			return DBL_MAX;
+		}
 	}
 	
 	final_score += score;	
-	for(int i = 0; i < signal_length; i++) {
-		free(dtw_matrix[i]);
-	}
-	free(dtw_matrix);
 
-	if(DELTA) {
-		float* signal_delta = delta(signal, mfcc_length);
-		if(NORM) {
-			normalise_delta(signal_delta, mfcc_length);
-		}
-		dtw_matrix = init_dtw_matrix(signal_length, phone_length, w);
+	if(DELTA && !(FUSED)) {
+		const float* signal_delta = test->delta;
+		dtw_workspace_begin(ws, DTW_ROLLING, phone_length, w);
 		score = 0;
 		for(int i = start; i <= signal_length - diff; i++) {
+			double* prev = dtw_workspace_row(ws, i - 1);
+			double* curr = dtw_workspace_next_row(ws, i);
+			double row_min = DBL_MAX;
 			for(int j = max(start, i-w); j <= min(phone_length - diff, i+w); j++) {
-				for(int m = 0; m < trunc; m++) {
-					cost += fabs(signal_delta[(i * trunc) +  m] - phoneme->mfcc_delta[p][(j * trunc) +  m]);
-				}
+				cost += frame_distance(&signal_delta[i * trunc], &phoneme->mfcc_delta[p][j * trunc], trunc, DIST_L1);
 
-				temp_last_min = fmin(dtw_matrix[i-1][j], dtw_matrix[i][j-1]);
-				last_min = fmin(temp_last_min, dtw_matrix[i-1][j-1]);
-				dtw_matrix[i][j] = cost + last_min;
-				score = dtw_matrix[i][j];
+				temp_last_min = fmin(BAND(prev, i-1, j, w), BAND(curr, i, j-1, w));
+				last_min = fmin(temp_last_min, BAND(prev, i-1, j-1, w));
+				BAND(curr, i, j, w) = cost + last_min;
+				score = BAND(curr, i, j, w);
+				row_min = fmin(row_min, score);
 				cost = 0;
 				// if(fabs(score) > best_so_far) { goto end; }
 			}
+			if(row_min != DBL_MAX && final_score + row_min > cutoff) {
+				ctx->abandoned++;
+				return DBL_MAX;
+			}
 		}
 
 		final_score += score;
 		
-		for(int i = 0; i < signal_length; i++) {
-			free(dtw_matrix[i]);
-		}
-		
-		free(dtw_matrix);
-		free(signal_delta); 
 	}
-	if(DELTA_DELTA) {
-		float* signal_delta_delta = delta(signal, mfcc_length);
-		if(NORM) {
-			normalise_delta_delta(signal_delta_delta, mfcc_length);
-		}
-		dtw_matrix = init_dtw_matrix(signal_length, phone_length, w);
+	if(DELTA_DELTA && !(FUSED)) {
+		const float* signal_delta_delta = test->delta_delta;
+		dtw_workspace_begin(ws, DTW_ROLLING, phone_length, w);
 		score = 0;
 		for(int i = start; i <= signal_length - diff; i++) {
+			double* prev = dtw_workspace_row(ws, i - 1);
+			double* curr = dtw_workspace_next_row(ws, i);
+			double row_min = DBL_MAX;
 			for(int j = max(start, i-w); j <= min(phone_length - diff, i+w); j++) {
-				for(int m = 0; m < trunc; m++) {
-					cost += fabs(signal_delta_delta[(i * trunc) +  m] - phoneme->mfcc_delta_delta[p][(j * trunc) +  m]);
-				}
-				temp_last_min = fmin(dtw_matrix[i-1][j], dtw_matrix[i][j-1]);
-				last_min = fmin(temp_last_min, dtw_matrix[i-1][j-1]);
-				dtw_matrix[i][j] = cost + last_min;
-				score = dtw_matrix[i][j];
+				cost += frame_distance(&signal_delta_delta[i * trunc], &phoneme->mfcc_delta_delta[p][j * trunc], trunc, DIST_L1);
+				temp_last_min = fmin(BAND(prev, i-1, j, w), BAND(curr, i, j-1, w));
+				last_min = fmin(temp_last_min, BAND(prev, i-1, j-1, w));
+				BAND(curr, i, j, w) = cost + last_min;
+				score = BAND(curr, i, j, w);
+				row_min = fmin(row_min, score);
 				cost = 0;
 				// if(fabs(score) > best_so_far) { goto end; }
 			}
+			if(row_min != DBL_MAX && final_score + row_min > cutoff) {
+				ctx->abandoned++;
+				return DBL_MAX;
+			}
 		}
 
 
 		final_score += score;
 // end:
 
-		for(int i = 0; i < signal_length; i++) {
-			free(dtw_matrix[i]);
-		}
-		free(dtw_matrix); 
-		free(signal_delta_delta);
 	}
 
 	return final_score;
@@ -1016,10 +1075,12 @@ double dtw_frame_result(float* signal, int signal_length, struct Phoneme* phonem
  *
  * This method can classify a phoneme's group using MFCCs, zero cross, short time energy, or deltas, depending on the set parameter.
  */
-double dtw_frame_result_group(float** signal, int signal_length, struct Phoneme* phoneme, int p, short limit)
+double dtw_frame_result_group(const struct Test_Features* test, struct Phoneme* phoneme, int p, short limit, struct Score_Context* ctx)
 {
+	struct Dtw_Workspace* ws = &ctx->ws;
+	int signal_length = test->length;
 	
-	phoneme->score = 0;
+	ctx->score[phoneme->index->i] = 0;
 	double temp_last_min = 0,  last_min = 0, final_score = 0;
 	int phone_length = 0;
 	int w = 0;
@@ -1032,40 +1093,36 @@ double dtw_frame_result_group(float** signal, int signal_length, struct Phoneme*
 	phone_length = phoneme->size[p] / trunc;
 	double score = 0;
 	double cost = 0;
-	phoneme->used[p]++;
+	ctx->used[phoneme->index->i][p]++;
 	int largest = max(signal_length, phone_length);
 	float win = (float)glbl_dtw_window / 1000;
-	double** dtw_matrix;
 	w = floor(win * (float)largest);
 	if(signal_length == 0) {
 		printf("Exiting, no signal length() found\n");
-		DTW_ERROR = NO_SIG_LEN;
-		failed = 1;
+		ctx->dtw_error = NO_SIG_LEN;
+		ctx->failed = 1;
 		return -1;
 	}
 	if(phone_length == 0) {
 		printf("Exiting, no sequence length found : %d : %d\n", phoneme->size[p], phone_length);
-		failed = 1;
+		ctx->failed = 1;
 		return -1;
 	}
 
 	if(DELTA) {
-		float* signal_delta = delta(signal[0], mfcc_length);
-		if(NORM) {
-			normalise_delta(signal_delta, mfcc_length);
-		}
-		dtw_matrix = init_dtw_matrix(signal_length, phone_length, w);
+		const float* signal_delta = test->delta;
+		dtw_workspace_begin(ws, DTW_ROLLING, phone_length, w);
 		score = 0;
 		for(int i = start; i <= signal_length - 1; i++) {
+			double* prev = dtw_workspace_row(ws, i - 1);
+			double* curr = dtw_workspace_next_row(ws, i);
 			for(int j = max(start, i-w); j <= min(phone_length - 1, i+w); j++) {			       
-				for(int m = 0; m < trunc; m++) {
-					cost += fabs(signal_delta[(i * trunc) +  m] - phoneme->mfcc_delta[p][(j * trunc) +  m]);
-				}
+				cost += frame_distance(&signal_delta[i * trunc], &phoneme->mfcc_delta[p][j * trunc], trunc, DIST_L1);
 
-				temp_last_min = fmin(dtw_matrix[i-1][j], dtw_matrix[i][j-1]);
-				last_min = fmin(temp_last_min, dtw_matrix[i-1][j-1]);
-				dtw_matrix[i][j] = cost + last_min;
-				score = dtw_matrix[i][j];
+				temp_last_min = fmin(BAND(prev, i-1, j, w), BAND(curr, i, j-1, w));
+				last_min = fmin(temp_last_min, BAND(prev, i-1, j-1, w));
+				BAND(curr, i, j, w) = cost + last_min;
+				score = BAND(curr, i, j, w);
 				cost = 0;
 				// if(fabs(score) > best_so_far) { goto end; }
 			}
@@ -1073,29 +1130,20 @@ double dtw_frame_result_group(float** signal, int signal_length, struct Phoneme*
 
 		final_score += score;
 		
-		for(int i = 0; i < signal_length; i++) {
-			free(dtw_matrix[i]);
-		}
-		
-		free(dtw_matrix);
-		free(signal_delta);
 	}
 	if(DELTA_DELTA) {
-		float* signal_delta_delta = delta(signal[0], mfcc_length);
-		if(NORM) {
-			normalise_delta_delta(signal_delta_delta, mfcc_length);
-		}
-		dtw_matrix = init_dtw_matrix(signal_length, phone_length, w);
+		const float* signal_delta_delta = test->delta_delta;
+		dtw_workspace_begin(ws, DTW_ROLLING, phone_length, w);
 		score = 0;
 		for(int i = start; i <= signal_length - 1; i++) {
+			double* prev = dtw_workspace_row(ws, i - 1);
+			double* curr = dtw_workspace_next_row(ws, i);
 			for(int j = max(start, i-w); j <= min(phone_length - 1, i+w); j++) {
-				for(int m = 0; m < trunc; m++) {
-					cost += fabs(signal_delta_delta[(i * trunc) +  m] - phoneme->mfcc_delta_delta[p][(j * trunc) +  m]);
-				}
-				temp_last_min = fmin(dtw_matrix[i-1][j], dtw_matrix[i][j-1]);
-				last_min = fmin(temp_last_min, dtw_matrix[i-1][j-1]);
-				dtw_matrix[i][j] = cost + last_min;
-				score = dtw_matrix[i][j];
+				cost += frame_distance(&signal_delta_delta[i * trunc], &phoneme->mfcc_delta_delta[p][j * trunc], trunc, DIST_L1);
+				temp_last_min = fmin(BAND(prev, i-1, j, w), BAND(curr, i, j-1, w));
+				last_min = fmin(temp_last_min, BAND(prev, i-1, j-1, w));
+				BAND(curr, i, j, w) = cost + last_min;
+				score = BAND(curr, i, j, w);
 				cost = 0;
 				// if(fabs(score) > best_so_far) { goto end; }
 			}
@@ -1105,43 +1153,35 @@ double dtw_frame_result_group(float** signal, int signal_length, struct Phoneme*
 		final_score += score;
 // end:
 
-		for(int i = 0; i < signal_length; i++) {
-			free(dtw_matrix[i]);
-		}
-		free(dtw_matrix); 
-		free(signal_delta_delta);
 	}
 	
 	if(GROUP && (ZC || STE) && !(DELTA || DELTA_DELTA)) {
 		w = max(limit, abs(signal_coeffs-phoneme->feats[p]->coeffs));
-		dtw_matrix = init_dtw_matrix(signal_coeffs, phoneme->feats[p]->coeffs, w);
+		dtw_workspace_begin(ws, DTW_ROLLING, phoneme->feats[p]->coeffs, w);
 		score = 0;
 		for(int i = 1; i < signal_coeffs - 1; i++) {
+			double* prev = dtw_workspace_row(ws, i - 1);
+			double* curr = dtw_workspace_next_row(ws, i);
 			for(int j = max(1, i-w); j < min(phoneme->feats[p]->coeffs - 1, i+w); j++) {
 				if(ZC) {
-					cost += fabs(phoneme->feats[p]->zc[j] - signal[1][i]);
+					cost += fabs(phoneme->feats[p]->zc[j] - test->zc[i]);
 				} else if(STE){
-					cost += fabs(phoneme->feats[p]->ste[j] - signal[2][i]);
+					cost += fabs(phoneme->feats[p]->ste[j] - test->ste[i]);
 				} else if(KURT) {
-					cost += fabs(phoneme->feats[p]->kurtosis[j] - signal[3][i]);
+					cost += fabs(phoneme->feats[p]->kurtosis[j] - test->kurtosis[i]);
 				} else if(ENTR) {
-					cost += fabs(phoneme->feats[p]->entropy[j] - signal[4][i]);
+					cost += fabs(phoneme->feats[p]->entropy[j] - test->flatness[i]);
 				}
-				temp_last_min = fmin(dtw_matrix[i-1][j], dtw_matrix[i][j-1]);
-				last_min = fmin(temp_last_min, dtw_matrix[i-1][j-1]);
-				dtw_matrix[i][j] = cost + last_min;
-				score = dtw_matrix[i][j];
+				temp_last_min = fmin(BAND(prev, i-1, j, w), BAND(curr, i, j-1, w));
+				last_min = fmin(temp_last_min, BAND(prev, i-1, j-1, w));
+				BAND(curr, i, j, w) = cost + last_min;
+				score = BAND(curr, i, j, w);
 				cost = 0;
 			}
 		}
 
 		final_score += score;
 		
-		for(int i = 0; i < signal_coeffs; i++) {
-			free(dtw_matrix[i]);
-		}
-		
-		free(dtw_matrix);
 		return final_score;
 	}
 
@@ -1155,10 +1195,11 @@ double dtw_frame_result_group(float** signal, int signal_length, struct Phoneme*
  *
  * This method can classify a phoneme's group using raw time signals.
  */
-double dtw_frame_result_group_time(float* signal, int signal_length, struct Phoneme* phoneme, int p, short limit)
+double dtw_frame_result_group_time(float* signal, int signal_length, struct Phoneme* phoneme, int p, short limit, struct Score_Context* ctx)
 {
+	struct Dtw_Workspace* ws = &ctx->ws;
 	
-	phoneme->score = 0;
+	ctx->score[phoneme->index->i] = 0;
 	double temp_last_min = 0,  last_min = 0, final_score = 0;
 	int phone_length = 0;
 	int w = 0;	
@@ -1169,31 +1210,32 @@ double dtw_frame_result_group_time(float* signal, int signal_length, struct Phon
 	// phoneme->used[p]++;
 	int largest = max(signal_length, phone_length);
 	float win = (float)glbl_dtw_window / 1000;
-	double** dtw_matrix;
 	w = floor(win * (float)largest);
 	if(signal_length == 0) {
 		printf("Exiting, no signal length() found\n");
-		DTW_ERROR = NO_SIG_LEN;
-		failed = 1;
+		ctx->dtw_error = NO_SIG_LEN;
+		ctx->failed = 1;
 		return -1;
 	}
 	if(phone_length == 0) {
 		printf("Exiting, no sequence length found : %d : %d : %d\n", phoneme->raw_sizes[p], p, phoneme->raw_count);
-		failed = 1;
+		ctx->failed = 1;
 		return -1;
 	}
 
 	if(DELTA) {
-		dtw_matrix = init_dtw_matrix(signal_length, phone_length, w);
+		dtw_workspace_begin(ws, DTW_ROLLING, phone_length, w);
 		score = 0;
 		for(int i = start; i <= signal_length - 1; i++) {
+			double* prev = dtw_workspace_row(ws, i - 1);
+			double* curr = dtw_workspace_next_row(ws, i);
 			for(int j = max(start, i-w); j <= min(phone_length - 1, i+w); j++) {
 			       
 				cost += fabs(signal[i] - phoneme->raw_time[p][j]);
-				temp_last_min = fmin(dtw_matrix[i-1][j], dtw_matrix[i][j-1]);
-				last_min = fmin(temp_last_min, dtw_matrix[i-1][j-1]);
-				dtw_matrix[i][j] = cost + last_min;
-				score = dtw_matrix[i][j];
+				temp_last_min = fmin(BAND(prev, i-1, j, w), BAND(curr, i, j-1, w));
+				last_min = fmin(temp_last_min, BAND(prev, i-1, j-1, w));
+				BAND(curr, i, j, w) = cost + last_min;
+				score = BAND(curr, i, j, w);
 				cost = 0;
 				// if(fabs(score) > best_so_far) { goto end; }
 			}
@@ -1201,11 +1243,6 @@ double dtw_frame_result_group_time(float* signal, int signal_length, struct Phon
 
 		final_score += score;
 		
-		for(int i = 0; i < signal_length; i++) {
-			free(dtw_matrix[i]);
-		}
-		
-		free(dtw_matrix);
 	}
 	
 	
@@ -1213,43 +1250,75 @@ double dtw_frame_result_group_time(float* signal, int signal_length, struct Phon
 }
 
 /** 
- * \brief Initalises a zeroed matrix for use in DTW
+ * \brief Prepares a workspace for a DTW comparison
  * 
- * @param signal_length The length of the test's sequence MFCC in frames
+ * @param ws The caller's workspace, grown when the band or row count needs more room
+ * @param rows The amount of rows to keep; \def DTW_ROLLING when only the final score is needed
  * @param phone_length The length of the phoneme's sequence MFCC in frames
  * @param w The windowing limit
- * 
- * @return The zero initialised matrix
+ *
+ * Row 0 is set up as the first row of a full matrix would be, infinite except for [0][0].
+ * Every following row is prepared by \fn dtw_workspace_next_row() as the loop reaches it.
  */
-double** init_dtw_matrix(int signal_length, int phone_length, int w)
+void dtw_workspace_begin(struct Dtw_Workspace* ws, int rows, int phone_length, int w)
 {
-	double** dtw_matrix = (double**)malloc(signal_length *  sizeof(double*));
-	if(dtw_matrix == NULL)
-	{
-		fprintf(stderr, "out of memory\n");
-		exit(-1);
-	}
-	for(int i = 0; i < signal_length; i++) {
-		dtw_matrix[i] = (double*)malloc(phone_length * sizeof(double));
-		if(dtw_matrix[i] == NULL)
-			printf("Failed to malloc 'dtw_matrix[i]'\n");
-	}
-	for(int i = 0; i < signal_length; i++) {
-		for(int j = 0; j < phone_length; j++) {
-			dtw_matrix[i][j] = DBL_MAX;
+	size_t needed = (size_t)rows * (2 * w + 3);
+	if(needed > ws->capacity) {
+		free(ws->cells);
+		ws->cells = (double*)malloc(needed * sizeof(double));
+		if(ws->cells == NULL) {
+			fprintf(stderr, "out of memory\n");
+			exit(-1);
 		}
+		ws->capacity = needed;
 	}
-	dtw_matrix[0][0] = 0;
+	ws->rows = rows;
+	ws->stride = 2 * w + 3;
+	ws->w = w;
+	ws->phone_length = phone_length;
 
-	for(int i = 1; i <= signal_length - 1; i++) {
-		for(int j = max(1, i-w); j <= min(phone_length - 1, i+w); j++) {
-			//for(int i = 1; i < signal_length; i++) {
-			//for(int j = max(1, i-w); j < min(phone_length, i+w); j++) {
-			dtw_matrix[i][j] = 0;
-		}
+	double* row = ws->cells;
+	for(int k = 0; k < ws->stride; k++) {
+		row[k] = DBL_MAX;
 	}
+	BAND(row, 0, 0, w) = 0;
+}
 
-	return dtw_matrix;
+/** 
+ * \brief Returns the stored band of row @param i, index it with \def BAND
+ */
+double* dtw_workspace_row(struct Dtw_Workspace* ws, int i)
+{
+	return &ws->cells[(size_t)(i % ws->rows) * ws->stride];
+}
+
+/** 
+ * \brief Resets and returns the band of row @param i
+ * 
+ * The cells within the window are zeroed and those outside, including the guard cells either side, are set to DBL_MAX
+ * so reads beyond the band behave exactly as they did with a full matrix.
+ */
+double* dtw_workspace_next_row(struct Dtw_Workspace* ws, int i)
+{
+	double* row = dtw_workspace_row(ws, i);
+	int w = ws->w;
+	for(int k = 0; k < ws->stride; k++) {
+		row[k] = DBL_MAX;
+	}
+	for(int j = max(1, i-w); j <= min(ws->phone_length - 1, i+w); j++) {
+		BAND(row, i, j, w) = 0;
+	}
+	return row;
+}
+
+/** 
+ * \brief Releases the storage held by a workspace
+ */
+void dtw_workspace_free(struct Dtw_Workspace* ws)
+{
+	free(ws->cells);
+	ws->cells = NULL;
+	ws->capacity = 0;
 }
 
 /** 
@@ -1271,8 +1340,10 @@ size_t length(short* array)
 	return size;
 }
 
-int is_sil_mean(short* array, int length)
+/* The silence checks read samples @from to @from + @length - 1 of an indexed signal */
+int is_sil_mean(const struct Feature_Index* index, int from, int length)
 {
+	const short* array = &index->signal[from];
 	double total = 0, mean = 0; //, std = 0;
 	for(int i = 0; i < length - 2; i++) {
 		total += array[i];
@@ -1283,7 +1354,7 @@ int is_sil_mean(short* array, int length)
 		return 1;
 	}
 	
-	float ste = short_time_energy(array, length - 2, glbl_window_width);
+	float ste = index_ste(index, from, length - 2);
 	float* signal = (float*)malloc(sizeof(float) * (length - 2));
 	for(int i = 0; i < length - 2; i++) {
 		signal[i] = array[i];
@@ -1293,7 +1364,6 @@ int is_sil_mean(short* array, int length)
 	while(strcmp(p_codes[j], "\0") != 0) {
 		j++;	
 	}
-	num_ph = j;
 	for(int i = 1; i < j; i++) {
 		// Get the appropriate ste and zc to compare
 		if(strcmp(phones[i]->index->name, "h#") == 0 ||
@@ -1313,8 +1383,9 @@ int is_sil_mean(short* array, int length)
 	return 0;
 }
 
-int is_sil(short* array, int length)
+int is_sil(const struct Feature_Index* index, int from, int length)
 {
+	const short* array = &index->signal[from];
 	double sum = 0, total = 0, mean = 0; //, std = 0;
 	for(int i = 0; i < length - 2; i++) {
 		total += array[i];
@@ -1324,7 +1395,7 @@ int is_sil(short* array, int length)
 		sum += pow( (array[i] - mean), 2);
 	}
 	// std = sqrt(sum / (length - 2));
-	float ste = short_time_energy(array, length - 2, glbl_window_width);
+	float ste = index_ste(index, from, length - 2);
 	float* signal = (float*)malloc(sizeof(float) * (length - 2));
 	for(int i = 0; i < length - 2; i++) {
 		signal[i] = array[i];
@@ -1334,7 +1405,6 @@ int is_sil(short* array, int length)
 	while(strcmp(p_codes[j], "\0") != 0) {
 		j++;	
 	}
-	num_ph = j;
 	for(int i = 1; i < j; i++) {
 		// Get the appropriate ste and zc to compare
 		if(strcmp(phones[i]->index->name, "h#") == 0 ||
@@ -1363,16 +1433,12 @@ int is_sil(short* array, int length)
 	return 0;
 }
 
-int is_sil_ste_chunk(short* array, int length)
+int is_sil_ste_chunk(const struct Feature_Index* index, int from, int length)
 {
 
 	float amount = floor(length / glbl_window_width), ste = 0, count = 0;
-	float* signal = (float*)calloc(length, sizeof(float));
-	for(int i = 0; i < length; i++) {
-		signal[i] = array[i];
-	}
 	for(int i = 0; i < (length - glbl_window_width) ; i+=glbl_window_width) {
-		ste = f_short_time_energy(&signal[i], glbl_window_width, glbl_window_width);
+		ste = index_ste(index, from + i, glbl_window_width);
 		if(ste > 2500)
 			count++;
 		if( (count / amount) > 0.1)
@@ -1382,32 +1448,26 @@ int is_sil_ste_chunk(short* array, int length)
 
 }
 
-int is_sil_ste(short* array, int length)
+int is_sil_ste(const struct Feature_Index* index, int from, int length)
 {
-	float* signal = (float*)calloc(length, sizeof(float));
-	for(int i = 0; i < length; i++) {
-		signal[i] = array[i];
-	}
-	float ste = f_short_time_energy(signal, length, glbl_window_width);
+	float ste = index_ste(index, from, length);
 	if(ste > 30000) {
-		free(signal);
 		return 1;
 	}
 	if(ste > 10000) {
-		free(signal);
 		return 2;
 	}
 		
-	free(signal);
 	return 0;
 }
 
-int is_sil_zc(short* array, int length)
+int is_sil_zc(const struct Feature_Index* index, int from, int length)
 {
 	float n = 0;
 	float zc = 0;
 	for(int i = 0; i < length - glbl_window_width; i+=glbl_window_width) {
-		zc += favg_cross_rate(&array[i], glbl_window_width);
+		int crossings = index_crossings(index, from + i, glbl_window_width);
+		zc += (crossings == 0) ? 0 : (float)crossings / (glbl_window_width - 1);
 		n++;
 	}
 	zc /= n;
@@ -1422,11 +1482,11 @@ int is_sil_zc(short* array, int length)
 	return 0;
 }
 
-int is_sil_flat(short* array, int length)
+int is_sil_flat(const struct Feature_Index* index, int from, int length)
 {
 	float* sig = (float*)calloc(length, sizeof(float));
 	for(int i = 0; i < length; i++) {
-		sig[i] = array[i];
+		sig[i] = index->signal[from + i];
 	}
 	float flat = flatness(sig, length); 
 	// printf("zc :: %f\n", zc);
@@ -1437,9 +1497,9 @@ int is_sil_flat(short* array, int length)
 	return 0;
 }
 
-int is_sil_db(short* array, int length)
+int is_sil_db(const struct Feature_Index* index, int from, int length)
 {
-
+	const short* array = &index->signal[from];
 	for(int i = 0; i < length - 1; i++) {
 		float amplitude = abs(array[i]) / 32767;
 		if(amplitude == 0)
@@ -1472,21 +1532,27 @@ void clean(void)
 		for(int j = 0; j < phones[i]->size_count; j++) {
 			if(phones[i]->size[j] == 0)
 				continue;
-			free(phones[i]->mfcc[j]);
-			if(DELTA) { 
-				free(phones[i]->mfcc_delta[j]);
-			}
-			if(DELTA_DELTA) {
-				free(phones[i]->mfcc_delta_delta[j]);
-			}
-			if(EXTRA || ZC || STE) {
-				free(phones[i]->feats[j]->zc);
-				free(phones[i]->feats[j]->ste);
-				free(phones[i]->feats[j]->kurtosis);
-				free(phones[i]->feats[j]->entropy);
-				free(phones[i]->feats[j]);
+			// Packed prototypes are freed with the store
+			if(store.mfcc == NULL) {
+				free(phones[i]->mfcc[j]);
+				if(DELTA) { 
+					free(phones[i]->mfcc_delta[j]);
+				}
+				if(DELTA_DELTA) {
+					free(phones[i]->mfcc_delta_delta[j]);
+				}
+				if(EXTRA || ZC || STE) {
+					free(phones[i]->feats[j]->zc);
+					free(phones[i]->feats[j]->ste);
+					free(phones[i]->feats[j]->kurtosis);
+					free(phones[i]->feats[j]->entropy);
+					free(phones[i]->feats[j]);
+				}
 			}
 			free(phones[i]->feats[j]);
+			if(LB) {
+				free_envelope(phones[i]->env[j]);
+			}
 			
 			// free(phones[i]->norm_mfcc[j]);
 			// free(phones[i]->aao_i);
@@ -1499,20 +1565,30 @@ void clean(void)
 			free(phones[i]->raw_time);
 		}
 		free(phones[i]->feats);
-		free(phones[i]->correct);
-		free(phones[i]->error);
-		free(phones[i]->used);
+		if(store.mfcc == NULL) {
+			free(phones[i]->correct);
+			free(phones[i]->error);
+			free(phones[i]->used);
+		}
 		free(phones[i]->size);
 		free(phones[i]->amounts);
 		free(phones[i]->mfcc);
 		free(phones[i]->mfcc_delta);
 		free(phones[i]->mfcc_delta_delta);
 		free(phones[i]->norm_mfcc);
+		if(LB) {
+			free(phones[i]->env);
+		}
 		free(phones[i]->index->name);
 		free(phones[i]->index);
 		free(phones[i]);
 	}
 	free(phones);
+	free_store();
+	free_dct_plans();
+	free_fft_plans();
+	free_mel_banks();
+	free_hanning_tables();
 	return;
 }
 
@@ -1991,6 +2067,32 @@ void normal_all(void)
 	return;
 }
 
+/** 
+ * \brief Builds the lower bound envelope of every MFCC, once they are final
+ * 
+ */
+void envelope_all(void)
+{
+	int trunc = floor((glbl_banks) * glbl_test_trunc);
+	for(int i = 1; i < num_ph; i++) {
+		phones[i]->env = (struct Envelope**)calloc(phones[i]->size_count, sizeof(struct Envelope*));
+		if(phones[i]->env == NULL) {
+			printf("Envelope allocation failed\n");
+			exit(-1);
+		}
+		for(int j = 0; j < phones[i]->size_count; j++) {
+			if(phones[i]->size[j] == 0)
+				continue;
+			phones[i]->env[j] = envelope(phones[i]->mfcc[j], phones[i]->size[j], trunc);
+			if(phones[i]->env[j] == NULL) {
+				printf("Envelope allocation failed\n");
+				exit(-1);
+			}
+		}
+	}
+	return;
+}
+
 /** 
  * \brief Produces standard (non-boundary) tests output to the user
  * 
@@ -2051,6 +2153,16 @@ void std_test_output(void)
 	}
 	
 	printf("::         RESULTS        ::            ::  %.2f%% : %.2f%% : %.2f : %.2f%%\n", per, sil_per, no_win, zero_per);
+	if(ABANDON) {
+		printf("::        ABANDONED       ::            ::  %ld\n", abandoned);
+	}
+	if(LB) {
+		printf("::     LB_KIM PRUNED      ::            ::  %ld\n", lb_kim_pruned);
+		printf("::    LB_KEOGH PRUNED     ::            ::  %ld\n", lb_keogh_pruned);
+	}
+	if(VERIFY && (ABANDON || LB)) {
+		printf("::    BOUNDS MISMATCHED   ::            ::  %ld\n", mismatched);
+	}
 
 	return;
 }
@@ -2109,12 +2221,39 @@ void handle_argv(int argc, char* argv[])
 				glbl_group_k = strtol(argv[i + 1], &end_ptr, 10); i++;
 			} else if(strcmp(argv[i], "voice_k") == 0) {
 				glbl_voice_k = strtol(argv[i + 1], &end_ptr, 10); i++;
+			} else if(strcmp(argv[i], "threads") == 0) {
+				glbl_test_threads = strtol(argv[i + 1], &end_ptr, 10); i++;
+				if(glbl_test_threads <= 0) {
+					glbl_test_threads = 1;
+				}
+			} else if(strcmp(argv[i], "resample") == 0) {
+				glbl_resample = strtol(argv[i + 1], &end_ptr, 10); i++;
+				if(glbl_resample < RESAMPLE_INSERT || glbl_resample > RESAMPLE_CUBIC) {
+					printf("resample must be 0 (insert), 1 (linear) or 2 (cubic)\n");
+					exit(-1);
+				}
+			} else if(strcmp(argv[i], "mfcc_threads") == 0) {
+				glbl_mfcc_threads = strtol(argv[i + 1], &end_ptr, 10); i++;
 			} else if(strcmp(argv[i], "frame_limit") == 0) {
 				glbl_frame_limit = strtol(argv[i + 1], &end_ptr, 10); i++;
 			} else if(strcmp(argv[i], "DELTA") == 0) {
 				DELTA = 1;
 			} else if(strcmp(argv[i], "DELTA_DELTA") == 0) {
 				DELTA_DELTA = 1;
+			} else if(strcmp(argv[i], "FUSED") == 0) {
+				FUSED = 1;
+			} else if(strcmp(argv[i], "ABANDON") == 0) {
+				ABANDON = 1;
+			} else if(strcmp(argv[i], "ORDER") == 0) {
+				ORDER = 1;
+			} else if(strcmp(argv[i], "LB") == 0) {
+				LB = 1;
+			} else if(strcmp(argv[i], "VERIFY") == 0) {
+				VERIFY = 1;
+			} else if(strcmp(argv[i], "delta_weight") == 0) {
+				glbl_delta_weight = strtof(argv[i + 1], &end_ptr); i++;
+			} else if(strcmp(argv[i], "delta_delta_weight") == 0) {
+				glbl_delta_delta_weight = strtof(argv[i + 1], &end_ptr); i++;
 			} else if(strcmp(argv[i], "GROUP") == 0) {
 				GROUP = 1;
 			} else if(strcmp(argv[i], "GRAM") == 0) {
@@ -2141,6 +2280,14 @@ void handle_argv(int argc, char* argv[])
 				THREAD = 1;
 			} else if(strcmp(argv[i], "EXPORT") == 0) {
 				EXPORT = 1;
+			} else if(strcmp(argv[i], "CORPUS") == 0) {
+				CORPUS = 1;
+			} else if(strcmp(argv[i], "PACK_CORPUS") == 0) {
+				PACK_CORPUS = 1;
+			} else if(strcmp(argv[i], "SAVE_MODEL") == 0) {
+				glbl_save_model = argv[i + 1]; i++;
+			} else if(strcmp(argv[i], "LOAD_MODEL") == 0) {
+				glbl_load_model = argv[i + 1]; i++;
 			} else if(strcmp(argv[i], "trunc") == 0) {
 				glbl_test_trunc = strtol(argv[i + 1], &end_ptr, 10); i++;
 			} else if(strcmp(argv[i], "EXTRA") == 0) {
@@ -2253,62 +2400,147 @@ void pca(void)
 	return;
 }
 
+/**
+ * \struct Mfcc_Worker
+ * \brief An MFCC thread, its extractor, the number of MFCCs it created and the shared task lists
+ * @tasks The (phoneme, signal) pairs, each taken by one worker through @next_task
+ * @next_phone The next phoneme to finish once every task is done, see \fn finish_mfccs()
+ */
+struct Mfcc_Worker {
+	pthread_t thread;
+	struct Mfcc_Plan* plan;
+	int created;
+	int (*tasks)[2];
+	int task_count;
+	atomic_int* next_task;
+	atomic_int* next_phone;
+	pthread_barrier_t* barrier;
+};
+
 /** 
- * \brief Generates a thread for each phoneme to produce all MFCCs for that phoneme
+ * \brief Allocates every phoneme and lists one task for each of its raw data signals
+ * 
+ * @param task_count Set to the amount of tasks
  * 
+ * @return The tasks as (phoneme, signal) pairs
  */
-void threaded_mfccs(void)
+static int (*mfcc_tasks(int* task_count))[2]
 {
-	pthread_mutex_init(&lock, NULL);
-	pthread_t* threads = calloc(num_ph, sizeof(pthread_t));
-	int* values = (int*)calloc(num_ph, sizeof(int));
-
+	int count = 0;
 	for(int i = 1; i < num_ph; i++) {
-		values[i] = i;
-		int err = pthread_create(&threads[i], NULL, create_mfcc, (void *)&values[i]);
-		if(err) {
-			printf("Cluster thread error, exiting...\n");
+		prepare_mfccs(i);
+		count += phones[i]->size_count;
+	}
+	int (*tasks)[2] = malloc(sizeof(int[2]) * (count + 1));
+	int t = 0;
+	for(int i = 1; i < num_ph; i++) {
+		for(int j = 0; j < phones[i]->size_count; j++) {
+			tasks[t][0] = i;
+			tasks[t][1] = j;
+			t++;
+		}
+	}
+	*task_count = count;
+	return tasks;
+}
+
+static void mfcc_progress(int created)
+{
+	if(created % 1000 == 0) {
+		printf("::         MFCC P#        ::  %02d:%02d:%02d  ::  %05d\n", hour(difftime(time(NULL), start)), minu(difftime(time(NULL), start)), seco(difftime(time(NULL), start)), created);
+	}
+}
+
+static void* mfcc_worker(void* argv)
+{
+	struct Mfcc_Worker* worker = (struct Mfcc_Worker*)argv;
+	mask_sig();
+	int t = 0;
+	while((t = atomic_fetch_add(worker->next_task, 1)) < worker->task_count) {
+		create_mfcc(worker->tasks[t][0], worker->tasks[t][1], worker->plan);
+		worker->created++;
+		mfcc_progress(t + 1);
+	}
+	pthread_barrier_wait(worker->barrier);
+	int i = 0;
+	while((i = atomic_fetch_add(worker->next_phone, 1)) < num_ph) {
+		finish_mfccs(i);
+	}
+	return NULL;
+}
+
+/** 
+ * \brief Produces all MFCCs with a pool of \var glbl_mfcc_threads workers
+ * 
+ * Each raw data signal is a task of its own, so a phoneme with many signals is shared among all workers
+ * rather than setting the time taken. Once every task is done the workers finish one phoneme at a time.
+ */
+void threaded_mfccs(void)
+{
+	int pool = glbl_mfcc_threads;
+	if(pool <= 0) {
+		pool = max(1, sysconf(_SC_NPROCESSORS_ONLN));
+	}
+	int task_count = 0;
+	int (*tasks)[2] = mfcc_tasks(&task_count);
+	atomic_int next_task = 0;
+	atomic_int next_phone = 1;
+	pthread_barrier_t barrier;
+	pthread_barrier_init(&barrier, NULL, pool);
+	struct Mfcc_Worker* workers = (struct Mfcc_Worker*)malloc(sizeof(struct Mfcc_Worker) * pool);
+	for(int w = 0; w < pool; w++) {
+		workers[w].plan = default_mfcc_plan();
+		if(workers[w].plan == NULL) {
+			exit(-1);
+		}
+		workers[w].created = 0;
+		workers[w].tasks = tasks;
+		workers[w].task_count = task_count;
+		workers[w].next_task = &next_task;
+		workers[w].next_phone = &next_phone;
+		workers[w].barrier = &barrier;
+		if(pthread_create(&workers[w].thread, NULL, mfcc_worker, &workers[w]) != 0) {
+			printf("MFCC thread error, exiting...\n");
 			exit(-1);
 		}
 	}
-	for(int j = 1; j < num_ph; j++) {
-		int err = pthread_join(threads[j], NULL);
-		if (err) {
+	for(int w = 0; w < pool; w++) {
+		if(pthread_join(workers[w].thread, NULL) != 0) {
 			printf("Thread join failed\n");
 			exit(-1);
 		}
+		mfcced += workers[w].created;
+		free_mfcc_plan(workers[w].plan);
 	}
-	free(threads);
-	free(values);
+	pthread_barrier_destroy(&barrier);
+	free(workers);
+	free(tasks);
 
 	return;
 }
 
 /** 
- * \brief Generates a thread for each phoneme to produce all MFCCs for that phoneme, only one thread is used.
+ * \brief Produces all MFCCs on the calling thread
  * 
  */
 void non_threaded_mfccs(void)
 {
-	pthread_mutex_init(&lock, NULL);
-	pthread_t* threads = calloc(num_ph, sizeof(pthread_t));
-	int* values = (int*)calloc(num_ph, sizeof(int));
-
+	int task_count = 0;
+	int (*tasks)[2] = mfcc_tasks(&task_count);
+	struct Mfcc_Plan* plan = default_mfcc_plan();
+	if(plan == NULL) {
+		exit(-1);
+	}
+	for(int t = 0; t < task_count; t++) {
+		create_mfcc(tasks[t][0], tasks[t][1], plan);
+		mfcced++;
+		mfcc_progress(mfcced);
+	}
 	for(int i = 1; i < num_ph; i++) {
-		values[i] = i;
-		int err = pthread_create(&threads[i], NULL, create_mfcc, (void *)&values[i]);
-		if(err) {
-			printf("Cluster thread error, exiting...\n");
-			exit(-1);
-		}
-		err = pthread_join(threads[i], NULL);
-		if (err) {
-			printf("Thread join failed\n");
-			exit(-1);
-		}
+		finish_mfccs(i);
 	}
-	free(threads);
-	free(values);
+	free_mfcc_plan(plan);
+	free(tasks);
 
 	return;
 }
@@ -61,14 +61,116 @@ struct Phoneme {
 	float** raw_time;
 	int* raw_sizes;
 	int raw_count;
+	struct Envelope** env;
 } ph;
 
+/**
+ * \struct Dtw_Workspace
+ * \brief A reusable DTW cost matrix which only stores the Sakoe-Chiba band
+ * @cells The band storage, @rows rows of @stride doubles in one allocation
+ * @capacity The amount of doubles allocated for @cells
+ * @rows The amount of rows kept; \def DTW_ROLLING keeps the current and previous row only
+ * @stride The width of a stored row; the band of 2w + 1 plus a guard cell either side
+ * @w The window limit the band was sized for
+ * @phone_length The length of the compared phoneme in frames
+ *
+ * The workspace is owned by the caller and reused across prototypes and tests so that no
+ * allocation is made per comparison once it has grown to the largest window.
+ */
+struct Dtw_Workspace {
+	double* cells;
+	size_t capacity;
+	int rows;
+	int stride;
+	int w;
+	int phone_length;
+};
+
+/**
+ * \struct Test_Features
+ * \brief The features of a test sequence, computed once per test and shared read-only by every DTW and KNN comparison
+ * @mfcc The test's MFCC, normalised when \var NORM is set
+ * @delta The delta coefficients of @mfcc, NULL unless \var DELTA is set
+ * @delta_delta The delta-delta coefficients, NULL unless \var DELTA_DELTA is set
+ * @zc The zero cross of each window
+ * @ste The short time energy of each window
+ * @kurtosis The kurtosis of each window
+ * @flatness The flatness of each window
+ * @length The length of the test sequence in samples
+ * @mfcc_length The length of @mfcc, and of the deltas, as a 1D array
+ * @windows The amount of windows in @zc, @ste, @kurtosis and @flatness
+ * @min,@max The extremes of each coefficient of @mfcc used by \fn lb_kim(), NULL unless \var LB is set
+ */
+struct Test_Features {
+	float* mfcc;
+	float* delta;
+	float* delta_delta;
+	float* zc;
+	float* ste;
+	float* kurtosis;
+	float* flatness;
+	float* min;
+	float* max;
+	int length;
+	int mfcc_length;
+	int windows;
+};
+
+/**
+ * \struct Score_Context
+ * \brief The state of one test worker, so that tests may be classified in parallel by \fn test()
+ * @ws The worker's DTW workspace
+ * @score The score of each phoneme for the current test
+ * @used,@correct,@error Each prototype's use and accuracy counts, indexed as phones[i]->used[j]
+ * @matrix,@per_correct The worker's phoneme confusion matrix and tests per phoneme
+ * @group_matrix,@voice_matrix The worker's group and voice confusion matrices
+ * @failed,@dtw_error Set when DTW could not be performed for the current test
+ * @tested,@n_correct,@fails,@group,@zero_fails The worker's test counts
+ * @mfcc The worker's MFCC extractor
+ *
+ * Everything but @ws, @score and @mfcc is added to the global results by \fn merge_score_context().
+ */
+struct Score_Context {
+	struct Dtw_Workspace ws;
+	struct Mfcc_Plan* mfcc;
+	double* score;
+	int** used;
+	float** correct;
+	float** error;
+	int** matrix;
+	float* per_correct;
+	int group_matrix[7][7];
+	int voice_matrix[3][3];
+	short failed;
+	int dtw_error;
+	int tested;
+	int n_correct;
+	int fails;
+	int group;
+	int zero_fails;
+	long abandoned;
+	long lb_kim_pruned;
+	long lb_keogh_pruned;
+	long mismatched;
+	long double total_test_time;
+	long double total_dtw_tests;
+};
+
+#define DTW_ROLLING 2
+/* Column j of row i within a row returned by \fn dtw_workspace_row() */
+#define BAND(row, i, j, w) ((row)[(j) - (i) + (w) + 1])
+
 #include "../Training/train.h"
 #include "../Misc/realloc.h"
 #include "../Testing/test.h"
 #include "../Feature_Extraction/paa.h"
 #include "../Feature_Extraction/mfcc.h"
 #include "../Feature_Extraction/delta.h"
+#include "distance.h"
+#include "lower_bound.h"
+#include "prototypes.h"
+#include "../Seperation/feature_index.h"
+#include "model.h"
 
 #define PTHREAD_CANCELED ((void *) -1)
 
@@ -88,6 +190,11 @@ extern int glbl_test_iter;
 extern int glbl_group_k;
 extern int glbl_voice_k;
 extern int glbl_frame_limit;
+extern int glbl_test_threads;
+extern int glbl_mfcc_threads;
+extern char* glbl_save_model;
+extern char* glbl_load_model;
+extern int glbl_resample;
 
 extern int glbl_zc_incr;
 extern int glbl_ste_incr;
@@ -99,10 +206,16 @@ extern int glbl_larg_ste_incr;
 
 extern int DELTA;
 extern int DELTA_DELTA;
+extern int FUSED;
+extern int ABANDON;
+extern int ORDER;
+extern int LB;
+extern int VERIFY;
+extern float glbl_delta_weight;
+extern float glbl_delta_delta_weight;
 extern float glbl_test_trunc;
 
 #define NO_SIG_LEN 1
-extern int DTW_ERROR;
 extern int SIMPLE;
 extern int MALE;
 extern int FEMALE;
@@ -129,7 +242,11 @@ extern int STRT;
 extern int CAR;
 extern int CAFE;
 extern int SPLIT_DATA;
+extern int CORPUS;
 extern int SVM;
+extern int AVG;
+extern int MEAN_SIZE;
+extern int RAW;
 
 // Testing externs 
 extern float* aaomfcc;
@@ -137,14 +254,15 @@ extern int aaomfcc_length;
 extern double against_all[];
 
 // Output globals
-extern double best_so_far;
-extern short failed;
 extern int trained;
 extern int tested;
+extern int mfcced;
 extern time_t start;
 
 extern long double total_test_time;
 extern long double total_dtw_tests;
+extern long abandoned;
+extern long mismatched;
 
 extern pthread_t* threads;
 extern int thread_count;
@@ -157,23 +275,28 @@ void dtw_test(float* signal, float* sequence, int signal_length, int signal_leng
 int seco(long time);
 int minu(long time);
 int hour(long time);
-int is_sil(short* array, int length);
-void dtw_frame(float** signal, int signal_length, struct Phoneme* phoneme, short limit);
+int is_sil(const struct Feature_Index* index, int from, int length);
+void dtw_frame(const struct Test_Features* test, struct Phoneme* phoneme, short limit, struct Score_Context* ctx);
 int min(int a, int b);
 int max(int a, int b);
 void interrupt_handler (int signo);
-int is_sil_db(short* array, int length);
-int is_sil_mean(short* array, int length);
-void dtw_clust(float** signal, int signal_length, struct Phoneme* phoneme, short limit);
+int is_sil_db(const struct Feature_Index* index, int from, int length);
+int is_sil_mean(const struct Feature_Index* index, int from, int length);
+void dtw_clust(const struct Test_Features* test, struct Phoneme* phoneme, short limit, struct Score_Context* ctx);
 void mask_sig(void);
-double dtw_frame_result(float* signal, int signal_length, struct Phoneme* phoneme, int p, short limit);
-double dtw_clust_result(float* signal, int signal_length, struct Phoneme* phoneme, int t, int clust, short limit);
-double dtw_frame_result_group(float** signal, int signal_length, struct Phoneme* phoneme, int p, short limit);
-double dtw_frame_result_group_time(float* signal, int signal_length, struct Phoneme* phoneme, int p, short limit);
-int is_sil_zc(short* array, int length);
-int is_sil_ste(short* array, int length);
-int is_sil_flat(short* array, int length);
-int is_sil_ste_chunk(short* array, int length);
+double dtw_frame_result(const struct Test_Features* test, struct Phoneme* phoneme, int p, short limit, struct Score_Context* ctx);
+double dtw_frame_result_bounded(const struct Test_Features* test, struct Phoneme* phoneme, int p, short limit, struct Score_Context* ctx, double cutoff);
+double dtw_clust_result(const struct Test_Features* test, struct Phoneme* phoneme, int t, int clust, short limit, struct Score_Context* ctx);
+double dtw_frame_result_group(const struct Test_Features* test, struct Phoneme* phoneme, int p, short limit, struct Score_Context* ctx);
+double dtw_frame_result_group_time(float* signal, int signal_length, struct Phoneme* phoneme, int p, short limit, struct Score_Context* ctx);
+void dtw_workspace_begin(struct Dtw_Workspace* ws, int rows, int phone_length, int w);
+double* dtw_workspace_row(struct Dtw_Workspace* ws, int i);
+double* dtw_workspace_next_row(struct Dtw_Workspace* ws, int i);
+void dtw_workspace_free(struct Dtw_Workspace* ws);
+int is_sil_zc(const struct Feature_Index* index, int from, int length);
+int is_sil_ste(const struct Feature_Index* index, int from, int length);
+int is_sil_flat(const struct Feature_Index* index, int from, int length);
+int is_sil_ste_chunk(const struct Feature_Index* index, int from, int length);
 
 
 #endif
@@ -0,0 +1,138 @@
+/**
+ * @file   lower_bound.c
+ * @brief  LB_Kim and LB_Keogh for the L1 frame cost of \fn dtw_frame_result()
+ *
+ * The bounds are ordered by cost. \fn lb_kim() only looks at the first and last frames and
+ * the extremes of each coefficient, \fn lb_keogh() looks at every test frame against the
+ * prototype's envelope. Differences are taken in float as \fn frame_distance() does, so each
+ * term never exceeds the cost of the cell it stands in for.
+ */
+
+#include "dtw.h"
+
+long lb_kim_pruned   = 0; /* The number of prototypes pruned by \fn lb_kim() */
+long lb_keogh_pruned = 0; /* The number of prototypes pruned by \fn lb_keogh() */
+
+/**
+ * \brief Finds the smallest and largest value of each coefficient over frames 1 onwards
+ * @size The length of @mfcc as a 1D array
+ * @min,@max Filled with trunc values each
+ */
+void mfcc_extremes(const float* mfcc, int size, int trunc, float* min, float* max)
+{
+	int frames = size / trunc;
+	for(int m = 0; m < trunc; m++) {
+		min[m] = FLT_MAX;
+		max[m] = -FLT_MAX;
+	}
+	for(int i = 1; i < frames; i++) {
+		for(int m = 0; m < trunc; m++) {
+			min[m] = fminf(min[m], mfcc[i * trunc + m]);
+			max[m] = fmaxf(max[m], mfcc[i * trunc + m]);
+		}
+	}
+}
+
+/**
+ * \brief Builds the envelope of a prototype MFCC for the window used against a test of the same length
+ * @size The length of @mfcc as a 1D array
+ * @return The envelope, or NULL if it could not be allocated
+ */
+struct Envelope* envelope(const float* mfcc, int size, int trunc)
+{
+	int frames = size / trunc;
+	float win = (float)glbl_dtw_window / 1000;
+	struct Envelope* env = (struct Envelope*)malloc(sizeof(struct Envelope));
+	if(env == NULL) {
+		return NULL;
+	}
+	env->w = floor(win * (float)frames);
+	env->upper = (float*)calloc(size, sizeof(float));
+	env->lower = (float*)calloc(size, sizeof(float));
+	env->min = (float*)malloc(sizeof(float) * trunc);
+	env->max = (float*)malloc(sizeof(float) * trunc);
+	if(env->upper == NULL || env->lower == NULL || env->min == NULL || env->max == NULL) {
+		free_envelope(env);
+		return NULL;
+	}
+	for(int i = 1; i < frames; i++) {
+		float* upper = &env->upper[i * trunc];
+		float* lower = &env->lower[i * trunc];
+		for(int m = 0; m < trunc; m++) {
+			upper[m] = -FLT_MAX;
+			lower[m] = FLT_MAX;
+		}
+		for(int j = max(1, i - env->w); j <= min(frames - 1, i + env->w); j++) {
+			for(int m = 0; m < trunc; m++) {
+				upper[m] = fmaxf(upper[m], mfcc[j * trunc + m]);
+				lower[m] = fminf(lower[m], mfcc[j * trunc + m]);
+			}
+		}
+	}
+	mfcc_extremes(mfcc, size, trunc, env->min, env->max);
+	return env;
+}
+
+void free_envelope(struct Envelope* env)
+{
+	if(env == NULL) {
+		return;
+	}
+	free(env->upper);
+	free(env->lower);
+	free(env->min);
+	free(env->max);
+	free(env);
+}
+
+/**
+ * \brief LB_Kim, the first and last cells of the path and the extremes of each coefficient
+ * @mfcc The prototype, of the same length as the test
+ *
+ * For each coefficient the path must pay at least the first and last cell, and the gap between
+ * the test's and prototype's largest and smallest values, whichever is the most.
+ */
+double lb_kim(const struct Test_Features* test, const float* mfcc, const struct Envelope* env, int trunc)
+{
+	int frames = test->mfcc_length / trunc;
+	int last = (frames - 1) * trunc;
+	double bound = 0;
+	if(frames < 2) {
+		return 0;
+	}
+	for(int m = 0; m < trunc; m++) {
+		double ends = fabs(test->mfcc[trunc + m] - mfcc[trunc + m]);
+		if(frames > 2) {
+			ends += fabs(test->mfcc[last + m] - mfcc[last + m]);
+		}
+		double extremes = fmax(fabs(test->max[m] - env->max[m]), fabs(test->min[m] - env->min[m]));
+		bound += fmax(ends, extremes);
+	}
+	return bound;
+}
+
+/**
+ * \brief LB_Keogh, the distance of each test frame from the prototype's envelope
+ * @cutoff The bound is returned as soon as it exceeds @cutoff
+ */
+double lb_keogh(const struct Test_Features* test, const struct Envelope* env, int trunc, double cutoff)
+{
+	int frames = test->mfcc_length / trunc;
+	double bound = 0;
+	for(int i = 1; i < frames; i++) {
+		const float* x = &test->mfcc[i * trunc];
+		const float* upper = &env->upper[i * trunc];
+		const float* lower = &env->lower[i * trunc];
+		for(int m = 0; m < trunc; m++) {
+			if(x[m] > upper[m]) {
+				bound += x[m] - upper[m];
+			} else if(x[m] < lower[m]) {
+				bound += lower[m] - x[m];
+			}
+		}
+		if(bound > cutoff) {
+			break;
+		}
+	}
+	return bound;
+}
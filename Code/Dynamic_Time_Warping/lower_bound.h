@@ -0,0 +1,41 @@
+#ifndef LOWER_BOUND_H
+#define LOWER_BOUND_H
+
+/**
+ * @file   lower_bound.h
+ * @brief  Cheap lower bounds on the MFCC cost of \fn dtw_frame_result() used to prune KNN prototypes
+ *
+ * Both bounds only hold when the test and prototype have the same amount of frames, as the
+ * window w and the final cell of the warping path are then known. Every row and column from
+ * frame 1 onwards is crossed by the path, so each bound sums a cost which the path can not avoid.
+ */
+
+struct Test_Features;
+
+/**
+ * \struct Envelope
+ * \brief The precomputed features of a prototype MFCC used by the lower bounds
+ * @upper The largest value of each coefficient within the window of each frame
+ * @lower The smallest value of each coefficient within the window of each frame
+ * @min The smallest value of each coefficient over frames 1 onwards
+ * @max The largest value of each coefficient over frames 1 onwards
+ * @w The window the envelope was built for
+ */
+struct Envelope {
+	float* upper;
+	float* lower;
+	float* min;
+	float* max;
+	int w;
+};
+
+struct Envelope* envelope(const float* mfcc, int size, int trunc);
+void free_envelope(struct Envelope* env);
+void mfcc_extremes(const float* mfcc, int size, int trunc, float* min, float* max);
+double lb_kim(const struct Test_Features* test, const float* mfcc, const struct Envelope* env, int trunc);
+double lb_keogh(const struct Test_Features* test, const struct Envelope* env, int trunc, double cutoff);
+
+extern long lb_kim_pruned;
+extern long lb_keogh_pruned;
+
+#endif
@@ -0,0 +1,386 @@
+/**
+ * @file   model.c
+ * @brief  Saving and loading the trained model with SAVE_MODEL and LOAD_MODEL
+ *
+ * A snapshot is a \struct Model_Header followed by the payload, written in native byte order. The
+ * payload holds the training ranges, the normalisation ranges, then for each phoneme its sizes, MFCCs,
+ * deltas, features and raw signals. A snapshot is mapped read-only when loaded, its checksum checked,
+ * and each array copied out so the model is owned and freed as a trained one is.
+ */
+
+#include <fcntl.h>
+#include <sys/mman.h>
+
+#include "dtw.h"
+
+#define FNV_OFFSET 14695981039346656037ULL
+#define FNV_PRIME  1099511628211ULL
+
+/**
+ * \struct Model_Writer
+ * \brief A snapshot being written
+ * @size,@hash The amount of payload bytes written and their FNV-1a hash
+ * @failed Set if any write failed
+ */
+struct Model_Writer {
+	FILE* fp;
+	uint64_t size;
+	uint64_t hash;
+	int failed;
+};
+
+/**
+ * \struct Model_Reader
+ * \brief The unread part of a mapped payload
+ * @failed Set if a read went past @end
+ */
+struct Model_Reader {
+	const unsigned char* at;
+	const unsigned char* end;
+	int failed;
+};
+
+static uint64_t fnv1a(uint64_t hash, const unsigned char* data, size_t size)
+{
+	for(size_t i = 0; i < size; i++) {
+		hash ^= data[i];
+		hash *= FNV_PRIME;
+	}
+	return hash;
+}
+
+/**
+ * @brief The parameters a model depends on, compared when it is loaded
+ */
+static void model_params(int32_t* params)
+{
+	memset(params, 0, sizeof(int32_t) * 20);
+	params[0] = num_ph;
+	params[1] = glbl_banks;
+	params[2] = glbl_window_width;
+	params[3] = glbl_paa_op;
+	params[4] = glbl_paa;
+	params[5] = glbl_interval_div;
+	params[6] = glbl_nfft;
+	params[7] = glbl_mfcc_num;
+	params[8] = floor(glbl_banks * glbl_test_trunc);
+	params[9] = glbl_frame_limit;
+	params[10] = DELTA;
+	params[11] = DELTA_DELTA;
+	params[12] = LOG_E;
+	params[13] = AVG;
+	params[14] = MEAN_SIZE;
+	params[15] = (EXTRA || ZC || STE);
+	params[16] = RAW;
+	params[17] = MALE + 2 * FEMALE + 3 * SPKR1 + 4 * SPKR1_NOSIL;
+	params[18] = sizeof(long double);
+	params[19] = glbl_resample;
+}
+
+static const char* param_names[] = {"phonemes", "banks", "window", "paa_op", "paa", "interval_div", "nfft", "mfccs", "trunc", "frame_limit",
+				    "DELTA", "DELTA_DELTA", "LOG_E", "AVG", "MEAN_SIZE", "EXTRA/ZC/STE", "RAW", "dataset", "long double", "resample"};
+
+static void put(struct Model_Writer* mw, const void* data, size_t size)
+{
+	if(size == 0 || mw->failed) {
+		return;
+	}
+	if(fwrite(data, 1, size, mw->fp) != size) {
+		mw->failed = 1;
+		return;
+	}
+	mw->hash = fnv1a(mw->hash, data, size);
+	mw->size += size;
+}
+
+static void take(struct Model_Reader* mr, void* out, size_t size)
+{
+	if(mr->failed || size > (size_t)(mr->end - mr->at)) {
+		mr->failed = 1;
+		memset(out, 0, size);
+		return;
+	}
+	memcpy(out, mr->at, size);
+	mr->at += size;
+}
+
+/**
+ * @brief Copies @param count values of @param size bytes out of the snapshot
+ *
+ * @return The allocated values, NULL if @param count is 0 or the snapshot is too short
+ */
+static void* take_array(struct Model_Reader* mr, int count, size_t size)
+{
+	if(count <= 0) {
+		return NULL;
+	}
+	void* out = malloc(size * count);
+	if(out == NULL) {
+		printf("Failed to malloc %d values when loading the model\n", count);
+		mr->failed = 1;
+		return NULL;
+	}
+	take(mr, out, size * count);
+	return out;
+}
+
+static void put_phone(struct Model_Writer* mw, struct Phoneme* phone)
+{
+	int feats = (EXTRA || ZC || STE);
+	put(mw, &phone->size_count, sizeof(int));
+	put(mw, &phone->trained, sizeof(long double));
+	put(mw, phone->amounts, sizeof(int) * phone->size_count);
+	put(mw, phone->size, sizeof(int) * phone->size_count);
+	for(int j = 0; j < phone->size_count; j++) {
+		if(phone->size[j] == 0) {
+			continue;
+		}
+		put(mw, phone->mfcc[j], sizeof(float) * phone->size[j]);
+		if(DELTA) {
+			put(mw, phone->mfcc_delta[j], sizeof(float) * phone->size[j]);
+		}
+		if(DELTA_DELTA) {
+			put(mw, phone->mfcc_delta_delta[j], sizeof(float) * phone->size[j]);
+		}
+		put(mw, &phone->feats[j]->coeffs, sizeof(int));
+		if(feats) {
+			put(mw, phone->feats[j]->zc, sizeof(float) * phone->feats[j]->coeffs);
+			put(mw, phone->feats[j]->ste, sizeof(float) * phone->feats[j]->coeffs);
+			put(mw, phone->feats[j]->kurtosis, sizeof(float) * phone->feats[j]->coeffs);
+			put(mw, phone->feats[j]->entropy, sizeof(float) * phone->feats[j]->coeffs);
+		}
+	}
+	if(RAW) {
+		put(mw, &phone->raw_count, sizeof(int));
+		put(mw, phone->raw_sizes, sizeof(int) * phone->raw_count);
+		for(int m = 0; m < phone->raw_count; m++) {
+			put(mw, phone->raw_time[m], sizeof(float) * phone->raw_sizes[m]);
+		}
+	}
+}
+
+/**
+ * @brief Reads a phoneme written by \fn put_phone(), allocating it as \fn prepare_mfccs() and \fn create_mfcc() do
+ */
+static void take_phone(struct Model_Reader* mr, struct Phoneme* phone)
+{
+	int feats = (EXTRA || ZC || STE);
+	int count = 0;
+	take(mr, &count, sizeof(int));
+	if(mr->failed || count < 0) {
+		mr->failed = 1;
+		return;
+	}
+	free(phone->size);
+	free(phone->amounts);
+	phone->size_count = count;
+	phone->reduced_count = count;
+	take(mr, &phone->trained, sizeof(long double));
+	phone->amounts = (int*)calloc(count + 1, sizeof(int));
+	phone->size = (int*)calloc(count + 1, sizeof(int));
+	phone->mfcc = (float**)calloc(count + 1, sizeof(float*));
+	phone->mfcc_delta = (float**)calloc(count + 1, sizeof(float*));
+	phone->mfcc_delta_delta = (float**)calloc(count + 1, sizeof(float*));
+	phone->norm_mfcc = (float**)calloc(count + 1, sizeof(float*));
+	phone->feats = (struct Feature_Set**)calloc(count + 1, sizeof(struct Feature_Set*));
+	phone->used = (int*)calloc(count + 1, sizeof(int));
+	phone->correct = (float*)calloc(count + 1, sizeof(float));
+	phone->error = (float*)calloc(count + 1, sizeof(float));
+	if(phone->amounts == NULL || phone->size == NULL || phone->mfcc == NULL || phone->mfcc_delta == NULL || phone->mfcc_delta_delta == NULL || phone->norm_mfcc == NULL ||
+	   phone->feats == NULL || phone->used == NULL || phone->correct == NULL || phone->error == NULL) {
+		printf("Failed to malloc phoneme %s when loading the model\n", phone->index->name);
+		mr->failed = 1;
+		return;
+	}
+	take(mr, phone->amounts, sizeof(int) * count);
+	take(mr, phone->size, sizeof(int) * count);
+	for(int j = 0; j < count && !mr->failed; j++) {
+		phone->feats[j] = (struct Feature_Set*)calloc(1, sizeof(struct Feature_Set));
+		if(phone->feats[j] == NULL || phone->size[j] < 0) {
+			mr->failed = 1;
+			return;
+		}
+		if(phone->size[j] == 0) {
+			continue;
+		}
+		phone->mfcc[j] = (float*)take_array(mr, phone->size[j], sizeof(float));
+		if(DELTA) {
+			phone->mfcc_delta[j] = (float*)take_array(mr, phone->size[j], sizeof(float));
+		}
+		if(DELTA_DELTA) {
+			phone->mfcc_delta_delta[j] = (float*)take_array(mr, phone->size[j], sizeof(float));
+		}
+		take(mr, &phone->feats[j]->coeffs, sizeof(int));
+		if(feats) {
+			phone->feats[j]->zc = (float*)take_array(mr, phone->feats[j]->coeffs, sizeof(float));
+			phone->feats[j]->ste = (float*)take_array(mr, phone->feats[j]->coeffs, sizeof(float));
+			phone->feats[j]->kurtosis = (float*)take_array(mr, phone->feats[j]->coeffs, sizeof(float));
+			phone->feats[j]->entropy = (float*)take_array(mr, phone->feats[j]->coeffs, sizeof(float));
+		}
+	}
+	if(RAW && !mr->failed) {
+		take(mr, &phone->raw_count, sizeof(int));
+		if(phone->raw_count < 0 || phone->raw_count > count) {
+			mr->failed = 1;
+			return;
+		}
+		phone->raw_sizes = (int*)calloc(count + 1, sizeof(int));
+		phone->raw_time = (float**)calloc(phone->raw_count + 1, sizeof(float*));
+		if(phone->raw_sizes == NULL || phone->raw_time == NULL) {
+			mr->failed = 1;
+			return;
+		}
+		take(mr, phone->raw_sizes, sizeof(int) * phone->raw_count);
+		for(int m = 0; m < phone->raw_count; m++) {
+			phone->raw_time[m] = (float*)take_array(mr, phone->raw_sizes[m], sizeof(float));
+		}
+	}
+}
+
+/**
+ * @brief Writes the trained model to @param path
+ *
+ * @return 0 on success, -1 if the snapshot could not be written
+ */
+int save_model(const char* path)
+{
+	struct Model_Header header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, MODEL_MAGIC, sizeof(header.magic));
+	header.version = MODEL_VERSION;
+	header.order = 0x01020304;
+	model_params(header.params);
+
+	struct Model_Writer mw = {fopen(path, "wb"), 0, FNV_OFFSET, 0};
+	if(mw.fp == NULL) {
+		printf("Failed to open '%s' to save the model\n", path);
+		return -1;
+	}
+	if(fwrite(&header, sizeof(header), 1, mw.fp) != 1) {
+		mw.failed = 1;
+	}
+	put(&mw, ph_zc_max, sizeof(float) * num_ph);
+	put(&mw, ph_zc_min, sizeof(float) * num_ph);
+	put(&mw, ste_min, sizeof(float) * num_ph);
+	put(&mw, ste_max, sizeof(float) * num_ph);
+	int sil[2] = {max_sil, min_sil};
+	float sil_ranges[10] = {max_sil_dB, min_sil_dB, max_sil_zc, min_sil_zc, max_sil_flt, min_sil_flt,
+				max_sil_ste, min_sil_ste, max_sil_mean, min_sil_mean};
+	float norm[6] = {min_mfcc, max_mfcc, min_delta, max_delta, min_delta_delta, max_delta_delta};
+	int counts[2] = {trained, mfcced};
+	put(&mw, sil, sizeof(sil));
+	put(&mw, sil_ranges, sizeof(sil_ranges));
+	put(&mw, norm, sizeof(norm));
+	put(&mw, counts, sizeof(counts));
+	for(int i = 1; i < num_ph; i++) {
+		put_phone(&mw, phones[i]);
+	}
+
+	header.payload = mw.size;
+	header.checksum = mw.hash;
+	if(!mw.failed && (fseek(mw.fp, 0, SEEK_SET) != 0 || fwrite(&header, sizeof(header), 1, mw.fp) != 1)) {
+		mw.failed = 1;
+	}
+	if(fclose(mw.fp) != 0 || mw.failed) {
+		printf("Failed to write the model to '%s'\n", path);
+		remove(path);
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * @brief Replaces training with the model saved at @param path
+ *
+ * The phonemes must have been initialised by \fn dtw_init() and not trained.
+ *
+ * @return 0 on success, -1 if the snapshot could not be read, is damaged or was made with other parameters
+ */
+int load_model(const char* path)
+{
+	int fd = open(path, O_RDONLY);
+	if(fd < 0) {
+		printf("Failed to open the model '%s'\n", path);
+		return -1;
+	}
+	struct stat st;
+	if(fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(struct Model_Header)) {
+		printf("The model '%s' is too short\n", path);
+		close(fd);
+		return -1;
+	}
+	const unsigned char* map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if(map == MAP_FAILED) {
+		printf("Failed to map the model '%s'\n", path);
+		return -1;
+	}
+	posix_madvise((void*)map, st.st_size, POSIX_MADV_SEQUENTIAL);
+
+	int result = -1;
+	struct Model_Header header;
+	int32_t params[20];
+	memcpy(&header, map, sizeof(header));
+	model_params(params);
+	if(memcmp(header.magic, MODEL_MAGIC, sizeof(header.magic)) != 0 || header.version != MODEL_VERSION || header.order != 0x01020304) {
+		printf("'%s' is not a version %d model for this host\n", path, MODEL_VERSION);
+		goto end;
+	}
+	if(header.payload != (uint64_t)(st.st_size - sizeof(header))) {
+		printf("The model '%s' is %lld bytes, its header expects %llu\n", path, (long long)st.st_size, (unsigned long long)(header.payload + sizeof(header)));
+		goto end;
+	}
+	for(int p = 0; p < 20; p++) {
+		if(header.params[p] != params[p]) {
+			printf("The model '%s' was trained with %s %d, this run uses %d\n", path, param_names[p], header.params[p], params[p]);
+			goto end;
+		}
+	}
+	struct Model_Reader mr = {map + sizeof(header), map + st.st_size, 0};
+	if(fnv1a(FNV_OFFSET, mr.at, header.payload) != header.checksum) {
+		printf("The model '%s' failed its checksum\n", path);
+		goto end;
+	}
+
+	take(&mr, ph_zc_max, sizeof(float) * num_ph);
+	take(&mr, ph_zc_min, sizeof(float) * num_ph);
+	take(&mr, ste_min, sizeof(float) * num_ph);
+	take(&mr, ste_max, sizeof(float) * num_ph);
+	int sil[2], counts[2];
+	float sil_ranges[10], norm[6];
+	take(&mr, sil, sizeof(sil));
+	take(&mr, sil_ranges, sizeof(sil_ranges));
+	take(&mr, norm, sizeof(norm));
+	take(&mr, counts, sizeof(counts));
+	max_sil = sil[0];
+	min_sil = sil[1];
+	max_sil_dB = sil_ranges[0];
+	min_sil_dB = sil_ranges[1];
+	max_sil_zc = sil_ranges[2];
+	min_sil_zc = sil_ranges[3];
+	max_sil_flt = sil_ranges[4];
+	min_sil_flt = sil_ranges[5];
+	max_sil_ste = sil_ranges[6];
+	min_sil_ste = sil_ranges[7];
+	max_sil_mean = sil_ranges[8];
+	min_sil_mean = sil_ranges[9];
+	min_mfcc = norm[0];
+	max_mfcc = norm[1];
+	min_delta = norm[2];
+	max_delta = norm[3];
+	min_delta_delta = norm[4];
+	max_delta_delta = norm[5];
+	trained = counts[0];
+	mfcced = counts[1];
+	for(int i = 1; i < num_ph && !mr.failed; i++) {
+		take_phone(&mr, phones[i]);
+	}
+	if(mr.failed || mr.at != mr.end) {
+		printf("The model '%s' is damaged\n", path);
+		goto end;
+	}
+	result = 0;
+end:
+	munmap((void*)map, st.st_size);
+	return result;
+}
@@ -0,0 +1,40 @@
+#ifndef MODEL_H
+#define MODEL_H
+
+/**
+ * @file   model.h
+ * @brief  Snapshots of the trained model so that test runs may skip training
+ *
+ * The snapshot is taken once the MFCCs exist, before clustering, normalisation and the lower bound
+ * envelopes, which are all still produced from the loaded model. Its header records the parameters
+ * which change the model and a model is only loaded by a run with the same parameters.
+ */
+
+#include <stdint.h>
+
+#define MODEL_MAGIC   "PHNMODEL"
+#define MODEL_VERSION 1
+
+/**
+ * \struct Model_Header
+ * \brief The header at the start of a model snapshot
+ * @magic \def MODEL_MAGIC
+ * @version \def MODEL_VERSION
+ * @order 0x01020304 as written, so snapshots are only read on hosts of the same byte order
+ * @params The parameters the model was trained with, in the order of \fn model_params()
+ * @payload The amount of bytes after the header
+ * @checksum The FNV-1a hash of the payload
+ */
+struct Model_Header {
+	char magic[8];
+	uint32_t version;
+	uint32_t order;
+	int32_t params[20];
+	uint64_t payload;
+	uint64_t checksum;
+};
+
+int save_model(const char* path);
+int load_model(const char* path);
+
+#endif
@@ -0,0 +1,364 @@
+/**
+ * @file   prototypes.c
+ * @brief  The store and the index of the prototype MFCCs, see @file prototypes.h
+ *
+ * The store is built once, after the prototypes are final, and lasts until \fn clean(). The index is
+ * rebuilt by \fn test() before each test iteration, as prototypes removed between iterations have
+ * their size set to 0, and is only read while testing.
+ */
+
+#include "dtw.h"
+
+struct Proto_Store store;
+static struct Proto_Index proto_index; /* The index of the current test iteration */
+
+/* Each prototype starts on a 64 byte cache line */
+#define STORE_ALIGN 64
+#define STORE_PAD (STORE_ALIGN / sizeof(float))
+
+/**
+ * \struct Size_Ref
+ * \brief A prototype of one phoneme and its size, sorted while indexing
+ */
+struct Size_Ref {
+	int size;
+	int ref;
+};
+
+static int size_ref_cmp(const void* a, const void* b)
+{
+	const struct Size_Ref* x = (const struct Size_Ref*)a;
+	const struct Size_Ref* y = (const struct Size_Ref*)b;
+	if(x->size != y->size) {
+		return (x->size > y->size) - (x->size < y->size);
+	}
+	return (x->ref > y->ref) - (x->ref < y->ref);
+}
+
+/**
+ * \brief Frees the index
+ */
+void free_prototype_index(void)
+{
+	for(int i = 0; i < proto_index.phonemes; i++) {
+		free(proto_index.sizes[i]);
+		free(proto_index.first[i]);
+		free(proto_index.last[i]);
+	}
+	free(proto_index.sizes);
+	free(proto_index.first);
+	free(proto_index.last);
+	free(proto_index.size_count);
+	free(proto_index.bucket);
+	free(proto_index.refs);
+	memset(&proto_index, 0, sizeof(struct Proto_Index));
+}
+
+/**
+ * \brief Indexes the MFCC prototypes of @phones by size, replacing the previous index
+ * Prototypes of size 0 have been removed and are left out.
+ */
+void index_prototypes(void)
+{
+	free_prototype_index();
+	int total = 0, max_size = 0;
+	for(int i = 1; i < num_ph; i++) {
+		for(int j = 0; j < phones[i]->size_count; j++) {
+			if(phones[i]->size[j] > 0) {
+				total++;
+				max_size = max(max_size, phones[i]->size[j]);
+			}
+		}
+	}
+	proto_index.max_size = max_size;
+	proto_index.phonemes = num_ph;
+	proto_index.bucket = (int*)calloc(max_size + 2, sizeof(int));
+	proto_index.refs = (struct Proto_Ref*)malloc(sizeof(struct Proto_Ref) * (total + 1));
+	proto_index.sizes = (int**)calloc(num_ph, sizeof(int*));
+	proto_index.first = (int**)calloc(num_ph, sizeof(int*));
+	proto_index.last = (int**)calloc(num_ph, sizeof(int*));
+	proto_index.size_count = (int*)calloc(num_ph, sizeof(int));
+	if(proto_index.bucket == NULL || proto_index.refs == NULL || proto_index.sizes == NULL ||
+	   proto_index.first == NULL || proto_index.last == NULL || proto_index.size_count == NULL) {
+		printf("Failed to malloc the prototype index\n");
+		exit(-1);
+	}
+
+	// Counting sort by size, the scan order is kept within each size
+	for(int i = 1; i < num_ph; i++) {
+		for(int j = 0; j < phones[i]->size_count; j++) {
+			if(phones[i]->size[j] > 0) {
+				proto_index.bucket[phones[i]->size[j] + 1]++;
+			}
+		}
+	}
+	for(int s = 0; s <= max_size; s++) {
+		proto_index.bucket[s + 1] += proto_index.bucket[s];
+	}
+	int* fill = (int*)malloc(sizeof(int) * (max_size + 1));
+	memcpy(fill, proto_index.bucket, sizeof(int) * (max_size + 1));
+	for(int i = 1; i < num_ph; i++) {
+		for(int j = 0; j < phones[i]->size_count; j++) {
+			int size = phones[i]->size[j];
+			if(size > 0) {
+				proto_index.refs[fill[size]].phoneme = i;
+				proto_index.refs[fill[size]].ref = j;
+				fill[size]++;
+			}
+		}
+	}
+	free(fill);
+
+	// Each phoneme's sizes, sorted, with the first and last prototype of each
+	for(int i = 1; i < num_ph; i++) {
+		int count = phones[i]->size_count;
+		struct Size_Ref* by_size = (struct Size_Ref*)malloc(sizeof(struct Size_Ref) * (count + 1));
+		int n = 0;
+		for(int j = 0; j < count; j++) {
+			if(phones[i]->size[j] > 0) {
+				by_size[n].size = phones[i]->size[j];
+				by_size[n].ref = j;
+				n++;
+			}
+		}
+		qsort(by_size, n, sizeof(struct Size_Ref), size_ref_cmp);
+		proto_index.sizes[i] = (int*)malloc(sizeof(int) * (n + 1));
+		proto_index.first[i] = (int*)malloc(sizeof(int) * (n + 1));
+		proto_index.last[i] = (int*)malloc(sizeof(int) * (n + 1));
+		int k = -1;
+		for(int m = 0; m < n; m++) {
+			if(k < 0 || proto_index.sizes[i][k] != by_size[m].size) {
+				k++;
+				proto_index.sizes[i][k] = by_size[m].size;
+				proto_index.first[i][k] = by_size[m].ref;
+			}
+			proto_index.last[i][k] = by_size[m].ref;
+		}
+		proto_index.size_count[i] = k + 1;
+		free(by_size);
+	}
+}
+
+/**
+ * \brief The prototypes of phonemes @start to @end - 1 with @size
+ * @count Set to the amount of prototypes returned
+ * @return The prototypes, ordered by phoneme then prototype
+ */
+const struct Proto_Ref* prototypes_of_size(int size, int start, int end, int* count)
+{
+	*count = 0;
+	if(size <= 0 || size > proto_index.max_size) {
+		return NULL;
+	}
+	const struct Proto_Ref* refs = &proto_index.refs[proto_index.bucket[size]];
+	int n = proto_index.bucket[size + 1] - proto_index.bucket[size];
+	int a = 0;
+	while(a < n && refs[a].phoneme < start) {
+		a++;
+	}
+	int b = a;
+	while(b < n && refs[b].phoneme < end) {
+		b++;
+	}
+	*count = b - a;
+	return &refs[a];
+}
+
+/**
+ * \brief The prototype of @phoneme whose size is nearest @size
+ * @last If equally near prototypes are split by taking the last rather than the first
+ * @return The prototype's index, or -1 if the phoneme has none left
+ */
+int nearest_prototype(int phoneme, int size, int last)
+{
+	int n = proto_index.size_count[phoneme];
+	const int* sizes = proto_index.sizes[phoneme];
+	if(n == 0) {
+		return -1;
+	}
+	int lo = 0, hi = n;
+	while(lo < hi) {
+		int mid = (lo + hi) / 2;
+		if(sizes[mid] < size) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	const int* ends = last ? proto_index.last[phoneme] : proto_index.first[phoneme];
+	if(lo == n) {
+		return ends[n - 1];
+	}
+	if(lo == 0 || sizes[lo] - size < size - sizes[lo - 1]) {
+		return ends[lo];
+	}
+	if(sizes[lo] - size > size - sizes[lo - 1]) {
+		return ends[lo - 1];
+	}
+	return last ? max(ends[lo], ends[lo - 1]) : min(ends[lo], ends[lo - 1]);
+}
+
+static size_t padded(int length)
+{
+	return ((size_t)length + STORE_PAD - 1) / STORE_PAD * STORE_PAD;
+}
+
+static float* store_stream(size_t floats)
+{
+	void* stream = NULL;
+	if(posix_memalign(&stream, STORE_ALIGN, sizeof(float) * (floats + STORE_PAD)) != 0) {
+		printf("Failed to allocate a prototype stream of %zu floats\n", floats);
+		exit(-1);
+	}
+	return (float*)stream;
+}
+
+/**
+ * \brief Moves @src, @length values, into @stream at @at and frees it
+ * @return The prototype's place in @stream
+ */
+static float* pack(float* stream, size_t at, float* src, int length)
+{
+	memcpy(&stream[at], src, sizeof(float) * length);
+	free(src);
+	return &stream[at];
+}
+
+/**
+ * \brief Packs the prototypes of @phones into the store, pointing @phones at it
+ * Run once the prototypes are final, before testing. The statistics of every prototype, removed or
+ * not, are moved so the phonemes' arrays stay indexed as before.
+ */
+void store_prototypes(void)
+{
+	int feats = (EXTRA || ZC || STE);
+	int ids = 0;
+	store.floats = 0;
+	store.feats = 0;
+	store.bytes = 0;
+	store.first = (int*)calloc(num_ph + 1, sizeof(int));
+	if(store.first == NULL) {
+		printf("Failed to malloc the prototype store\n");
+		exit(-1);
+	}
+	for(int i = 1; i < num_ph; i++) {
+		store.first[i] = ids;
+		ids += phones[i]->size_count;
+		for(int j = 0; j < phones[i]->size_count; j++) {
+			if(phones[i]->size[j] > 0) {
+				store.floats += padded(phones[i]->size[j]);
+				store.bytes += sizeof(float) * phones[i]->size[j];
+				if(feats) {
+					store.feats += padded(phones[i]->feats[j]->coeffs);
+				}
+			}
+		}
+	}
+	store.first[num_ph] = ids;
+	store.count = ids;
+	store.offset = (size_t*)calloc(ids + 1, sizeof(size_t));
+	store.feat_offset = (size_t*)calloc(ids + 1, sizeof(size_t));
+	store.phoneme = (int*)calloc(ids + 1, sizeof(int));
+	store.ref = (int*)calloc(ids + 1, sizeof(int));
+	store.length = (int*)calloc(ids + 1, sizeof(int));
+	store.used = (int*)calloc(ids + 1, sizeof(int));
+	store.correct = (float*)calloc(ids + 1, sizeof(float));
+	store.error = (float*)calloc(ids + 1, sizeof(float));
+	if(store.offset == NULL || store.feat_offset == NULL || store.phoneme == NULL || store.ref == NULL ||
+	   store.length == NULL || store.used == NULL || store.correct == NULL || store.error == NULL) {
+		printf("Failed to malloc the prototype store\n");
+		exit(-1);
+	}
+	store.mfcc = store_stream(store.floats);
+	store.delta = DELTA ? store_stream(store.floats) : NULL;
+	store.delta_delta = DELTA_DELTA ? store_stream(store.floats) : NULL;
+	if(feats) {
+		store.zc = store_stream(store.feats);
+		store.ste = store_stream(store.feats);
+		store.kurtosis = store_stream(store.feats);
+		store.entropy = store_stream(store.feats);
+	}
+
+	size_t at = 0, feat_at = 0;
+	for(int i = 1; i < num_ph; i++) {
+		for(int j = 0; j < phones[i]->size_count; j++) {
+			int id = store.first[i] + j;
+			int length = phones[i]->size[j];
+			store.phoneme[id] = i;
+			store.ref[id] = j;
+			store.length[id] = length;
+			store.used[id] = phones[i]->used[j];
+			store.correct[id] = phones[i]->correct[j];
+			store.error[id] = phones[i]->error[j];
+			store.offset[id] = at;
+			store.feat_offset[id] = feat_at;
+			if(length <= 0) {
+				continue;
+			}
+			phones[i]->mfcc[j] = pack(store.mfcc, at, phones[i]->mfcc[j], length);
+			if(DELTA) {
+				phones[i]->mfcc_delta[j] = pack(store.delta, at, phones[i]->mfcc_delta[j], length);
+			}
+			if(DELTA_DELTA) {
+				phones[i]->mfcc_delta_delta[j] = pack(store.delta_delta, at, phones[i]->mfcc_delta_delta[j], length);
+			}
+			at += padded(length);
+			if(feats) {
+				struct Feature_Set* set = phones[i]->feats[j];
+				set->zc = pack(store.zc, feat_at, set->zc, set->coeffs);
+				set->ste = pack(store.ste, feat_at, set->ste, set->coeffs);
+				set->kurtosis = pack(store.kurtosis, feat_at, set->kurtosis, set->coeffs);
+				set->entropy = pack(store.entropy, feat_at, set->entropy, set->coeffs);
+				feat_at += padded(set->coeffs);
+			}
+		}
+		free(phones[i]->used);
+		free(phones[i]->correct);
+		free(phones[i]->error);
+		phones[i]->used = &store.used[store.first[i]];
+		phones[i]->correct = &store.correct[store.first[i]];
+		phones[i]->error = &store.error[store.first[i]];
+	}
+}
+
+/**
+ * \brief Frees the store, the @phones arrays pointing into it are left dangling
+ */
+void free_store(void)
+{
+	free(store.mfcc);
+	free(store.delta);
+	free(store.delta_delta);
+	free(store.zc);
+	free(store.ste);
+	free(store.kurtosis);
+	free(store.entropy);
+	free(store.offset);
+	free(store.feat_offset);
+	free(store.phoneme);
+	free(store.ref);
+	free(store.length);
+	free(store.used);
+	free(store.correct);
+	free(store.error);
+	free(store.first);
+	memset(&store, 0, sizeof(struct Proto_Store));
+}
+
+/**
+ * \brief Removes prototype @j of phoneme @i by setting its size to 0
+ * Its MFCCs are freed unless they are in the store, whose space is kept until \fn free_store().
+ */
+void remove_prototype(int i, int j)
+{
+	if(phones[i]->size[j] <= 0) {
+		return;
+	}
+	if(store.mfcc != NULL) {
+		store.bytes -= sizeof(float) * phones[i]->size[j];
+		store.length[store.first[i] + j] = 0;
+	} else {
+		free(phones[i]->mfcc[j]);
+	}
+	phones[i]->size[j] = 0;
+}
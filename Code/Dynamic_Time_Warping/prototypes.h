@@ -0,0 +1,91 @@
+#ifndef PROTOTYPES_H
+#define PROTOTYPES_H
+
+/**
+ * @file   prototypes.h
+ * @brief  The store of the prototype MFCCs and an index of them by size, used to choose which prototypes a test is compared to
+ *
+ * Once built, the prototypes' MFCCs, deltas and features are packed into one buffer per stream, each
+ * prototype starting on a cache line, in phoneme then prototype order. The @phones arrays point into the
+ * buffers so the rest of the program reads them as before, but a KNN sweep reads memory in order.
+ *
+ * The prototypes of each size are kept together, ordered by phoneme then prototype as the scans over
+ * @phones found them, so a test's candidates are one lookup. Each phoneme also keeps its sizes sorted
+ * for finding its nearest prototype when none has the test's size.
+ */
+
+/**
+ * \struct Proto_Ref
+ * \brief A prototype, phones[@phoneme]->mfcc[@ref]
+ */
+struct Proto_Ref {
+	int phoneme;
+	int ref;
+};
+
+/**
+ * \struct Proto_Index
+ * \brief The prototypes indexed by MFCC size
+ * @max_size The largest size indexed
+ * @bucket The prototypes of size s are @refs[@bucket[s]] to @refs[@bucket[s + 1]], @max_size + 2 offsets
+ * @sizes The sorted, distinct sizes of each phoneme's prototypes, @size_count of them
+ * @first,@last The first and last prototype of each of @sizes
+ */
+struct Proto_Index {
+	int max_size;
+	int* bucket;
+	struct Proto_Ref* refs;
+	int phonemes;
+	int** sizes;
+	int** first;
+	int** last;
+	int* size_count;
+};
+
+/**
+ * \struct Proto_Store
+ * \brief The packed prototypes, each given an id in phoneme then prototype order
+ * @mfcc,@delta,@delta_delta The MFCC streams, @floats values each; NULL for streams not in use
+ * @zc,@ste,@kurtosis,@entropy The frame features, @feats values each; NULL unless EXTRA, ZC or STE
+ * @offset,@feat_offset The start of each prototype within the MFCC streams and the feature streams
+ * @phoneme,@ref,@length The phoneme, index within the phoneme and MFCC length of each prototype
+ * @used,@correct,@error The statistics of each prototype, which the phonemes' arrays point into
+ * @first The id of each phoneme's first prototype, @phones[i]->size_count ids from it
+ * @count The amount of prototypes
+ * @bytes The bytes of the MFCCs of the prototypes still in use, as \fn data_size() reports
+ */
+struct Proto_Store {
+	float* mfcc;
+	float* delta;
+	float* delta_delta;
+	float* zc;
+	float* ste;
+	float* kurtosis;
+	float* entropy;
+	size_t floats;
+	size_t feats;
+	size_t* offset;
+	size_t* feat_offset;
+	int* phoneme;
+	int* ref;
+	int* length;
+	int* used;
+	float* correct;
+	float* error;
+	int* first;
+	int count;
+	size_t bytes;
+};
+
+extern struct Proto_Store store;
+
+void store_prototypes(void);
+void free_store(void);
+void remove_prototype(int i, int j);
+
+void index_prototypes(void);
+void free_prototype_index(void);
+const struct Proto_Ref* prototypes_of_size(int size, int start, int end, int* count);
+int nearest_prototype(int phoneme, int size, int last);
+
+#endif
@@ -16,4 +16,9 @@ void update_delta_deltas_norm(float* delta, int length);
 void normalise_delta_delta(float* delta, int length);
 void normalise_delta(float* delta, int length);
 
+extern float min_delta;
+extern float max_delta;
+extern float min_delta_delta;
+extern float max_delta_delta;
+
 #endif
@@ -0,0 +1,61 @@
+/**
+ * @file   entropy.c
+ * @brief  The table driven entropy of audio samples, see @file entropy.h
+ */
+#include <math.h>
+#include <pthread.h>
+
+#include "entropy.h"
+
+static double table[ENTROPY_TABLE_SIZE]; /* |x|log2|x| of each int16 magnitude */
+static pthread_once_t table_once = PTHREAD_ONCE_INIT;
+
+static void fill_table(void)
+{
+	table[0] = 0;
+	for(int a = 1; a < ENTROPY_TABLE_SIZE; a++) {
+		table[a] = (double)a * (log(a) / log(2));
+	}
+}
+
+/**
+ * @brief The table of |x|log2|x| for magnitudes 0 to 32767, filled by the first caller
+ */
+const double* entropy_table(void)
+{
+	pthread_once(&table_once, fill_table);
+	return table;
+}
+
+/**
+ * @brief The entropy of one int16 sample, from @param table as \fn entropy_table() returns it
+ */
+double s16_entropy_term(const double* table, int16_t x)
+{
+	return table[(x == INT16_MIN) ? INT16_MAX : (x < 0) ? -x : x];
+}
+
+/**
+ * @brief The entropy of one float sample, from @param table when it is a whole int16 magnitude
+ */
+double f_entropy_term(const double* table, float x)
+{
+	float a = fabsf(x);
+	if(a < ENTROPY_TABLE_SIZE && a == (int)a) {
+		return table[(int)a];
+	}
+	return a * (log(a) / log(2));
+}
+
+/**
+ * @brief The entropy of @param length int16 samples, summed in a float
+ */
+float s16_entropy(const int16_t* sequence, int length)
+{
+	const double* t = entropy_table();
+	float entropy = 0;
+	for(int m = 0; m < length; m++) {
+		entropy += s16_entropy_term(t, sequence[m]);
+	}
+	return entropy;
+}
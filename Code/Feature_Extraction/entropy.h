@@ -0,0 +1,21 @@
+#ifndef ENTROPY_H
+#define ENTROPY_H
+
+/**
+ * @file   entropy.h
+ * @brief  The entropy of audio samples, |x|log2|x| summed, read from a table for int16 magnitudes
+ *
+ * A sample of 0 adds nothing, as it is counted as 1, and -32768 counts as 32767. The table holds the
+ * same doubles the sums were built from, so the sums are unchanged, and the samples are only read.
+ */
+
+#include <stdint.h>
+
+#define ENTROPY_TABLE_SIZE 32768
+
+const double* entropy_table(void);
+double s16_entropy_term(const double* table, int16_t x);
+double f_entropy_term(const double* table, float x);
+float s16_entropy(const int16_t* sequence, int length);
+
+#endif
@@ -5,123 +5,298 @@
  * 
  * @brief Fast Fourier transform and Discrete Cosine tranform functions 
  * 
+ * The FFT is an iterative radix-2 transform over tables built once per length by \fn fft_plan().
+ * 
  */
 #include "fft.h"
 
+static struct Fft_Plan* plans = NULL;                       /* The plans built by \fn fft_plan_cached() */
+static pthread_mutex_t plans_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct Dct_Plan* dct_plans = NULL;                   /* The plans built by \fn dct_plan_cached() */
+static pthread_mutex_t dct_plans_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static inline float complex mul(float complex a, float complex b)
+{
+	float ar = crealf(a), ai = cimagf(a), br = crealf(b), bi = cimagf(b);
+	return CMPLXF(ar * br - ai * bi, ar * bi + ai * br);
+}
+
 /** 
- * @brief DCT function used during the MFCC process
+ * @brief Builds the bit reversal and twiddle tables for an FFT of length @param n
  * 
- * @param array The MFCC to be processed
- * @param width The length of @param array
+ * @param n The length of the complex transform, a power of two
  * 
- * @return 
+ * @return The plan, or NULL if @param n is not a power of two or the tables could not be allocated
  */
-float* dct(float* array, int width)
+struct Fft_Plan* fft_plan(int n)
 {
-	float* result = (float*)malloc(width * sizeof(float));
-	if(result == NULL)
-		printf("Failed to malloc 'result' in DCT\n");
-	
-	for(int i = 0; i < width; i++) {
-		float sum = 0;
-		for(int n = 0; n < width; n++) {
-			sum += array[n] * cos(M_PI / (width) * (n + 0.5) * i);
-			
+	if(n <= 0 || (n & (n - 1)) != 0) {
+		printf("FFT length %d is not a power of two\n", n);
+		return NULL;
+	}
+	struct Fft_Plan* plan = (struct Fft_Plan*)calloc(1, sizeof(struct Fft_Plan));
+	if(plan == NULL) {
+		printf("Failed to malloc 'plan' in FFT\n");
+		return NULL;
+	}
+	plan->n = n;
+	plan->rev = (int*)malloc(sizeof(int) * n);
+	plan->twiddle = (float complex*)malloc(sizeof(float complex) * (n / 2 + 1));
+	plan->split = (float complex*)malloc(sizeof(float complex) * n);
+	if(plan->rev == NULL || plan->twiddle == NULL || plan->split == NULL) {
+		printf("Failed to malloc the tables in FFT\n");
+		free_fft_plan(plan);
+		return NULL;
+	}
+	int bits = 0;
+	while((1 << bits) < n) {
+		bits++;
+	}
+	for(int i = 0; i < n; i++) {
+		int r = 0;
+		for(int b = 0; b < bits; b++) {
+			r |= ((i >> b) & 1) << (bits - 1 - b);
 		}
-		result[i] = sum;
+		plan->rev[i] = r;
+	}
+	for(int k = 0; k < n / 2; k++) {
+		plan->twiddle[k] = CMPLXF(cos(2 * M_PI * k / n), -sin(2 * M_PI * k / n));
 	}
-	return result;
+	for(int k = 0; k < n; k++) {
+		plan->split[k] = CMPLXF(cos(M_PI * k / n), -sin(M_PI * k / n));
+	}
+	return plan;
 }
 
 /** 
- * @brief Produces an 2 dimensional array of FFT magnitudes
+ * @brief Finds the plan of length @param n, building it on first use
  * 
- * @param chunks The Hanning window sequences from an audio signal
- * @param n The number of Hanning windows to be processed
- * @param length The length of each Hanning window
+ * @param n The length of the complex transform
  * 
- * @return A 2D array of FFT arrays
+ * @return The shared plan, which must not be freed by the caller
  *
- * Each 'chunk' passed will have an FFT applied and the magnitude extracted, the same amount of arrays will be returned
- * however, they will all be of length (@param length / 2)
+ * Plans are kept until \fn free_fft_plans() and may be used by several threads at once.
  */
-float** fft_chunks(float** chunks, int n, int length)
+struct Fft_Plan* fft_plan_cached(int n)
 {
-	float complex* fft_buff = calloc(length, sizeof(float complex));
-	float complex* result;
-	float** mag = (float**)calloc(n, sizeof(float*));
-	if(mag == NULL)
-		printf("Failed to malloc 'mag' in fft\n");
-	for(int i = 0; i < n; i++) {
-		mag[i] = (float*)calloc((length / 2), sizeof(float));
-		if(mag[i] == NULL)
-			printf("Failed to malloc 'mag[i]' in fft\n");
+	pthread_mutex_lock(&plans_lock);
+	struct Fft_Plan* plan = plans;
+	while(plan != NULL && plan->n != n) {
+		plan = plan->next;
 	}
-	for(int m = 0; m < n; m++) {
-		for(int i = 0; i < length; i++) {
-			fft_buff[i] = chunks[m][i];
+	if(plan == NULL) {
+		plan = fft_plan(n);
+		if(plan != NULL) {
+			plan->next = plans;
+			plans = plan;
 		}
-		result = fft(fft_buff, length);
-		for(int i = 0; i < (length / 2); i++) {
-			/* TODO :: Conditional jump or move depends on uninitialised value(s) */
-			mag[m][i] = cabsf(result[i]); //sqrt( (real[i] * real[i]) + (imag[i] * imag[i]) );
+	}
+	pthread_mutex_unlock(&plans_lock);
+	return plan;
+}
+
+void free_fft_plan(struct Fft_Plan* plan)
+{
+	if(plan == NULL) {
+		return;
+	}
+	free(plan->rev);
+	free(plan->twiddle);
+	free(plan->split);
+	free(plan);
+}
+
+void free_fft_plans(void)
+{
+	pthread_mutex_lock(&plans_lock);
+	while(plans != NULL) {
+		struct Fft_Plan* next = plans->next;
+		free_fft_plan(plans);
+		plans = next;
+	}
+	pthread_mutex_unlock(&plans_lock);
+}
+
+/** 
+ * @brief Performs an in-place FFT
+ * 
+ * @param plan The plan for the length of @param buff
+ * @param buff The complex array to be transformed, overwritten by its FFT
+ */
+void fft_execute(const struct Fft_Plan* plan, float complex* buff)
+{
+	int n = plan->n;
+	for(int i = 0; i < n; i++) {
+		int r = plan->rev[i];
+		if(i < r) {
+			float complex temp = buff[i];
+			buff[i] = buff[r];
+			buff[r] = temp;
+		}
+	}
+	for(int len = 2; len <= n; len <<= 1) {
+		int half = len / 2;
+		int step = n / len;
+		for(int i = 0; i < n; i += len) {
+			for(int k = 0; k < half; k++) {
+				float complex u = buff[i + k];
+				float complex v = mul(buff[i + k + half], plan->twiddle[k * step]);
+				buff[i + k] = u + v;
+				buff[i + k + half] = u - v;
+			}
 		}
-		free(result);
 	}
+}
 
-	free(fft_buff);
-	return mag;
+/** 
+ * @brief Performs an FFT of 2n real samples with a complex FFT of length n
+ * 
+ * @param plan The plan of length n
+ * @param buff On entry the 2n real samples, as a float complex array holds its real and imaginary parts
+ *             next to each other. On return the first n bins of the real FFT.
+ *
+ * The even samples are transformed as the real part and the odd samples as the imaginary part, then the
+ * two spectra are separated and combined with the \var split twiddles. Bin n, the Nyquist bin, is not kept.
+ */
+void fft_real(const struct Fft_Plan* plan, float complex* buff)
+{
+	int n = plan->n;
+	fft_execute(plan, buff);
+	float complex z = buff[0];
+	buff[0] = crealf(z) + cimagf(z);
+	for(int k = 1; k <= n / 2; k++) {
+		int m = n - k;
+		float complex a = buff[k];
+		float complex b = buff[m];
+		float complex even_k = 0.5f * (a + conjf(b));
+		float complex odd_k = mul(CMPLXF(0, -0.5f), a - conjf(b));
+		float complex even_m = 0.5f * (b + conjf(a));
+		float complex odd_m = mul(CMPLXF(0, -0.5f), b - conjf(a));
+		buff[k] = even_k + mul(plan->split[k], odd_k);
+		buff[m] = even_m + mul(plan->split[m], odd_m);
+	}
 }
 
 /** 
- * @brief Performs an FFT on a given array
+ * @brief Builds a DCT-II which keeps the first @param count coefficients
  * 
- * @param chunk The complex array to be processed
- * @param length The length of @param chunk
+ * @param width The length of the input
+ * @param count The amount of coefficients produced
  * 
- * @return The FFT in the form of a complex number, no magnitude taken
+ * @return The plan, or NULL if it could not be allocated
  *
- * Before processing the input must be in complex form and the return will be also be in complex form and so
- * the magnitude will need to be taken for further MFCC processing.
+ * Narrow transforms keep the cosine basis, so each coefficient is a single dot product. From
+ * \def DCT_FFT_WIDTH upwards a power of two width is instead reordered into an FFT of the same length.
+ */
+struct Dct_Plan* dct_plan(int width, int count)
+{
+	struct Dct_Plan* plan = (struct Dct_Plan*)calloc(1, sizeof(struct Dct_Plan));
+	if(plan == NULL) {
+		printf("Failed to malloc 'plan' in DCT\n");
+		return NULL;
+	}
+	plan->width = width;
+	plan->count = count;
+	if(width >= DCT_FFT_WIDTH && (width & (width - 1)) == 0 && count <= width) {
+		plan->fft = fft_plan(width);
+		plan->shift = (float complex*)malloc(sizeof(float complex) * count);
+		if(plan->fft == NULL || plan->shift == NULL) {
+			printf("Failed to malloc the tables in DCT\n");
+			free_dct_plan(plan);
+			return NULL;
+		}
+		for(int i = 0; i < count; i++) {
+			plan->shift[i] = CMPLXF(cos(M_PI * i / (2 * width)), -sin(M_PI * i / (2 * width)));
+		}
+		return plan;
+	}
+	plan->basis = (double*)malloc(sizeof(double) * count * width);
+	if(plan->basis == NULL) {
+		printf("Failed to malloc 'basis' in DCT\n");
+		free_dct_plan(plan);
+		return NULL;
+	}
+	for(int i = 0; i < count; i++) {
+		for(int n = 0; n < width; n++) {
+			plan->basis[i * width + n] = cos(M_PI / (width) * (n + 0.5) * i);
+		}
+	}
+	return plan;
+}
+
+/** 
+ * @brief Finds the DCT plan of the given size, building it on first use
+ * 
+ * @return The shared plan, which must not be freed by the caller
  */
-float complex* fft(float complex* chunk, int length)
+struct Dct_Plan* dct_plan_cached(int width, int count)
+{
+	pthread_mutex_lock(&dct_plans_lock);
+	struct Dct_Plan* plan = dct_plans;
+	while(plan != NULL && !(plan->width == width && plan->count == count)) {
+		plan = plan->next;
+	}
+	if(plan == NULL) {
+		plan = dct_plan(width, count);
+		if(plan != NULL) {
+			plan->next = dct_plans;
+			dct_plans = plan;
+		}
+	}
+	pthread_mutex_unlock(&dct_plans_lock);
+	return plan;
+}
+
+void free_dct_plan(struct Dct_Plan* plan)
+{
+	if(plan == NULL) {
+		return;
+	}
+	free(plan->basis);
+	free_fft_plan(plan->fft);
+	free(plan->shift);
+	free(plan);
+}
+
+void free_dct_plans(void)
 {
-	int n = length; 
-	if (n == 1)
-		return chunk;
+	pthread_mutex_lock(&dct_plans_lock);
+	while(dct_plans != NULL) {
+		struct Dct_Plan* next = dct_plans->next;
+		free_dct_plan(dct_plans);
+		dct_plans = next;
+	}
+	pthread_mutex_unlock(&dct_plans_lock);
+}
 
-	double complex w = cexp( (2 * M_PI * I) / n);
-	float complex* even = calloc(length / 2, sizeof(float complex));
-	float complex* odd = calloc(length / 2, sizeof(float complex));
-	if(odd == NULL || even == NULL) {
-		printf("Failed to malloc 'odd || even' in FFT\n");
-	}
-	int e = 0, o = 0;
-	for(int i = 0; i < length; i++) {
-		if(i % 2 == 0) {
-			even[e] = chunk[i];
-			e++;
-		} else {
-			odd[o] = chunk[i];
-			o++;
+/** 
+ * @brief DCT function used during the MFCC process
+ * 
+ * @param plan The plan of the length of @param array
+ * @param array The log Mel energies to be processed
+ * @param result Filled with plan->count coefficients
+ * @param buff Scratch of plan->width values when plan->fft is set, otherwise unused and may be NULL
+ */
+void dct_execute(const struct Dct_Plan* plan, const float* array, float* result, float complex* buff)
+{
+	int width = plan->width;
+	if(plan->fft == NULL) {
+		for(int i = 0; i < plan->count; i++) {
+			const double* basis = &plan->basis[i * width];
+			float sum = 0;
+			for(int n = 0; n < width; n++) {
+				sum += array[n] * basis[n];
+			}
+			result[i] = sum;
 		}
+		return;
+	}
+	for(int n = 0; n < width / 2; n++) {
+		buff[n] = array[2 * n];
+		buff[width - 1 - n] = array[2 * n + 1];
+	}
+	fft_execute(plan->fft, buff);
+	for(int i = 0; i < plan->count; i++) {
+		result[i] = crealf(mul(buff[i], plan->shift[i]));
 	}
-	float complex* y_even = fft(even, length / 2);
-	float complex* y_odd = fft(odd, length / 2);
-	float complex* y = (float complex*)malloc(length * sizeof(float complex));
-	if(y == NULL) {
-		printf("Failed to malloc 'y' in FFT\n");
-	}
-	for(int j = 0; j < length / 2; j++) {
-		y[j] = y_even[j] + (cpow(w, j) * y_odd[j]);
-		y[j + n / 2] = y_even[j] - (cpow(w, j) * y_odd[j]);
-	}
-	
-	if(even != y_even)
-		free(y_even);
-	if(odd != y_odd)
-		free(y_odd);
-	free(even);
-	free(odd);
-	return y;
 }
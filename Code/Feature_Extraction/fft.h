@@ -6,14 +6,59 @@
 #include <memory.h>
 #include <math.h>
 #include <complex.h>
+#include <pthread.h>
 
 #ifndef M_PI
 #define M_PI (3.14159265358979323846)
 #endif
 
+#define DCT_FFT_WIDTH 64 /* The smallest power of two width for which \fn dct_plan() uses an FFT */
 
-float** fft_chunks(float** chunks,int n, int length);
-float complex* fft(float complex* chunk, int length);
-float* dct(float* array, int width);
+
+/**
+ * \struct Fft_Plan
+ * \brief The tables of an in-place radix-2 FFT of a single size
+ * @n The length of the complex transform, a power of two
+ * @rev The bit reversed position of each index
+ * @twiddle e^(-2 pi i k / n) for k < n / 2
+ * @split e^(-2 pi i k / 2n) for k < n, used by \fn fft_real() to unpack a transform of 2n real samples
+ * @next The next plan in the cache of \fn fft_plan_cached()
+ */
+struct Fft_Plan {
+	int n;
+	int* rev;
+	float complex* twiddle;
+	float complex* split;
+	struct Fft_Plan* next;
+};
+
+struct Fft_Plan* fft_plan(int n);
+struct Fft_Plan* fft_plan_cached(int n);
+void free_fft_plan(struct Fft_Plan* plan);
+void free_fft_plans(void);
+void fft_execute(const struct Fft_Plan* plan, float complex* buff);
+void fft_real(const struct Fft_Plan* plan, float complex* buff);
+/**
+ * \struct Dct_Plan
+ * \brief The first @count coefficients of a DCT-II of length @width
+ * @basis The cosine of each retained coefficient and input, @count by @width
+ * @fft The FFT used instead of @basis for wide transforms, NULL otherwise
+ * @shift e^(-i pi k / 2 width) for the retained coefficients of the FFT path
+ * @next The next plan in the cache of \fn dct_plan_cached()
+ */
+struct Dct_Plan {
+	int width;
+	int count;
+	double* basis;
+	struct Fft_Plan* fft;
+	float complex* shift;
+	struct Dct_Plan* next;
+};
+
+struct Dct_Plan* dct_plan(int width, int count);
+struct Dct_Plan* dct_plan_cached(int width, int count);
+void free_dct_plan(struct Dct_Plan* plan);
+void free_dct_plans(void);
+void dct_execute(const struct Dct_Plan* plan, const float* array, float* result, float complex* buff);
 
 #endif
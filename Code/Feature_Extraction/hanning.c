@@ -34,10 +34,10 @@ float* hanning_window(int num)
  * @param length The length of @param length
  * @param incr The window width to use
  * 
- * @return The array of Hanning windows
+ * @return The array of Hanning windows, or NULL if the window could not be built
  *
  * The input signal will be blocked into chunks of size @param incr then
- * each chunk will have a Hanning window applied.
+ * each chunk will have the MFCC plans' window from \fn hanning_cached() applied.
  */
 float** hanning_chunks(float* input, int length, int incr)
 {
@@ -46,20 +46,19 @@ float** hanning_chunks(float* input, int length, int incr)
 		last = glbl_frame_limit;
 	}
 	
+	const float* window = hanning_cached(incr, 0);
+	if(window == NULL) {
+		return NULL;
+	}
 	float** chunks = (float**)malloc( (last) * sizeof(float*));
 	for(int i = 0; i < (last); i++) {
 		chunks[i] = (float*)calloc(incr, sizeof(float));
 	}
-	int n = 0;
 	for(int i = 0; i < (last); i++) {
-		float* temp = (float*)malloc(incr * sizeof(float));
-		int first = (i) * (incr / glbl_interval_div);
-		memcpy(temp, &input[first], incr * sizeof(float));
-		float* hanned = hanning(temp, incr);
-		memcpy(chunks[n], hanned, sizeof(float) * incr);
-		free(hanned);
-		n++;
-		free(temp);
+		const float* frame = &input[i * (incr / glbl_interval_div)];
+		for(int k = 0; k < incr; k++) {
+			chunks[i][k] = window[k] * frame[k];
+		}
 	}
 
 	return chunks;
@@ -73,28 +72,27 @@ float** hanning_chunks(float* input, int length, int incr)
  * @param length The length of @param length
  * @param incr The window width to use
  * 
- * @return The array of Hanning windows
+ * @return The array of Hanning windows, or NULL if the window could not be built
  *
  * The input signal will be blocked into chunks of size @param incr then
- * each chunk will have a Hanning window applied.
+ * each chunk will have the MFCC plans' window from \fn hanning_cached() applied.
  */
 float** hanning_chunks_no_overlap(float* input, int length, int incr)
 {
 	int last = floor(length / incr);
+	const float* window = hanning_cached(incr, 0);
+	if(window == NULL) {
+		return NULL;
+	}
 	float** chunks = (float**)malloc( (last) * sizeof(float*));
 	for(int i = 0; i < (last); i++) {
 		chunks[i] = (float*)calloc(incr,  sizeof(float));
 	}
-	int n = 0;
 	for(int i = 0; i < (last); i++) {
-		float* temp = (float*)malloc(incr * sizeof(float));
-		int first = (i) * (incr);
-		memcpy(temp, &input[first], incr * sizeof(float));
-		float* hanned = hanning(temp, incr);
-		memcpy(chunks[n], hanned, sizeof(float) * incr);
-		free(hanned);
-		n++;
-		free(temp);
+		const float* frame = &input[i * incr];
+		for(int k = 0; k < incr; k++) {
+			chunks[i][k] = window[k] * frame[k];
+		}
 	}
 
 	return chunks;
@@ -7,6 +7,7 @@
 #include <memory.h>
 #include "../Training/train.h"
 #include "../Seperation/cross_rate.h"
+#include "mfcc_plan.h"
 
 #ifndef M_PI
 #define M_PI (3.14159265358979323846)
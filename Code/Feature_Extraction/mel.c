@@ -5,156 +5,174 @@
  * 
  * @brief  Functions for generating a Mel filter bank and applying it to an FFT'ed sequence.
  *
+ * A bank is built once per configuration by \fn mel_bank_cached() and only the non-zero span of each
+ * triangle is kept, so applying it to a frame is a short dot product per band.
  */
 #include "mel.h"
 
+static struct Mel_Bank* fbs = NULL;                        /* The banks built by \fn mel_bank_cached() */
+static pthread_mutex_t fbs_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/** 
+ * @brief The weight of FFT bin @param k in band @param m, as the dense filter bank defined it
+ */
+static float mel_weight(const float* f, int m, float k)
+{
+	float w = 0;
+	if (k >= f[m - 1] && k <= f[m] && (f[m] - f[m - 1] != 0)) {
+		w = (k - f[m - 1]) / (f[m] - f[m - 1]);
+	} else if (k >= f[m] && k <= f[m + 1] && (f[m + 1] - f[m] != 0)) {
+		w = (f[m + 1] - k) / (f[m + 1] - f[m]);
+	}
+	if(fpclassify(w) == FP_INFINITE || fpclassify(w) == FP_NAN) {
+		w = 0;
+	}
+	return w;
+}
+
 /** 
  * @brief Generates a Mel scale filter bank
  * 
  * @param width The width of the FFT'ed input sequence
  * @param banks The number of banks to be generated
+ * @param nfft The NFFT used to place the band edges
+ * @param rate The sample rate of the signal
+ * @param max_hz The highest frequency of the bank, the lowest is 0
+ * @param first The first FFT bin a band may cover
  * 
- * @return The Mel filter bank of size @param width by @param banks
- *
- * Generates a Mel filter bank with minimum and maximum values of 0 and 4000 respecitively.
- * @var glbl_nfft is used when creating the filter bank.
+ * @return The sparse Mel filter bank, or NULL if it could not be allocated
  */
-float** mel_fb(int width, int banks)
+struct Mel_Bank* mel_bank(int width, int banks, int nfft, int rate, float max_hz, int first)
 {
 	float minmel   = 2595.0*log10(1.0 + ( 0 /700.0));
-	float maxmel   = 2595.0*log10(1.0 + ( 4000 /700.0));     
+	float maxmel   = 2595.0*log10(1.0 + ( max_hz /700.0));     
 	float binwidth = (maxmel - minmel) / (banks + 1);
-	// float L = (maxmel - minmel) / (banks * (1 - 0.4) + 0.4);
 	float start = minmel; 
-	float* mel = calloc(banks + 2, sizeof(float));
-	float* h = calloc(banks + 2, sizeof(float)); 
 	float* f = calloc(banks + 2, sizeof(float));
-	
-	float** H = (float**)malloc(width * sizeof(float*));
-	if(H == NULL)
-		printf("Failed to malloc H in mel_fb\n");
-	for(int i = 0; i < width; i++) {
-		H[i] = (float*)calloc(banks + 2, sizeof(float));
-		if(H[i] == NULL)
-			printf("Failed to calloc H[i] in mel_fb\n");
-		for(int n = 0; n < banks + 2; n++) {
-			H[i][n] = 0;
-		}
+	struct Mel_Bank* fb = (struct Mel_Bank*)calloc(1, sizeof(struct Mel_Bank));
+	if(f == NULL || fb == NULL) {
+		printf("Failed to malloc the Mel filter bank\n");
+		free(f);
+		free(fb);
+		return NULL;
 	}
-	
+	fb->width = width;
+	fb->banks = banks;
+	fb->nfft = nfft;
+	fb->rate = rate;
+	fb->max_hz = max_hz;
+	fb->first = first;
+	fb->start = (int*)calloc(banks, sizeof(int));
+	fb->length = (int*)calloc(banks, sizeof(int));
+	fb->offset = (int*)calloc(banks, sizeof(int));
+
 	for(int n = 0; n < banks + 2; n++) {
-		mel[n] = start; 
-		h[n] = 700.0*(exp(mel[n]/1125.0) - 1);
-		f[n] = floor((glbl_nfft + 1) * h[n] / 16000); // 32, 64, 128, 256, 512 (orignally using 128)
-		// float binwidth = (L / 2) + n * (maxmel - minmel - L) / (banks - 1) + minmel;  
+		float h = 700.0*(exp(start/1125.0) - 1);
+		f[n] = floor((nfft + 1) * h / rate);
 		start = start + binwidth;
 	}
-	
-	/* /\* TODO test with m = 2, k = 1, [m], [m - 1], [k], [k - 1], etc.*\/ */
-	/* for(float m = 2; m < banks + 2; m++) { */
-	/* 	for(float k = 0; k < width; k++) { */
-	/* 		if (k >= f[(int)m - 1] && k <= f[(int)m] && (f[(int)m] - f[(int)m - 1] != 0)) { */
-	/* 			H[(int)k][(int)m - 2] = (k - f[(int)m - 1]) / (f[(int)m] - f[(int)m - 1]); */
-	/* 		} else if (k >= f[(int)m] && k <= f[(int)m + 1] && (f[(int)m + 1] - f[(int)m] != 0)) { */
-	/* 			H[(int)k][(int)m - 2] = (f[(int)m + 1] - k) / (f[(int)m + 1] - f[(int)m]); */
-	/* 		} else { */
-	/* 			H[(int)k][(int)m - 2] = 0; */
-	/* 		} */
-	/* 		if(fpclassify(H[(int)k][(int)m - 2]) == FP_INFINITE || fpclassify(H[(int)k][(int)m - 2]) == FP_NAN) { */
-	/* 			H[(int)k][(int)m - 2] = 0; */
-	/* 		} */
-	/* 	} */
-		
-	/* } */
-	
-	for(float m = 1; m < banks + 1; m++) {
-		for(float k = 0; k < width; k++) {
-			if (k >= f[(int)m - 1] && k <= f[(int)m] && (f[(int)m] - f[(int)m - 1] != 0)) {
-				H[(int)k][(int)m - 1] = (k - f[(int)m - 1]) / (f[(int)m] - f[(int)m - 1]);
-			} else if (k >= f[(int)m] && k <= f[(int)m + 1] && (f[(int)m + 1] - f[(int)m] != 0)) {
-				H[(int)k][(int)m - 1] = (f[(int)m + 1] - k) / (f[(int)m + 1] - f[(int)m]);
-			} else {
-				H[(int)k][(int)m - 1] = 0;
-			}
-			if(fpclassify(H[(int)k][(int)m - 1]) == FP_INFINITE || fpclassify(H[(int)k][(int)m - 1]) == FP_NAN) {
-				H[(int)k][(int)m - 1]= 0;
+
+	int total = 0;
+	for(int m = 1; m < banks + 1 && fb->start != NULL && fb->length != NULL; m++) {
+		int lo = width, hi = -1;
+		for(int k = first; k < width; k++) {
+			if(mel_weight(f, m, k) != 0) {
+				lo = (lo < k) ? lo : k;
+				hi = k;
 			}
 		}
+		fb->start[m - 1] = (hi < 0) ? 0 : lo;
+		fb->length[m - 1] = (hi < 0) ? 0 : hi - lo + 1;
+		total += fb->length[m - 1];
+	}
+	fb->weights = (float*)malloc(sizeof(float) * (total + 1));
+	if(fb->start == NULL || fb->length == NULL || fb->offset == NULL || fb->weights == NULL) {
+		printf("Failed to malloc the Mel filter bank\n");
+		free(f);
+		free_mel_bank(fb);
+		return NULL;
+	}
+	int t = 0;
+	for(int m = 1; m < banks + 1; m++) {
+		fb->offset[m - 1] = t;
+		for(int k = 0; k < fb->length[m - 1]; k++) {
+			fb->weights[t] = mel_weight(f, m, fb->start[m - 1] + k);
+			t++;
+		}
 	}
-
-	/* for(int k = 0; k < width; k++) { */
-	/* 	for(int m = 0; m < banks + 1; m++) { */
-	/* 		printf("%f, ", H[k][m]); */
-	/* 	} */
-	/* 	printf("; \n"); */
-	/* } */
-	/* exit(0); */
-	free(mel);
-	free(h);
 	free(f);
-	
-	return H;
+
+	return fb;
 }
 
 /** 
- * @brief Applies a generated Mel filter bank to the input array
- * 
- * @param array The FFT'ed sequence the filter bank is to be applied to
- * @param width The length of @param array
- * @param banks The number of desired filter banks
+ * @brief Finds the bank of the given configuration, building it on first use
  * 
- * @return The result of applying the Mel filter bank to the input FFT'ed sequence.
+ * @return The shared bank, which must not be freed by the caller
+ *
+ * Banks are kept until \fn free_mel_banks() and may be used by several threads at once.
  */
-float* mel(float* array, int width, int banks)
+struct Mel_Bank* mel_bank_cached(int width, int banks, int nfft, int rate, float max_hz, int first)
 {
-	float* result = (float*)calloc(banks, sizeof(float));
-	float** melfb = mel_fb(width, banks);
-	float** applied = calloc(width, sizeof(float*));
-	if(result == NULL || melfb == NULL || applied == NULL)
-		printf("Malloc/Calloc error in mel\n");
-	for(int i = 0; i < width; i++) {
-		applied[i] = calloc(banks, sizeof(float));
-		if(applied[i] == NULL)
-			printf("Failed to calloc applied[i]\n");
-		for(int j = 0; j < banks; j++) {
-			applied[i][j] = 0;
-		}
+	pthread_mutex_lock(&fbs_lock);
+	struct Mel_Bank* fb = fbs;
+	while(fb != NULL && !(fb->width == width && fb->banks == banks && fb->nfft == nfft && fb->rate == rate && fb->max_hz == max_hz && fb->first == first)) {
+		fb = fb->next;
 	}
-	
-	for(int i = 0; i < width; i++) {
-		for(int j = 0; j < banks; j++) {
-			applied[i][j] = array[i] * melfb[i][j];
-			if(fpclassify(melfb[i][j]) == FP_INFINITE || fpclassify(melfb[i][j]) == FP_NAN) {
-				printf("MelFb result contained NAN of INF :: %.3f || width := %d || i := %d || j := %d\n", melfb[i][j],  width, i, j);
-	 		}
-			if(fpclassify(array[i]) == FP_INFINITE || fpclassify(array[i]) == FP_NAN) {
-				printf("Array contained NAN of INF :: %.3f || width := %d\n", melfb[i][j],  width);
-			}
-			if(applied[i][j] == 0) {
-				applied[i][j] = FLT_EPSILON;
-			}
+	if(fb == NULL) {
+		fb = mel_bank(width, banks, nfft, rate, max_hz, first);
+		if(fb != NULL) {
+			fb->next = fbs;
+			fbs = fb;
 		}
 	}
-	
-	for(int i = 0; i < width; i++) {
-		for(int j = 0; j < banks; j++) {
-			result[j] += applied[i][j];
-		}		
-	}
-	// maybe change
-	/* for(int i = 0; i < banks; i++) { */
-	/* 	result[i] = result[i] / banks; */
-	/* } */
-	for(int i = 0; i < width; i++) {
-		free(melfb[i]);
+	pthread_mutex_unlock(&fbs_lock);
+	return fb;
+}
+
+void free_mel_bank(struct Mel_Bank* fb)
+{
+	if(fb == NULL) {
+		return;
 	}
-	free(melfb);
-	for(int i = 0; i < width; i++) {
-		free(applied[i]);
+	free(fb->start);
+	free(fb->length);
+	free(fb->offset);
+	free(fb->weights);
+	free(fb);
+}
+
+void free_mel_banks(void)
+{
+	pthread_mutex_lock(&fbs_lock);
+	while(fbs != NULL) {
+		struct Mel_Bank* next = fbs->next;
+		free_mel_bank(fbs);
+		fbs = next;
 	}
-	free(applied);
-	
-	return result;
+	pthread_mutex_unlock(&fbs_lock);
 }
 
-	     
+/** 
+ * @brief Applies a Mel filter bank to the input array
+ * 
+ * @param fb The filter bank
+ * @param array The FFT'ed sequence the filter bank is to be applied to, of length fb->width
+ * @param result Filled with fb->banks values
+ *
+ * Every product of zero counts as FLT_EPSILON, as in the dense bank, so the bins outside a band
+ * are added to it as a single amount.
+ */
+void mel_apply(const struct Mel_Bank* fb, const float* array, float* result)
+{
+	for(int j = 0; j < fb->banks; j++) {
+		const float* w = &fb->weights[fb->offset[j]];
+		const float* x = &array[fb->start[j]];
+		float sum = (fb->width - fb->length[j]) * FLT_EPSILON;
+		for(int k = 0; k < fb->length[j]; k++) {
+			float p = x[k] * w[k];
+			sum += (p == 0) ? FLT_EPSILON : p;
+		}
+		result[j] = sum;
+	}
+}
@@ -6,11 +6,36 @@
 #include <stdio.h>
 #include <math.h>
 #include <float.h>
+#include <pthread.h>
 
-#include "../Clustering/cluster.h"
-#include "../Dynamic_Time_Warping/dtw.h"
+/**
+ * \struct Mel_Bank
+ * \brief A triangular Mel filter bank stored as the non-zero span of each band
+ * @width The length of the FFT'ed sequences the bank is applied to
+ * @start The first FFT bin of each band
+ * @length The amount of bins of each band
+ * @offset The position of each band's first weight in @weights
+ * @weights The weights of every band, one after another
+ * @next The next bank in the cache of \fn mel_bank_cached()
+ */
+struct Mel_Bank {
+	int width;
+	int banks;
+	int nfft;
+	int rate;
+	float max_hz;
+	int first;
+	int* start;
+	int* length;
+	int* offset;
+	float* weights;
+	struct Mel_Bank* next;
+};
 
-float** mel_fb(int width, int banks);
-float* mel(float* array, int width, int banks);
+struct Mel_Bank* mel_bank(int width, int banks, int nfft, int rate, float max_hz, int first);
+struct Mel_Bank* mel_bank_cached(int width, int banks, int nfft, int rate, float max_hz, int first);
+void free_mel_bank(struct Mel_Bank* fb);
+void free_mel_banks(void);
+void mel_apply(const struct Mel_Bank* fb, const float* array, float* result);
 
 #endif
@@ -22,16 +22,15 @@ float max_mfcc = FLT_MIN;  /* The maximum value found in MFCCs during training;
  * @param inc The length of @param sequence.
  * 
  * @return The log entropy value.
+ *
+ * Samples which are whole int16 magnitudes are read from the entropy table, and @param sequence is left as it was.
  */
-float log_entropy(float* sequence, int inc)
+float log_entropy(const float* sequence, int inc)
 {
+	const double* table = entropy_table();
 	long double entropy = 0;
 	for(int m = 0; m < inc; m++) {
-		if(sequence[m] == 0) {
-			sequence[m] = 1;
-		}
-		sequence[m] = fabs(sequence[m]);
-		entropy += (sequence[m]) * (log(sequence[m]) / log(2));
+		entropy += f_entropy_term(table, sequence[m]);
 	}
 	if(entropy == 0.0)
 		return 0;
@@ -138,133 +137,47 @@ void update_mfcc_norm(float* mfcc, int length)
 	return;
 }
 
+/** 
+ * @brief Builds the MFCC extractor for the current configuration
+ * 
+ * @return The plan, one is needed for each thread producing MFCCs. Released with \fn free_mfcc_plan()
+ */
+struct Mfcc_Plan* default_mfcc_plan(void)
+{
+	int trunc = floor(glbl_banks * glbl_test_trunc);
+	int paa = (glbl_paa_op == 0) ? glbl_paa : 0;
+	return mfcc_plan(glbl_window_width, glbl_interval_div, glbl_banks, glbl_nfft, trunc, paa, glbl_frame_limit, 0);
+}
+
 /** 
  * @brief The control function that generates an MFCC from the given input audio sequence.
  * 
- * @param sequence The audio sequence to be processed
+ * @param plan The extractor, see \fn default_mfcc_plan()
+ * @param sequence The audio sequence to be processed, it is not modified or freed
  * @param width The length of @param sequence
- * @param incr The window width used for Hanning
- * @param banks The number of Mel filter banks to use
- * @param paa The Piece-wise aggregation divisor
  * 
- * @return The generated MFCC.
+ * @return The generated MFCC of \fn mfcc_size() values, NULL on failure
+ *
+ * With \var LOG_E the last coefficient of each frame is replaced by the frame's zero cross rate.
  */
-float* mfcc(float* sequence, int width, int incr, int banks, int paa)
+float* mfcc(struct Mfcc_Plan* plan, const float* sequence, int width)
 {
-
-	if(paa == 0) {
-		sequence = f_paa(sequence, width);
-		width = floor(width / glbl_paa);
-	}
-	/* if width < width * 2 || width * 1.5? then use non overlapping */
-	int amount = floor((width - (incr)) / (incr / glbl_interval_div));
-        if(amount > glbl_frame_limit) {
-		amount = glbl_frame_limit;
-	}
-	/* all points in window applied to all points of the window function */
-	float** chunks = hanning_chunks(sequence, width, incr);
-	if(amount <= 0) {
-		free(chunks);
-		chunks = NULL;
-	}
-	if(chunks == NULL) {
-		// printf("Hanning chunks with overlaps failed trying no overlap :: \n");
-		chunks = hanning_chunks_no_overlap(sequence, width, incr);
-		amount = floor(width / incr);
-		if(chunks == NULL) {
-			printf("Oops, no overlap failed as well, sequence is too short or window width is too large\nNo MFCC will be created or tested :: width : %d || incr :: %d\n", width, incr);
-			return NULL;
-		}
-	}
-
-	
-	float** mags = fft_chunks(chunks, amount, incr);
-	
-	for(int i = 0; i < amount; i++) { 
-		for (int low = 0, high = (incr / 2) - 1; low < high; low++, high--) {
-			float temp = mags[i][low];
-			mags[i][low] = mags[i][high];
-			mags[i][high] = temp;
-		}
-	}
-	
-	float** applied_mels = calloc(amount, sizeof(float*));
-	if(chunks == NULL || mags == NULL || applied_mels == NULL) {
+	int trunc = plan->trunc;
+	float* result = (float*)malloc((mfcc_frames(plan, width) * trunc) * sizeof(float));
+	if(result == NULL) {
 		printf("Malloc/Calloc error in mfcc\n");
 		return NULL;
 	}
-		
-	for(int i = 0; i < amount; i++) {
-		applied_mels[i] = (float*)calloc(banks,  sizeof(float));
-		if(applied_mels[i] == NULL) {
-			printf("Failed to calloc applied_mels[i]\n");
-			return NULL;
-		}
-		float* temp = mel(mags[i], (incr / 2), banks);
-		memcpy(applied_mels[i], temp, sizeof(float) * banks);
-		free(temp);
-	}
-	for(int i = 0; i < amount; i++) {
-		for(int j = 0; j < banks; j++) {
-			/* TODO :: Conditional jump or move depends on uninitialised value(s) */
-			if(applied_mels[i][j] <= 0) {
-				applied_mels[i][j] = FLT_EPSILON;
-			}
-			applied_mels[i][j] = log10(applied_mels[i][j]);	
-		}
-	}
-	for(int i = 0; i < amount; i++) {
-		float* temp = dct(applied_mels[i], banks);
-		for(int j = 0; j < banks; j++) {
-			applied_mels[i][j] = temp[j];
-			// memcpy(applied_mels[i], temp, sizeof(float) * banks);
-		}
-		free(temp);
+	int amount = mfcc_execute(plan, sequence, width, result);
+	if(amount < 0) {
+		free(result);
+		return NULL;
 	}
-	int trunc = floor(banks * glbl_test_trunc);
-	// int trunc = 1;
-	float* result = (float*)malloc((amount * trunc) * sizeof(float));
-	
-	int last = amount;
-
-	int n = 0;
-	int m = 0;
-	for(int i = 0; i < amount; i++) {
-		for(int j = 0; j < trunc; j++) {
-			if(fpclassify(applied_mels[i][j]) == FP_INFINITE || fpclassify(applied_mels[i][j]) == FP_NAN) {
-				result[n] = 0; // FLT_EPSILON;
-				printf("MFCC result contained NAN of INF :: %.3f || trunc := %d || amount := %d || i := %d || j := %d\n", applied_mels[i][j], trunc, amount, i, j);
-			} else {
-				result[n] = applied_mels[i][j];
-			}
-			if(LOG_E) {
-				if(m == (trunc - 1)) {
-					result[n] = f_cross_rate(chunks[i], glbl_window_width);
-				}
-				m++;
-				if(m >= trunc) {
-					m = 0;
-				}
-				
-			}
-			n++;
+	if(LOG_E) {
+		for(int i = 0; i < amount; i++) {
+			result[i * trunc + trunc - 1] = f_cross_rate((float*)mfcc_window_frame(plan, i), glbl_window_width);
 		}
-		
-		free(applied_mels[i]);
-	}
-	free(applied_mels);
-
-	for(int i = 0; i < (last); i++) {
-		free(chunks[i]);
 	}
-	free(chunks);
-
-	for(int i = 0; i < amount; i++) {
-		free(mags[i]);
-	}
-	free(mags);
-	free(sequence);	
 	// mfcc_window(result, trunc, amount);
 	return result;
 }
-
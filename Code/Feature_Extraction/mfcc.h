@@ -5,14 +5,20 @@
 #include "paa.h"
 #include "hanning.h"
 #include "fft.h"
+#include "mfcc_plan.h"
+#include "entropy.h"
 
 #include "../Clustering/cluster.h"
 
-float* mfcc(float* sequence, int size, int window, int banks, int paa);
+struct Mfcc_Plan* default_mfcc_plan(void);
+float* mfcc(struct Mfcc_Plan* plan, const float* sequence, int width);
 float log_energy(float* chunk, int length);
 void update_mfcc_norm(float* mfcc, int length);
 void normalise_mfcc(float* mfcc, int length);
 float kurtosis(float* chunk, int length);
-float log_entropy(float* sequence, int inc);
+float log_entropy(const float* sequence, int inc);
+
+extern float min_mfcc;
+extern float max_mfcc;
 
 #endif
@@ -0,0 +1,322 @@
+/**
+ * @file   mfcc_plan.c
+ * @brief  The allocation free MFCC extractor used for training, testing and on the device
+ *
+ * Each frame is read from the signal at its offset and windowed as it is loaded into \fn fft_real(),
+ * the magnitudes reversed and passed through the Mel filter bank, then the log energies are reduced
+ * to @trunc coefficients by the DCT.
+ */
+#include "mfcc_plan.h"
+
+/**
+ * \struct Hanning_Table
+ * \brief A Hanning window shared by every plan of its width and variant
+ */
+struct Hanning_Table {
+	int width;
+	int device;
+	float* window;
+	struct Hanning_Table* next;
+};
+
+static struct Hanning_Table* tables = NULL;                 /* The windows built by \fn hanning_cached() */
+static pthread_mutex_t tables_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * @brief Finds the Hanning window of @param width coefficients, building it on first use
+ *
+ * @param device If set the real-time extractor's window, offset by one sample
+ *
+ * @return The shared window, which must not be freed by the caller, or NULL if it could not be built
+ *
+ * Windows are kept until \fn free_hanning_tables() and may be used by several threads at once.
+ */
+const float* hanning_cached(int width, int device)
+{
+	pthread_mutex_lock(&tables_lock);
+	struct Hanning_Table* table = tables;
+	while(table != NULL && (table->width != width || table->device != device)) {
+		table = table->next;
+	}
+	if(table == NULL && width > 0) {
+		table = (struct Hanning_Table*)malloc(sizeof(struct Hanning_Table));
+		float* window = (float*)malloc(sizeof(float) * width);
+		if(table == NULL || window == NULL) {
+			printf("Failed to malloc the %d value Hanning window\n", width);
+			free(table);
+			free(window);
+			pthread_mutex_unlock(&tables_lock);
+			return NULL;
+		}
+		for(int k = 0; k < width; k++) {
+			float mult = 0;
+			if(device) {
+				mult = 0.5 * (1 - cos(2*M_PI*(k+1)/(width + 1)));
+			} else {
+				mult = 0.5 * (1 - cos(2*M_PI*(k)/(width)));
+			}
+			window[k] = mult;
+		}
+		table->width = width;
+		table->device = device;
+		table->window = window;
+		table->next = tables;
+		tables = table;
+	}
+	pthread_mutex_unlock(&tables_lock);
+	return (table != NULL) ? table->window : NULL;
+}
+
+void free_hanning_tables(void)
+{
+	pthread_mutex_lock(&tables_lock);
+	while(tables != NULL) {
+		struct Hanning_Table* next = tables->next;
+		free(tables->window);
+		free(tables);
+		tables = next;
+	}
+	pthread_mutex_unlock(&tables_lock);
+}
+
+/**
+ * @brief Builds an MFCC extractor
+ *
+ * @param width The window width, a power of two
+ * @param overlap The division of @param width between overlapping windows
+ * @param banks The number of Mel filter banks
+ * @param nfft The NFFT used when creating the filter bank
+ * @param trunc The amount of coefficients kept from each frame
+ * @param paa The PAA divisor applied to the signal first, 0 for none
+ * @param frame_limit The largest amount of frames produced
+ * @param device If set the real-time extractor's variant is produced. Its Hanning window is offset by one
+ *               sample, its filter bank tops out at 7700Hz from bin 1 and is divided by @param banks, and a
+ *               silent frame is appended as the last frame.
+ *
+ * @return The plan, or NULL if it could not be built
+ */
+struct Mfcc_Plan* mfcc_plan(int width, int overlap, int banks, int nfft, int trunc, int paa, int frame_limit, int device)
+{
+	struct Mfcc_Plan* plan = (struct Mfcc_Plan*)calloc(1, sizeof(struct Mfcc_Plan));
+	if(plan == NULL) {
+		printf("Failed to malloc 'plan' in MFCC\n");
+		return NULL;
+	}
+	plan->width = width;
+	plan->hop = width / overlap;
+	plan->banks = banks;
+	plan->nfft = nfft;
+	plan->trunc = trunc;
+	plan->paa = paa;
+	plan->frame_limit = frame_limit;
+	plan->device = device;
+	plan->fft = fft_plan_cached(width / 2);
+	if(device) {
+		plan->fb = mel_bank_cached(width / 2, banks, nfft, 16000, 7700, 1);
+	} else {
+		plan->fb = mel_bank_cached(width / 2, banks, nfft, 16000, 4000, 0);
+	}
+	plan->dct = dct_plan_cached(banks, trunc);
+	plan->window = hanning_cached(width, device);
+	plan->frame = (float*)malloc(sizeof(float) * width);
+	plan->spectrum = (float complex*)malloc(sizeof(float complex) * (width / 2));
+	plan->mags = (float*)malloc(sizeof(float) * (width / 2));
+	plan->mels = (float*)malloc(sizeof(float) * banks);
+	if(plan->dct != NULL && plan->dct->fft != NULL) {
+		plan->dct_buff = (float complex*)malloc(sizeof(float complex) * banks);
+	}
+	if(plan->hop <= 0 || plan->fft == NULL || plan->fb == NULL || plan->dct == NULL || plan->window == NULL || plan->frame == NULL || plan->spectrum == NULL ||
+	   plan->mags == NULL || plan->mels == NULL || (plan->dct->fft != NULL && plan->dct_buff == NULL)) {
+		printf("Failed to build the MFCC plan :: width : %d || overlap : %d || banks : %d\n", width, overlap, banks);
+		free_mfcc_plan(plan);
+		return NULL;
+	}
+	return plan;
+}
+
+void free_mfcc_plan(struct Mfcc_Plan* plan)
+{
+	if(plan == NULL) {
+		return;
+	}
+	free(plan->signal);
+	free(plan->frame);
+	free(plan->spectrum);
+	free(plan->mags);
+	free(plan->mels);
+	free(plan->dct_buff);
+	free(plan);
+}
+
+/**
+ * @brief The amount of frames of a signal after PAA, and if they overlap
+ */
+static int frame_layout(const struct Mfcc_Plan* plan, int width, int* overlap)
+{
+	int amount = 0;
+	if(plan->device) {
+		amount = floor((width - plan->width) / plan->hop) + 1;
+	} else {
+		amount = floor((width - plan->width) / plan->hop);
+		if(amount > plan->frame_limit) {
+			amount = plan->frame_limit;
+		}
+	}
+	*overlap = 1;
+	if(amount <= 0) {
+		*overlap = 0;
+		amount = floor(width / plan->width);
+	}
+	if(amount > plan->frame_limit) {
+		amount = plan->frame_limit;
+	}
+	return amount;
+}
+
+/**
+ * @brief The amount of frames \fn mfcc_execute() produces from a signal
+ *
+ * @param length The length of the signal before PAA
+ */
+int mfcc_frames(const struct Mfcc_Plan* plan, int length)
+{
+	int overlap = 0;
+	int width = plan->paa ? floor(length / plan->paa) : length;
+	return frame_layout(plan, width, &overlap);
+}
+
+/**
+ * @brief The first sample of frame @param i within the current signal, NULL for the device's silent frame
+ */
+static const float* frame_start(const struct Mfcc_Plan* plan, int i)
+{
+	if(plan->device && i == plan->frames - 1) {
+		return NULL;
+	}
+	return &plan->x[plan->overlap ? i * plan->hop : i * plan->width];
+}
+
+/**
+ * @brief Loads the windowed frame starting at @param x into @param spectrum, two samples to each complex value as \fn fft_real() expects
+ */
+static void load_frame(const struct Mfcc_Plan* plan, const float* x, float complex* spectrum)
+{
+	const float* w = plan->window;
+	if(x == NULL) {
+		memset(spectrum, 0, sizeof(float complex) * (plan->width / 2));
+		return;
+	}
+	for(int k = 0; k < plan->width / 2; k++) {
+		spectrum[k] = CMPLXF(w[2 * k] * x[2 * k], w[2 * k + 1] * x[2 * k + 1]);
+	}
+}
+
+/**
+ * @brief Produces the coefficients of a single frame
+ *
+ * @param plan The extractor
+ * @param x The @width samples of the frame, or NULL for a silent frame
+ * @param coeffs Filled with @trunc coefficients
+ */
+void mfcc_frame(struct Mfcc_Plan* plan, const float* x, float* coeffs)
+{
+	int half = plan->width / 2;
+	load_frame(plan, x, plan->spectrum);
+	fft_real(plan->fft, plan->spectrum);
+	for(int k = 0; k < half; k++) {
+		plan->mags[half - 1 - k] = cabsf(plan->spectrum[k]);
+	}
+	mel_apply(plan->fb, plan->mags, plan->mels);
+	for(int j = 0; j < plan->banks; j++) {
+		if(plan->device) {
+			plan->mels[j] = plan->mels[j] / plan->banks;
+		}
+		if(plan->mels[j] <= 0) {
+			plan->mels[j] = FLT_EPSILON;
+		}
+		plan->mels[j] = log10(plan->mels[j]);
+	}
+	dct_execute(plan->dct, plan->mels, coeffs, plan->dct_buff);
+	for(int j = 0; j < plan->trunc; j++) {
+		if(fpclassify(coeffs[j]) == FP_INFINITE || fpclassify(coeffs[j]) == FP_NAN) {
+			printf("MFCC result contained NAN of INF :: %.3f || trunc := %d || j := %d\n", coeffs[j], plan->trunc, j);
+			coeffs[j] = 0;
+		}
+	}
+}
+
+/**
+ * @brief Produces the MFCC of a signal
+ *
+ * @param plan The extractor
+ * @param in The signal, which is not modified
+ * @param length The length of @param in
+ * @param out Filled with \fn mfcc_frames() * trunc coefficients
+ *
+ * @return The amount of frames produced, or -1 if the PAA scratch could not be grown
+ */
+int mfcc_execute(struct Mfcc_Plan* plan, const float* in, int length, float* out)
+{
+	if(plan->paa) {
+		int width = floor(length / plan->paa);
+		if(width > plan->signal_size) {
+			float* signal = (float*)realloc(plan->signal, sizeof(float) * width);
+			if(signal == NULL) {
+				printf("Failed to realloc 'signal' in MFCC\n");
+				return -1;
+			}
+			plan->signal = signal;
+			plan->signal_size = width;
+		}
+		f_paa_into(in, length, plan->paa, plan->signal);
+		plan->x = plan->signal;
+		plan->x_length = width;
+	} else {
+		plan->x = in;
+		plan->x_length = length;
+	}
+	plan->frames = frame_layout(plan, plan->x_length, &plan->overlap);
+
+	for(int i = 0; i < plan->frames; i++) {
+		mfcc_frame(plan, frame_start(plan, i), &out[i * plan->trunc]);
+	}
+	return plan->frames;
+}
+
+/**
+ * @brief The windowed frame @param i of the signal last passed to \fn mfcc_execute()
+ *
+ * @return The frame, valid until the plan is used again and while that signal is
+ */
+const float* mfcc_window_frame(struct Mfcc_Plan* plan, int i)
+{
+	const float* x = frame_start(plan, i);
+	for(int k = 0; k < plan->width; k++) {
+		plan->frame[k] = (x == NULL) ? 0 : plan->window[k] * x[k];
+	}
+	return plan->frame;
+}
+
+/**
+ * @brief Applies PAA to the input sequence, writing the length / @param paa result to @param out
+ *
+ * The input signal is divided by the PAA amount set by the user, with each grouping being averaged into one value
+ */
+void f_paa_into(const float* sequence, int length, int paa, float* out)
+{
+	int n_length = floor(length / paa);
+	if(n_length <= 0) {
+		return;
+	}
+	memcpy(out, sequence, sizeof(float) * n_length);
+	int sum = 0, num = 0;
+	for(int i = 0; i < paa; i++) {
+		sum = sum + sequence[i];
+		if(i % paa == 0) {
+			num = sum / paa;
+			out[i / paa] = num;
+			num = 0;
+			sum = 0;
+		}
+	}
+}
@@ -0,0 +1,73 @@
+#ifndef MFCC_PLAN_H
+#define MFCC_PLAN_H
+
+/**
+ * @file   mfcc_plan.h
+ * @brief  An MFCC extractor which owns all of its scratch memory
+ *
+ * A plan is built once for a configuration and is then used for any amount of signals without
+ * allocating. The scratch is part of the plan, so each thread needs its own. The Hanning, FFT, Mel
+ * and DCT tables are shared between plans through their caches.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+#include <float.h>
+#include <complex.h>
+#include <pthread.h>
+#include "fft.h"
+#include "mel.h"
+
+/**
+ * \struct Mfcc_Plan
+ * \brief The configuration, tables and scratch of the MFCC extractor
+ * @width The window width
+ * @hop The distance between overlapping windows, @width / overlap
+ * @trunc The amount of coefficients kept from each frame
+ * @paa The PAA divisor applied to the signal first, 0 for none
+ * @frame_limit The largest amount of frames produced
+ * @device If the real-time extractor's variant is used, see \fn mfcc_plan()
+ * @window The Hanning window coefficients, @width values from \fn hanning_cached()
+ * @x The PAA'd signal of the last \fn mfcc_execute(), or its input if @paa is 0
+ * @x_length The length of @x
+ * @overlap If the frames of @x overlap
+ * @frames The amount of frames of @x
+ */
+struct Mfcc_Plan {
+	int width;
+	int hop;
+	int banks;
+	int nfft;
+	int trunc;
+	int paa;
+	int frame_limit;
+	int device;
+	struct Fft_Plan* fft;
+	struct Mel_Bank* fb;
+	struct Dct_Plan* dct;
+	const float* window;
+	float* signal;
+	int signal_size;
+	const float* x;
+	int x_length;
+	int overlap;
+	int frames;
+	float* frame;
+	float complex* spectrum;
+	float* mags;
+	float* mels;
+	float complex* dct_buff;
+};
+
+struct Mfcc_Plan* mfcc_plan(int width, int overlap, int banks, int nfft, int trunc, int paa, int frame_limit, int device);
+void free_mfcc_plan(struct Mfcc_Plan* plan);
+int mfcc_frames(const struct Mfcc_Plan* plan, int length);
+int mfcc_execute(struct Mfcc_Plan* plan, const float* in, int length, float* out);
+void mfcc_frame(struct Mfcc_Plan* plan, const float* x, float* coeffs);
+const float* mfcc_window_frame(struct Mfcc_Plan* plan, int i);
+const float* hanning_cached(int width, int device);
+void free_hanning_tables(void);
+void f_paa_into(const float* sequence, int length, int paa, float* out);
+
+#endif
@@ -0,0 +1,154 @@
+/**
+ * @file   mfcc_stream.c
+ * @brief  The streaming MFCC extractor used on the device
+ *
+ * Each sample is written to a ring of one window, kept twice over so that the newest window is always
+ * contiguous. Whenever a hop completes that window is passed to \fn mfcc_frame() and the coefficients
+ * are stored in the history, which wraps after @history_size frames.
+ */
+#include "mfcc_stream.h"
+
+/**
+ * @brief Builds a streaming extractor
+ *
+ * @param plan The extractor used for each frame, which the stream uses but does not own
+ * @param history_size The amount of frames kept, at least five
+ * @param deltas If the delta coefficients of each frame are kept
+ *
+ * @return The stream, or NULL if it could not be built
+ */
+struct Mfcc_Stream* mfcc_stream(struct Mfcc_Plan* plan, int history_size, int deltas)
+{
+	if(plan == NULL) {
+		return NULL;
+	}
+	if(history_size < 5) {
+		history_size = 5;
+	}
+	struct Mfcc_Stream* stream = (struct Mfcc_Stream*)calloc(1, sizeof(struct Mfcc_Stream));
+	if(stream == NULL) {
+		printf("Failed to malloc 'stream' in MFCC\n");
+		return NULL;
+	}
+	stream->plan = plan;
+	stream->history_size = history_size;
+	stream->ring = (float*)calloc(2 * plan->width, sizeof(float));
+	stream->history = (float*)malloc(sizeof(float) * history_size * plan->trunc);
+	stream->silence = (float*)malloc(sizeof(float) * plan->trunc);
+	if(deltas) {
+		stream->deltas = (float*)malloc(sizeof(float) * history_size * plan->trunc);
+	}
+	if(stream->ring == NULL || stream->history == NULL || stream->silence == NULL || (deltas && stream->deltas == NULL)) {
+		printf("Failed to build the MFCC stream :: history : %d\n", history_size);
+		free_mfcc_stream(stream);
+		return NULL;
+	}
+	mfcc_frame(plan, NULL, stream->silence);
+	return stream;
+}
+
+void free_mfcc_stream(struct Mfcc_Stream* stream)
+{
+	if(stream == NULL) {
+		return;
+	}
+	free(stream->ring);
+	free(stream->history);
+	free(stream->deltas);
+	free(stream->silence);
+	free(stream);
+}
+
+/**
+ * @brief The slot of frame @param i within the history
+ */
+static float* history_slot(float* history, const struct Mfcc_Stream* stream, long i)
+{
+	return &history[(i % stream->history_size) * stream->plan->trunc];
+}
+
+/**
+ * @brief Stores the delta coefficients of frame @param i, which needs the two frames either side
+ *
+ * The difference is taken across two frames as in \fn delta(), clamped at the start of the stream.
+ */
+static void update_delta(struct Mfcc_Stream* stream, long i)
+{
+	const float* next = history_slot(stream->history, stream, i + 2);
+	const float* prev = history_slot(stream->history, stream, (i < 2) ? 0 : i - 2);
+	float* d = history_slot(stream->deltas, stream, i);
+	for(int m = 0; m < stream->plan->trunc; m++) {
+		d[m] = next[m] - prev[m];
+	}
+}
+
+/**
+ * @brief Adds samples to the stream, producing each frame which they complete
+ *
+ * @param stream The stream
+ * @param in The samples, which may be of any amount
+ * @param length The length of @param in
+ *
+ * @return The amount of frames produced
+ */
+int mfcc_stream_push(struct Mfcc_Stream* stream, const short* in, int length)
+{
+	struct Mfcc_Plan* plan = stream->plan;
+	int produced = 0;
+	for(int i = 0; i < length; i++) {
+		int pos = stream->samples % plan->width;
+		stream->ring[pos] = in[i];
+		stream->ring[pos + plan->width] = in[i];
+		stream->samples++;
+		if(stream->samples - stream->next < plan->width) {
+			continue;
+		}
+		const float* x = &stream->ring[stream->next % plan->width];
+		mfcc_frame(plan, x, history_slot(stream->history, stream, stream->frames));
+		stream->frames++;
+		stream->next += plan->hop;
+		if(stream->deltas != NULL && stream->frames >= 3) {
+			update_delta(stream, stream->frames - 3);
+		}
+		produced++;
+	}
+	return produced;
+}
+
+/**
+ * @brief The first frame starting at or after @param sample, which may not have been produced yet
+ */
+long mfcc_stream_frame_at(const struct Mfcc_Stream* stream, long sample)
+{
+	if(sample <= 0) {
+		return 0;
+	}
+	return (sample + stream->plan->hop - 1) / stream->plan->hop;
+}
+
+/**
+ * @brief The coefficients of frame @param i
+ *
+ * @return The @trunc coefficients, or NULL if the frame has not been produced or has left the history
+ */
+const float* mfcc_stream_frame(const struct Mfcc_Stream* stream, long i)
+{
+	if(i < 0 || i >= stream->frames || i < stream->frames - stream->history_size) {
+		return NULL;
+	}
+	return history_slot(stream->history, stream, i);
+}
+
+/**
+ * @brief The delta coefficients of frame @param i
+ *
+ * @return The @trunc coefficients, or NULL if they are not kept, the frame two after @param i has not been
+ *         produced, or the frame has left the history
+ */
+const float* mfcc_stream_delta(const struct Mfcc_Stream* stream, long i)
+{
+	if(stream->deltas == NULL || i < 0 || i + 2 >= stream->frames || i < stream->frames - stream->history_size) {
+		return NULL;
+	}
+	return history_slot(stream->deltas, stream, i);
+}
@@ -0,0 +1,47 @@
+#ifndef MFCC_STREAM_H
+#define MFCC_STREAM_H
+
+/**
+ * @file   mfcc_stream.h
+ * @brief  An incremental MFCC extractor for audio which arrives in pieces
+ *
+ * Samples are pushed in chunks of any size and a frame is produced as soon as its last sample
+ * arrives, so features lag the audio by at most one hop. The frames are kept in a rolling history
+ * indexed by their frame number since the stream began.
+ */
+
+#include "mfcc_plan.h"
+
+/**
+ * \struct Mfcc_Stream
+ * \brief The sample ring and rolling feature history of a streaming MFCC extractor
+ * @plan The extractor each frame is produced with, whose @paa is not applied
+ * @ring The last @plan->width samples, written twice so that any frame is contiguous
+ * @samples The amount of samples pushed since the stream began
+ * @next The first sample of the next frame to be produced
+ * @history The coefficients of the last @history_size frames, @plan->trunc values each
+ * @deltas The delta coefficients of the frames in @history, NULL if they are not kept
+ * @history_size The amount of frames kept
+ * @frames The amount of frames produced since the stream began
+ * @silence The coefficients of a silent frame
+ */
+struct Mfcc_Stream {
+	struct Mfcc_Plan* plan;
+	float* ring;
+	long samples;
+	long next;
+	float* history;
+	float* deltas;
+	int history_size;
+	long frames;
+	float* silence;
+};
+
+struct Mfcc_Stream* mfcc_stream(struct Mfcc_Plan* plan, int history_size, int deltas);
+void free_mfcc_stream(struct Mfcc_Stream* stream);
+int mfcc_stream_push(struct Mfcc_Stream* stream, const short* in, int length);
+long mfcc_stream_frame_at(const struct Mfcc_Stream* stream, long sample);
+const float* mfcc_stream_frame(const struct Mfcc_Stream* stream, long i);
+const float* mfcc_stream_delta(const struct Mfcc_Stream* stream, long i);
+
+#endif
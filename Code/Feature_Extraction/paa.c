@@ -64,28 +64,14 @@ float* f_paa(float* sequence, int length) {
 
 	int n_length = floor(length/glbl_paa);
 	
-	float* temp = malloc(sizeof(float) * length);
-	for(int i = 0; i < length; i++) {
-		memcpy(&temp[i], &sequence[i], sizeof(float));
-	}
-	float* new = f_realloc(sequence, n_length);
-	
+	float* new = malloc(sizeof(float) * n_length);
 	if (new == NULL) {
 		fprintf(stderr, "Memory error, trying to allocate %d length which is %d bytes.\n", (int)length, (int)(length*sizeof(float)));
 		free(sequence);
 		exit(-1);
 	}
-	int sum = 0, num = 0;
-	for(int i = 0; i < glbl_paa; i++) {
-		sum = sum + temp[i];
-		if(i % glbl_paa == 0) {
-			num = sum / glbl_paa;
-			new[i / glbl_paa] = num;
-			num = 0;
-			sum = 0;
-		}
-	}
-	free(temp);
+	f_paa_into(sequence, length, glbl_paa, new);
+	free(sequence);
 	return new;
 	
 }
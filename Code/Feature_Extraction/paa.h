@@ -7,6 +7,7 @@
 #include <memory.h>
 #include "../Training/train.h"
 #include "../Misc/realloc.h"
+#include "mfcc_plan.h"
 
 short* paa(short* sequence, int length);
 float* f_paa(float* sequence, int length);
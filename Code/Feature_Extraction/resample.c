@@ -0,0 +1,150 @@
+/**
+ * @file   resample.c
+ * @brief  Resampling a signal to a new length, see @file resample.h
+ *
+ * RESAMPLE_INSERT produces the same samples as inserting one midpoint at a time, shifting the rest of
+ * the signal each time, but each pass over the signal is a single merge. The signal being padded is
+ * kept at the end of the output and the padded signal written from its start, which never overtakes
+ * the samples still to be read as at most one sample is inserted per sample read.
+ */
+#include "resample.h"
+
+/* The smallest signal padded with RESAMPLE_INSERT, shorter signals are interpolated linearly */
+#define INSERT_MIN 16
+
+/**
+ * @brief The midpoint of @param y1 and @param y2 inserted into int16 signals
+ * The interpolation was done in shorts, which truncates mu squared to 0 and leaves (y2 - y0) / 2 + y1.
+ */
+static int16_t insert_s16(int16_t y0, int16_t y1, int16_t y2, int16_t y3)
+{
+	(void)y3;
+	int16_t a2 = (int16_t)(y2 - y0);
+	return (int16_t)(int)(a2 * 0.5 + y1);
+}
+
+static double cubic_d(double y0, double y1, double y2, double y3, double mu)
+{
+	double mu2 = mu * mu;
+	double a0 = y3 - y2 - y0 + y1;
+	double a1 = y0 - y1 - a0;
+	double a2 = y2 - y0;
+	double a3 = y1;
+	return(a0*mu*mu2+a1*mu2+a2*mu+a3);
+}
+
+static long double cubic_ld(long double y0, long double y1, long double y2, long double y3, long double mu)
+{
+	long double mu2 = mu * mu;
+	long double a0 = y3 - y2 - y0 + y1;
+	long double a1 = y0 - y1 - a0;
+	long double a2 = y2 - y0;
+	long double a3 = y1;
+	return(a0*mu*mu2+a1*mu2+a2*mu+a3);
+}
+
+static float insert_f(float y0, float y1, float y2, float y3)
+{
+	return cubic_d(y0, y1, y2, y3, 0.5);
+}
+
+static long double insert_ld(long double y0, long double y1, long double y2, long double y3)
+{
+	return cubic_ld(y0, y1, y2, y3, 0.5);
+}
+
+static int16_t store_s16(double v)
+{
+	v = round(v);
+	return (v > INT16_MAX) ? INT16_MAX : (v < INT16_MIN) ? INT16_MIN : (int16_t)v;
+}
+
+static float store_f(double v)
+{
+	return v;
+}
+
+static long double store_ld(long double v)
+{
+	return v;
+}
+
+/**
+ * Defines resample_@sfx for signals of @type, interpolated in @acc.
+ *
+ * @in The signal, @n samples
+ * @out The resampled signal, @l samples, allocated by the caller and not overlapping @in
+ * @method RESAMPLE_INSERT, RESAMPLE_LINEAR or RESAMPLE_CUBIC
+ * @first The sample the first RESAMPLE_INSERT pass starts at
+ *
+ * RESAMPLE_INSERT only lengthens signals of at least INSERT_MIN samples, others are interpolated linearly.
+ */
+#define RESAMPLE(sfx, type, acc)												\
+void resample_##sfx(const type* in, int n, type* out, int l, int method, int first)						\
+{																\
+	if(l <= 0) {														\
+		return;														\
+	}															\
+	if(n <= 1) {														\
+		for(int j = 0; j < l; j++) {											\
+			out[j] = (n == 1) ? in[0] : 0;										\
+		}														\
+		return;														\
+	}															\
+	if(method == RESAMPLE_INSERT && l >= n && n >= INSERT_MIN) {								\
+		int cur = n;													\
+		int i = (first < 2) ? 2 : (first > n - 6) ? n - 6 : first;							\
+		memcpy(&out[l - n], in, sizeof(type) * n);									\
+		while(cur < l) {												\
+			type* src = &out[l - cur];										\
+			memmove(out, src, sizeof(type) * i);									\
+			type y0 = out[i - 2], y1 = out[i - 1];									\
+			int k = 0;												\
+			while(1) {												\
+				type y2 = src[i + k], y3 = src[i + k + 1];							\
+				type x = insert_##sfx(y0, y1, y2, y3);								\
+				out[i + 2 * k] = x;										\
+				out[i + 2 * k + 1] = y2;									\
+				y0 = x;												\
+				y1 = y2;											\
+				k++;												\
+				if(cur + k == l) {										\
+					break;											\
+				}												\
+				if(i + 2 * (k - 1) + 2 >= cur + k - 5) {							\
+					break;											\
+				}												\
+			}													\
+			memmove(&out[i + 2 * k], &src[i + k], sizeof(type) * (cur - i - k));					\
+			cur += k;												\
+			i = 7;													\
+			if(cur < l) {												\
+				memmove(&out[l - cur], out, sizeof(type) * cur);						\
+			}													\
+		}														\
+		return;														\
+	}															\
+	for(int j = 0; j < l; j++) {												\
+		acc x = (l == 1) ? 0 : (acc)j * (n - 1) / (l - 1);								\
+		int a = (int)x;													\
+		if(a > n - 2) {													\
+			a = n - 2;												\
+		}														\
+		acc mu = x - a;													\
+		if(method == RESAMPLE_CUBIC) {											\
+			acc y0 = in[(a > 0) ? a - 1 : 0];									\
+			acc y3 = in[(a + 2 < n) ? a + 2 : n - 1];								\
+			out[j] = store_##sfx(cubic_##sfx##_acc(y0, in[a], in[a + 1], y3, mu));				\
+		} else {													\
+			out[j] = store_##sfx(in[a] + ((acc)in[a + 1] - in[a]) * mu);						\
+		}														\
+	}															\
+}
+
+#define cubic_s16_acc cubic_d
+#define cubic_f_acc   cubic_d
+#define cubic_ld_acc  cubic_ld
+
+RESAMPLE(s16, int16_t, double)
+RESAMPLE(f, float, double)
+RESAMPLE(ld, long double, long double)
@@ -0,0 +1,27 @@
+#ifndef RESAMPLE_H
+#define RESAMPLE_H
+
+/**
+ * @file   resample.h
+ * @brief  Resampling a signal to a new length in one pass, for int16 signals, float signals and long double accumulators
+ *
+ * RESAMPLE_INSERT is the padding used when the prototypes were first trained, a cubic midpoint inserted
+ * after every sample from @first to near the end and then again from the start, until the length is
+ * reached. It is kept as the default so models and results are unchanged. RESAMPLE_LINEAR and
+ * RESAMPLE_CUBIC instead spread the samples evenly over the new length.
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#define RESAMPLE_INSERT 0
+#define RESAMPLE_LINEAR 1
+#define RESAMPLE_CUBIC  2
+
+void resample_s16(const int16_t* in, int n, int16_t* out, int l, int method, int first);
+void resample_f(const float* in, int n, float* out, int l, int method, int first);
+void resample_ld(const long double* in, int n, long double* out, int l, int method, int first);
+
+#endif
@@ -0,0 +1,252 @@
+/**
+ * @file   corpus.c
+ * @brief  Packing and mapping corpora, see @file corpus.h
+ */
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "corpus.h"
+
+/**
+ * @brief Maps a packed corpus, checking every table entry lies within the file
+ *
+ * @param phonemes The amount of phonemes a segment may be labelled with
+ *
+ * @return The corpus, released with \fn corpus_unmap(), or NULL if it could not be read or is damaged
+ */
+struct Corpus* corpus_map(const char* path, int phonemes)
+{
+	int fd = open(path, O_RDONLY);
+	if(fd < 0) {
+		printf("Failed to open the corpus '%s'\n", path);
+		return NULL;
+	}
+	struct stat st;
+	if(fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(struct Corpus_Header)) {
+		printf("The corpus '%s' is too short\n", path);
+		close(fd);
+		return NULL;
+	}
+	void* map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if(map == MAP_FAILED) {
+		printf("Failed to map the corpus '%s'\n", path);
+		return NULL;
+	}
+	const unsigned char* file = (const unsigned char*)map;
+	const struct Corpus_Header* header = (const struct Corpus_Header*)map;
+	uint64_t size = st.st_size;
+	if(memcmp(header->magic, CORPUS_MAGIC, sizeof(header->magic)) != 0 || header->version != CORPUS_VERSION || header->order != 0x01020304 ||
+	   sizeof(struct Corpus_Header) + header->samples * sizeof(int16_t) > header->utterance_offset ||
+	   header->utterance_offset + (uint64_t)header->utterances * sizeof(struct Corpus_Utterance) > header->segment_offset ||
+	   header->segment_offset + (uint64_t)header->segments * sizeof(struct Corpus_Segment) > header->name_offset ||
+	   header->name_offset + header->name_size != size ||
+	   (header->name_size > 0 && file[size - 1] != '\0')) {
+		printf("'%s' is not a version %d corpus for this host, or is damaged\n", path, CORPUS_VERSION);
+		munmap(map, st.st_size);
+		return NULL;
+	}
+	struct Corpus* corpus = (struct Corpus*)malloc(sizeof(struct Corpus));
+	if(corpus == NULL) {
+		printf("Failed to malloc 'corpus'\n");
+		munmap(map, st.st_size);
+		return NULL;
+	}
+	corpus->header = header;
+	corpus->audio = (const int16_t*)&file[sizeof(struct Corpus_Header)];
+	corpus->utterances = (const struct Corpus_Utterance*)&file[header->utterance_offset];
+	corpus->segments = (const struct Corpus_Segment*)&file[header->segment_offset];
+	corpus->names = (const char*)&file[header->name_offset];
+	corpus->map = map;
+	corpus->map_size = st.st_size;
+	for(uint32_t u = 0; u < header->utterances; u++) {
+		const struct Corpus_Utterance* utt = &corpus->utterances[u];
+		if(utt->offset + utt->length > header->samples || (uint64_t)utt->first + utt->count > header->segments || utt->name >= header->name_size) {
+			printf("The corpus '%s' is damaged at utterance %u\n", path, u);
+			corpus_unmap(corpus);
+			return NULL;
+		}
+		for(uint32_t s = utt->first; s < utt->first + utt->count; s++) {
+			if(corpus->segments[s].utterance != u) {
+				printf("The corpus '%s' is damaged at utterance %u, segment %u belongs to another\n", path, u, s);
+				corpus_unmap(corpus);
+				return NULL;
+			}
+		}
+	}
+	for(uint32_t s = 0; s < header->segments; s++) {
+		const struct Corpus_Segment* seg = &corpus->segments[s];
+		if(seg->utterance >= header->utterances || seg->start < 0 || seg->start > seg->end ||
+		   (uint32_t)seg->end > corpus->utterances[seg->utterance].length || seg->phoneme < 0 || seg->phoneme >= phonemes) {
+			printf("The corpus '%s' is damaged at segment %u\n", path, s);
+			corpus_unmap(corpus);
+			return NULL;
+		}
+	}
+	posix_madvise(map, st.st_size, POSIX_MADV_SEQUENTIAL);
+	return corpus;
+}
+
+void corpus_unmap(struct Corpus* corpus)
+{
+	if(corpus == NULL) {
+		return;
+	}
+	munmap(corpus->map, corpus->map_size);
+	free(corpus);
+}
+
+/**
+ * @brief The name of utterance @param u
+ */
+const char* corpus_name(const struct Corpus* corpus, int u)
+{
+	return &corpus->names[corpus->utterances[u].name];
+}
+
+static void write_bytes(struct Corpus_Writer* cw, const void* data, size_t size)
+{
+	if(!cw->failed && size > 0 && fwrite(data, 1, size, cw->fp) != size) {
+		cw->failed = 1;
+	}
+}
+
+/**
+ * @brief Pads the file to a multiple of 8 bytes so the following table is aligned once mapped
+ */
+static uint64_t align_file(struct Corpus_Writer* cw, uint64_t at)
+{
+	const char zeros[8] = {0};
+	write_bytes(cw, zeros, (8 - at % 8) % 8);
+	return at + (8 - at % 8) % 8;
+}
+
+/**
+ * @brief Starts packing a corpus to @param path
+ *
+ * @return The writer, whose corpus is completed by \fn corpus_finish(), or NULL if the file could not be opened
+ */
+struct Corpus_Writer* corpus_writer(const char* path)
+{
+	struct Corpus_Writer* cw = (struct Corpus_Writer*)calloc(1, sizeof(struct Corpus_Writer));
+	if(cw == NULL) {
+		printf("Failed to malloc 'cw' in corpus\n");
+		return NULL;
+	}
+	cw->fp = fopen(path, "wb");
+	if(cw->fp == NULL) {
+		printf("Failed to open '%s' to pack the corpus\n", path);
+		free(cw);
+		return NULL;
+	}
+	memcpy(cw->header.magic, CORPUS_MAGIC, sizeof(cw->header.magic));
+	cw->header.version = CORPUS_VERSION;
+	cw->header.order = 0x01020304;
+	write_bytes(cw, &cw->header, sizeof(cw->header));
+	return cw;
+}
+
+/**
+ * @brief Adds an utterance, which the following segments belong to
+ *
+ * @param name The utterance's name, kept for the result files
+ * @param samples The utterance's audio
+ * @param length The length of @param samples
+ *
+ * @return 0, or -1 if the tables could not be grown
+ */
+int corpus_add_utterance(struct Corpus_Writer* cw, const char* name, const int16_t* samples, int length)
+{
+	uint32_t u = cw->header.utterances;
+	if(u % 256 == 0) {
+		struct Corpus_Utterance* utterances = (struct Corpus_Utterance*)realloc(cw->utterances, sizeof(struct Corpus_Utterance) * (u + 256));
+		if(utterances == NULL) {
+			printf("Failed to realloc 'utterances' in corpus\n");
+			cw->failed = 1;
+			return -1;
+		}
+		cw->utterances = utterances;
+	}
+	int name_length = strlen(name) + 1;
+	char* names = (char*)realloc(cw->names, cw->header.name_size + name_length);
+	if(names == NULL) {
+		printf("Failed to realloc 'names' in corpus\n");
+		cw->failed = 1;
+		return -1;
+	}
+	cw->names = names;
+	memcpy(&cw->names[cw->header.name_size], name, name_length);
+
+	cw->utterances[u].offset = cw->header.samples;
+	cw->utterances[u].length = length;
+	cw->utterances[u].name = cw->header.name_size;
+	cw->utterances[u].first = cw->header.segments;
+	cw->utterances[u].count = 0;
+	cw->header.name_size += name_length;
+	cw->header.samples += length;
+	cw->header.utterances++;
+	write_bytes(cw, samples, sizeof(int16_t) * length);
+	return cw->failed ? -1 : 0;
+}
+
+/**
+ * @brief Adds a segment to the last utterance
+ *
+ * @return 0, or -1 if there is no utterance or the table could not be grown
+ */
+int corpus_add_segment(struct Corpus_Writer* cw, int start, int end, int phoneme, int group, int voice)
+{
+	if(cw->header.utterances == 0) {
+		return -1;
+	}
+	uint32_t s = cw->header.segments;
+	if(s % 4096 == 0) {
+		struct Corpus_Segment* segments = (struct Corpus_Segment*)realloc(cw->segments, sizeof(struct Corpus_Segment) * (s + 4096));
+		if(segments == NULL) {
+			printf("Failed to realloc 'segments' in corpus\n");
+			cw->failed = 1;
+			return -1;
+		}
+		cw->segments = segments;
+	}
+	cw->segments[s].utterance = cw->header.utterances - 1;
+	cw->segments[s].start = start;
+	cw->segments[s].end = end;
+	cw->segments[s].phoneme = phoneme;
+	cw->segments[s].group = group;
+	cw->segments[s].voice = voice;
+	cw->utterances[cw->header.utterances - 1].count++;
+	cw->header.segments++;
+	return 0;
+}
+
+/**
+ * @brief Writes the tables and header and frees @param cw
+ *
+ * @return 0, or -1 if any part of the corpus could not be written
+ */
+int corpus_finish(struct Corpus_Writer* cw)
+{
+	uint64_t at = sizeof(struct Corpus_Header) + cw->header.samples * sizeof(int16_t);
+	at = align_file(cw, at);
+	cw->header.utterance_offset = at;
+	write_bytes(cw, cw->utterances, sizeof(struct Corpus_Utterance) * cw->header.utterances);
+	at += sizeof(struct Corpus_Utterance) * cw->header.utterances;
+	cw->header.segment_offset = at;
+	write_bytes(cw, cw->segments, sizeof(struct Corpus_Segment) * cw->header.segments);
+	at += sizeof(struct Corpus_Segment) * cw->header.segments;
+	cw->header.name_offset = at;
+	write_bytes(cw, cw->names, cw->header.name_size);
+	if(!cw->failed && fseek(cw->fp, 0, SEEK_SET) != 0) {
+		cw->failed = 1;
+	}
+	write_bytes(cw, &cw->header, sizeof(cw->header));
+	int failed = (fclose(cw->fp) != 0) || cw->failed;
+	free(cw->utterances);
+	free(cw->segments);
+	free(cw->names);
+	free(cw);
+	return failed ? -1 : 0;
+}
@@ -0,0 +1,110 @@
+#ifndef CORPUS_H
+#define CORPUS_H
+
+/**
+ * @file   corpus.h
+ * @brief  A dataset packed into one file, its audio and pre-parsed phoneme labels
+ *
+ * The audio of every utterance is stored back to back, followed by the utterance table, the segment
+ * table and the utterance names. A packed corpus is mapped read-only so a pass over the dataset is a
+ * sequential scan of one file, with no directory listing, .PHN parsing or label lookups.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#define CORPUS_MAGIC   "PHNCORPS"
+#define CORPUS_VERSION 1
+
+/**
+ * \struct Corpus_Header
+ * \brief The header at the start of a packed corpus
+ * @order 0x01020304 as written, so a corpus is only read on hosts of the same byte order
+ * @samples The amount of int16 samples of audio, which follows the header
+ * @utterance_offset,@segment_offset,@name_offset The byte offsets of the tables
+ * @name_size The size of the names, each ended by a zero
+ */
+struct Corpus_Header {
+	char magic[8];
+	uint32_t version;
+	uint32_t order;
+	uint32_t utterances;
+	uint32_t segments;
+	uint64_t samples;
+	uint64_t utterance_offset;
+	uint64_t segment_offset;
+	uint64_t name_offset;
+	uint64_t name_size;
+};
+
+/**
+ * \struct Corpus_Utterance
+ * \brief One .wav file of the dataset
+ * @offset The first sample of the utterance within the audio
+ * @length The amount of samples
+ * @name The offset of the file's name, without its extension, within the names
+ * @first,@count The utterance's segments
+ */
+struct Corpus_Utterance {
+	uint64_t offset;
+	uint32_t length;
+	uint32_t name;
+	uint32_t first;
+	uint32_t count;
+};
+
+/**
+ * \struct Corpus_Segment
+ * \brief One labelled phoneme of an utterance, as its .PHN line gave it
+ * @start,@end The samples of the phoneme within its utterance
+ * @phoneme The index of the phoneme within p_codes
+ * @group,@voice The phoneme's group and voicing, see \fn dtw_init()
+ */
+struct Corpus_Segment {
+	uint32_t utterance;
+	int32_t start;
+	int32_t end;
+	int16_t phoneme;
+	int8_t group;
+	int8_t voice;
+};
+
+/**
+ * \struct Corpus
+ * \brief A mapped corpus
+ */
+struct Corpus {
+	const struct Corpus_Header* header;
+	const int16_t* audio;
+	const struct Corpus_Utterance* utterances;
+	const struct Corpus_Segment* segments;
+	const char* names;
+	void* map;
+	size_t map_size;
+};
+
+/**
+ * \struct Corpus_Writer
+ * \brief A corpus being packed; the audio is written as it is added and the tables once it is finished
+ */
+struct Corpus_Writer {
+	FILE* fp;
+	struct Corpus_Header header;
+	struct Corpus_Utterance* utterances;
+	struct Corpus_Segment* segments;
+	char* names;
+	int failed;
+};
+
+struct Corpus* corpus_map(const char* path, int phonemes);
+void corpus_unmap(struct Corpus* corpus);
+const char* corpus_name(const struct Corpus* corpus, int u);
+
+struct Corpus_Writer* corpus_writer(const char* path);
+int corpus_add_utterance(struct Corpus_Writer* cw, const char* name, const int16_t* samples, int length);
+int corpus_add_segment(struct Corpus_Writer* cw, int start, int end, int phoneme, int group, int voice);
+int corpus_finish(struct Corpus_Writer* cw);
+
+#endif
@@ -0,0 +1,164 @@
+/**
+ * @file   wav.c
+ * @brief  Mapping WAV files for training, testing and the device
+ *
+ * Files without a RIFF header are read with the fixed 44 byte layout the earlier reader assumed,
+ * the sample size at byte 34 and the data size at byte 40.
+ */
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "wav.h"
+
+#define WAV_PCM        1
+#define WAV_FLOAT      3
+#define WAV_EXTENSIBLE 0xFFFE
+
+static uint16_t le16(const unsigned char* b)
+{
+	return (uint16_t)(b[0] | (b[1] << 8));
+}
+
+static uint32_t le32(const unsigned char* b)
+{
+	return (uint32_t)b[0] | ((uint32_t)b[1] << 8) | ((uint32_t)b[2] << 16) | ((uint32_t)b[3] << 24);
+}
+
+static int little_endian(void)
+{
+	const uint16_t one = 1;
+	return *(const unsigned char*)&one == 1;
+}
+
+/**
+ * @brief Decodes sample @param i of the first channel to 16 bits
+ */
+static int16_t decode_sample(const unsigned char* data, int i, int format, int bits, int channels)
+{
+	const unsigned char* b = &data[(size_t)i * channels * (bits / 8)];
+	if(format == WAV_FLOAT) {
+		uint32_t u = le32(b);
+		float f = 0;
+		memcpy(&f, &u, sizeof(f));
+		f = (f > 1) ? 1 : (f < -1) ? -1 : f;
+		return (int16_t)(f * 32767);
+	}
+	switch(bits) {
+	case 8:
+		return (int16_t)((b[0] - 128) * 256);
+	case 16:
+		return (int16_t)le16(b);
+	case 24:
+		return (int16_t)le16(&b[1]);
+	default:
+		return (int16_t)le16(&b[2]);
+	}
+}
+
+/**
+ * @brief Maps a WAV file
+ *
+ * @param path The file
+ *
+ * @return The samples of the file, released with \fn wav_unmap(), or NULL if it could not be read
+ */
+struct Wav_Map* wav_map(const char* path)
+{
+	int fd = open(path, O_RDONLY);
+	if(fd < 0) {
+		printf("Error opening wav '%s' file\n", path);
+		return NULL;
+	}
+	struct stat st;
+	if(fstat(fd, &st) != 0 || st.st_size < 44) {
+		printf("The wav '%s' is too short\n", path);
+		close(fd);
+		return NULL;
+	}
+	void* map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if(map == MAP_FAILED) {
+		printf("Failed to map wav '%s'\n", path);
+		return NULL;
+	}
+	const unsigned char* file = (const unsigned char*)map;
+	size_t size = st.st_size;
+	int format = WAV_PCM, channels = 1, rate = 16000, bits = 0;
+	size_t data = 0, data_size = 0;
+
+	if(memcmp(file, "RIFF", 4) == 0 && memcmp(&file[8], "WAVE", 4) == 0) {
+		size_t pos = 12;
+		while(pos + 8 <= size) {
+			size_t chunk = le32(&file[pos + 4]);
+			if(memcmp(&file[pos], "fmt ", 4) == 0 && chunk >= 16 && pos + 8 + 16 <= size) {
+				format = le16(&file[pos + 8]);
+				channels = le16(&file[pos + 10]);
+				rate = le32(&file[pos + 12]);
+				bits = le16(&file[pos + 22]);
+				if(format == WAV_EXTENSIBLE && chunk >= 26 && pos + 8 + 26 <= size) {
+					format = le16(&file[pos + 32]);
+				}
+			} else if(memcmp(&file[pos], "data", 4) == 0) {
+				data = pos + 8;
+				data_size = chunk;
+				break;
+			}
+			pos += 8 + chunk + (chunk & 1);
+		}
+	} else {
+		bits = le16(&file[34]);
+		data = 44;
+		data_size = le32(&file[40]);
+	}
+
+	if(data == 0 || channels <= 0 || !(format == WAV_PCM || format == WAV_FLOAT) ||
+	   !(bits == 8 || bits == 16 || bits == 24 || bits == 32) || (format == WAV_FLOAT && bits != 32)) {
+		printf("Unsupported wav '%s' :: format : %d || channels : %d || bits : %d\n", path, format, channels, bits);
+		munmap(map, size);
+		return NULL;
+	}
+	if(data_size > size - data) {
+		data_size = size - data;
+	}
+
+	struct Wav_Map* wav = (struct Wav_Map*)calloc(1, sizeof(struct Wav_Map));
+	if(wav == NULL) {
+		printf("Failed to malloc 'wav' for '%s'\n", path);
+		munmap(map, size);
+		return NULL;
+	}
+	wav->map = map;
+	wav->map_size = size;
+	wav->rate = rate;
+	wav->channels = channels;
+	wav->bits = bits;
+	wav->length = data_size / ((size_t)channels * (bits / 8));
+	if(format == WAV_PCM && bits == 16 && channels == 1 && data % 2 == 0 && little_endian()) {
+		wav->samples = (const int16_t*)&file[data];
+		posix_madvise(map, size, POSIX_MADV_SEQUENTIAL);
+		return wav;
+	}
+	wav->decoded = (int16_t*)malloc(sizeof(int16_t) * (wav->length + 1));
+	if(wav->decoded == NULL) {
+		printf("Failed to malloc the samples of '%s'\n", path);
+		wav_unmap(wav);
+		return NULL;
+	}
+	for(int i = 0; i < wav->length; i++) {
+		wav->decoded[i] = decode_sample(&file[data], i, format, bits, channels);
+	}
+	wav->samples = wav->decoded;
+	return wav;
+}
+
+void wav_unmap(struct Wav_Map* wav)
+{
+	if(wav == NULL) {
+		return;
+	}
+	munmap(wav->map, wav->map_size);
+	free(wav->decoded);
+	free(wav);
+}
@@ -0,0 +1,40 @@
+#ifndef WAV_H
+#define WAV_H
+
+/**
+ * @file   wav.h
+ * @brief  A WAV reader which maps the file instead of reading it
+ *
+ * The RIFF chunks are walked to find `fmt ` and `data`. Mono 16 bit PCM on a little-endian host is
+ * used in place, any other format is decoded to the first channel as 16 bit samples.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * \struct Wav_Map
+ * \brief A mapped WAV file
+ * @samples The samples of the first channel, read-only and valid until \fn wav_unmap()
+ * @length The amount of @samples
+ * @rate,@channels,@bits The format of the file
+ * @map,@map_size The mapping of the file
+ * @decoded The decoded samples when the file could not be used in place, NULL otherwise
+ */
+struct Wav_Map {
+	const int16_t* samples;
+	int length;
+	int rate;
+	int channels;
+	int bits;
+	void* map;
+	size_t map_size;
+	int16_t* decoded;
+};
+
+struct Wav_Map* wav_map(const char* path);
+void wav_unmap(struct Wav_Map* wav);
+
+#endif
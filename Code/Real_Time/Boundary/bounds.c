@@ -16,20 +16,10 @@ int f_is_positive(float num)
 	return -1;
 }
 
-float get_entropy(short* sequence, int inc)
+/* The entropy of a block, read from the entropy table without changing the block */
+float get_entropy(const short* sequence, int inc)
 {
-	float entropy = 0;
-	for(int m = 0; m < inc; m++) {
-		if(sequence[m] == 0) {
-			sequence[m] = 1;
-		}
-		sequence[m] = abs(sequence[m]);
-		if(sequence[m] == -32768) {
-			sequence[m] = 32767;
-		}
-		entropy += (float)(sequence[m]) * (log(sequence[m]) / log(2));
-	}
-	return entropy;
+	return s16_entropy(sequence, inc);
 }
 
 float* hanning_window(int num)
@@ -82,46 +72,84 @@ int cross_rate(short* signal, int signal_length)
 	return result;
 }
 
-int next_boundary(short* sequence, int length)
+void bound_detector_init(struct Bound_Detector* bd)
 {
-	if(length <= 32)
-		return -1;
-	int inc = 32;
-	float change = 0, last_zc = 0, ste_change = 0, last_ste = 0; 
-	float entropy = 0, prev_entropy = 0, entropy_change = 0;
-	int gap = 0;
-	for(int i = inc; i < length - inc; i+=inc) {
-		entropy = 0;
-		float zc = cross_rate(&sequence[i], inc);
-		change = abs(last_zc - zc);
-
-		float ste = short_time_energy(&sequence[i], inc, inc);
-		if(last_ste == 0) {
-			last_ste = 1;
-		}
-		ste_change = ((ste-last_ste) / fabs(last_ste)) * 100;
-		
-		entropy = get_entropy(&sequence[i], inc); 
-		if(prev_entropy == 0) {
-			entropy_change = fabs(entropy - prev_entropy);
-		} else {
-			entropy_change = ((entropy-prev_entropy) / fabs(prev_entropy)) * 100;
-		}
-		
-		if((i != 32) && (gap > 6) && 
-		   ((change >= 4 && ste_change <= -75 && entropy_change <= -80) ||
-		    (ste_change > 425 && entropy_change > 1050))) {
-			return i;
+	bd->inc = 32;
+	bd->next = 0;
+	bd->start = 0;
+	bd->gap = 0;
+	bd->last_zc = 0;
+	bd->last_ste = 0;
+	bd->prev_entropy = 0;
+}
+
+/* Consumes the block at bd->next, returning 1 if it is a boundary and starts a new segment */
+int bound_detector_push(struct Bound_Detector* bd, short* block)
+{
+	int inc = bd->inc;
+	int i = bd->next - bd->start;
+	bd->next += inc;
+	if(i == 0) {
+		return 0;
+	}
+	float zc = cross_rate(block, inc);
+	float change = abs(bd->last_zc - zc);
+
+	float ste = short_time_energy(block, inc, inc);
+	if(bd->last_ste == 0) {
+		bd->last_ste = 1;
+	}
+	float ste_change = ((ste-bd->last_ste) / fabs(bd->last_ste)) * 100;
+	
+	float entropy = get_entropy(block, inc), entropy_change = 0;
+	if(bd->prev_entropy == 0) {
+		entropy_change = fabs(entropy - bd->prev_entropy);
+	} else {
+		entropy_change = ((entropy-bd->prev_entropy) / fabs(bd->prev_entropy)) * 100;
+	}
+	
+	if((i != inc) && (bd->gap > 6) && 
+	   ((change >= 4 && ste_change <= -75 && entropy_change <= -80) ||
+	    (ste_change > 425 && entropy_change > 1050))) {
+		bd->start = bd->next - inc;
+		bd->gap = 0;
+		bd->last_zc = 0;
+		bd->last_ste = 0;
+		bd->prev_entropy = 0;
+		return 1;
+	}
+	bd->gap++;
+	bd->prev_entropy = entropy;
+	bd->last_zc = zc;
+	bd->last_ste = ste;
+	return 0;
+}
+
+/* Consumes the blocks which a sample follows up to the next boundary, returning it or -1 to wait for more samples */
+int bound_detector_next(struct Bound_Detector* bd, short* sequence, int length)
+{
+	while(bd->next + bd->inc < length) {
+		if(bound_detector_push(bd, &sequence[bd->next])) {
+			return bd->start;
 		}
-		gap++;
-		prev_entropy = entropy;
-		last_zc = zc;
-		last_ste = ste;
-		change = 0;
 	}
 	return -1;
 }
 
+/* Moves the search back after @shift samples are removed from the front of its signal */
+void bound_detector_shift(struct Bound_Detector* bd, int shift)
+{
+	bd->next -= shift;
+	bd->start -= shift;
+}
+
+int next_boundary(short* sequence, int length)
+{
+	struct Bound_Detector bd;
+	bound_detector_init(&bd);
+	return bound_detector_next(&bd, sequence, length);
+}
+
 int shift_and_reduce(short* sequence, int length, int shift)
 {
 	for(int i = 0; i < shift; i++) {
@@ -3,9 +3,31 @@
 
 #include "../Misc/includes.h"
 
+/**
+ * \struct Bound_Detector
+ * \brief The state of a boundary search which consumes each block of the signal once
+ * @inc The length of a block
+ * @next The first sample of the next block to be consumed
+ * @start The first sample of the current segment, the block found as its boundary
+ * @gap The amount of blocks measured since @start
+ * @last_zc,@last_ste,@prev_entropy The measures of the previous block, 0 at the start of a segment
+ */
+struct Bound_Detector {
+	int inc;
+	int next;
+	int start;
+	int gap;
+	float last_zc;
+	float last_ste;
+	float prev_entropy;
+};
+
+void bound_detector_init(struct Bound_Detector* bd);
+int bound_detector_push(struct Bound_Detector* bd, short* block);
+int bound_detector_next(struct Bound_Detector* bd, short* sequence, int length);
+void bound_detector_shift(struct Bound_Detector* bd, int shift);
 int shift_and_reduce(short* sequence, int length, int shift);
-int next_boundary(short* sequence, int length);
-float get_entropy(short* sequence, int inc);
+float get_entropy(const short* sequence, int inc);
 int next_boundary(short* sequence, int length);
 int is_positive(short num);
 int f_is_positive(float num);
@@ -38,10 +38,9 @@ double** init_dtw_matrix(int signal_length, int phone_length, int w)
 	return dtw_matrix;
 }
 
-long double dtw_frame_result(float* signal, int signal_length, struct Phoneme* phoneme, int p)
+long double dtw_frame_result(float* signal, int signal_length, const float* prototype)
 {
 	
-	phoneme->score = 0;
 	double temp_last_min = 0,  last_min = 0;
 	int phone_length = 0;
 	int w = 0;
@@ -59,16 +58,14 @@ long double dtw_frame_result(float* signal, int signal_length, struct Phoneme* p
 		return -1;
 	}
 	if(phone_length == 0) {
-		printf("Exiting, no sequence length found : %d : %d\n", phoneme->size[p], phone_length);
+		printf("Exiting, no sequence length found : %d\n", phone_length);
 		return -1;
 	}
 
 	double** dtw_matrix = init_dtw_matrix(signal_length, phone_length, w);
 	for(int i = 1; i < signal_length; i++) {
 		for(int j = max(1, i-w); j < min(phone_length, i+w); j++) {
-			for(int m = 0; m < trunc; m++) {
-				cost += fabsl(signal[(i * trunc) +  m] - phoneme->mfcc[p][(j * trunc) +  m]);
-			}
+			cost += frame_distance(&signal[i * trunc], &prototype[j * trunc], trunc, DIST_L1);
 			temp_last_min = fminl(dtw_matrix[i-1][j], dtw_matrix[i][j-1]);
 			last_min = fmin(temp_last_min, dtw_matrix[i-1][j-1]);
 			dtw_matrix[i][j] = cost + last_min;
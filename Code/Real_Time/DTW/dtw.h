@@ -2,6 +2,7 @@
 #define DTW_H
 
 #include "../Misc/includes.h"
+#include "../../Dynamic_Time_Warping/distance.h"
 
 struct Ph_index {
 	int i;
@@ -12,13 +13,8 @@ struct Ph_index {
 struct Phoneme {
 	struct Ph_index* index;
 	double score;
-	float** mfcc;
-	int* size;
-	int* count;
-	int size_count;
-	int use_count;
 } ph;
 
-long double dtw_frame_result(float* signal, int signal_length, struct Phoneme* phoneme, int p);
+long double dtw_frame_result(float* signal, int signal_length, const float* prototype);
 
 #endif
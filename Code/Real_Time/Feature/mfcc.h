@@ -2,9 +2,11 @@
 #define MFCC_H
 
 #include "../Misc/includes.h"
+#include "../../Feature_Extraction/fft.h"
+#include "../../Feature_Extraction/mel.h"
+#include "../../Feature_Extraction/mfcc_plan.h"
 
 int frame_amount(int signal_length);
 int mfcc_size(int signal_length);
-float* mfcc_quick(float* sequence, int width, int incr, int banks, int paa);
 
 #endif
@@ -9,35 +9,25 @@ int guesscomp(const void * a, const void * b)
 
 int knn_mfccs_size(float* test, int test_length, int k)
 {
-	int result = 0, n = 0, to_test = 0;
+	int result = 0, to_test = 0;
 	int mfcc_length = mfcc_size(test_length);
-	for(int i = 0; i < num_ph; i++) {
-		phones[i] = get_mfcc(phones[i], mfcc_length);
-		if(phones[i]->use_count == 0) {
-			continue;
-		}
-		n += phones[i]->use_count;
-	}
-	if(n == 0) {
+	const int* phoneme = NULL;
+	const struct Device_Model* model = model_acquire();
+	float* const* prototypes = model_prototypes(model, mfcc_length, &to_test, &phoneme);
+	if(to_test == 0) {
+		model_release();
 		printf("Zero prototypes with size %d, returning sil\n", mfcc_length);
 		return (num_ph - 1);
 	}
-	to_test = n;
 	
 	struct Guess* gs = (struct Guess*)malloc(sizeof(struct Guess) * to_test);
-	int l = 0;
 	
-	for(int i = 0; i < num_ph; i++) {
-		for(int j = 0; j < phones[i]->use_count; j++) {
-			gs[l].diff = dtw_frame_result(test, test_length, phones[i], j);
-			gs[l].guess = i;
-			gs[l].ref_indx = j;
-			gs[l].ref = phones[i];
-			l++;
-		       
-		}
-	       
+	for(int l = 0; l < to_test; l++) {
+		gs[l].diff = dtw_frame_result(test, test_length, prototypes[l]);
+		gs[l].guess = phoneme[l];
+		gs[l].ref_indx = l;
 	}
+	model_release();
 		
 	qsort(gs, to_test, sizeof(struct Guess), guesscomp);
 	int* modes = (int*)calloc(num_ph, sizeof(int));
@@ -3,7 +3,6 @@
 
 #include "../Misc/includes.h"
 
-struct Phoneme* get_mfcc(struct Phoneme* phone, int length);
 void dtw_init(void);
 
 extern int truncation;
@@ -0,0 +1,298 @@
+/**
+ * @file   model.c
+ * @brief  Loading, indexing and hot-reloading the device model, see @file model.h
+ *
+ * Readers count themselves in @readers before loading @current and out once done with it. The reload
+ * swaps @current first and then waits for @readers to empty, so a reader that counted itself after the
+ * wait began has loaded the new model and the old one is no longer read when it is freed.
+ */
+#include <signal.h>
+#include <stdatomic.h>
+
+#include "model.h"
+#include "../Misc/includes.h"
+
+/**
+ * \struct Model_File
+ * \brief A prototype file found in the device folder, @base/<phoneme>/<size>_<number>.phn
+ */
+struct Model_File {
+	int phoneme;
+	int size;
+	int number;
+};
+
+static _Atomic(struct Device_Model*) current = NULL;
+static atomic_int readers = 0;
+static char* model_base = NULL;
+static int model_phonemes = 0;
+
+static int filecomp(const void* a, const void* b)
+{
+	const struct Model_File* fa = (const struct Model_File*)a;
+	const struct Model_File* fb = (const struct Model_File*)b;
+	if(fa->size != fb->size) {
+		return (fa->size > fb->size) - (fa->size < fb->size);
+	}
+	if(fa->phoneme != fb->phoneme) {
+		return (fa->phoneme > fb->phoneme) - (fa->phoneme < fb->phoneme);
+	}
+	return (fa->number > fb->number) - (fa->number < fb->number);
+}
+
+/**
+ * @brief Adds the prototype files of phoneme @param i to @param files
+ * A phoneme without a folder has no prototypes.
+ *
+ * @return The amount of files, or -1 if @param files could not be grown
+ */
+static int find_files(const char* base, int i, struct Model_File** files, int count)
+{
+	char folder[512];
+	snprintf(folder, sizeof(folder), "%s/%s/", base, p_codes[i]);
+	DIR* dir = opendir(folder);
+	if(dir == NULL) {
+		printf("Couldn't open folder :: %s\n", folder);
+		return count;
+	}
+	struct dirent* next_file;
+	while((next_file = readdir(dir)) != NULL) {
+		char* end_ptr;
+		long size = strtol(next_file->d_name, &end_ptr, 10);
+		if(end_ptr == next_file->d_name || *end_ptr != '_' || size <= 0 || size > INT_MAX) {
+			continue;
+		}
+		char* number_ptr = end_ptr + 1;
+		long number = strtol(number_ptr, &end_ptr, 10);
+		if(end_ptr == number_ptr || strcmp(end_ptr, ".phn") != 0 || number < 0 || number > INT_MAX) {
+			continue;
+		}
+		struct Model_File* grown = (struct Model_File*)realloc(*files, sizeof(struct Model_File) * (count + 1));
+		if(grown == NULL) {
+			printf("Failed to realloc 'files' in the device model\n");
+			closedir(dir);
+			return -1;
+		}
+		*files = grown;
+		(*files)[count].phoneme = i;
+		(*files)[count].size = (int)size;
+		(*files)[count].number = (int)number;
+		count++;
+	}
+	closedir(dir);
+	return count;
+}
+
+/**
+ * @brief Reads the values of a prototype file into @param out, which holds @param length of them
+ * Every whitespace separated token is a value, as \fn export_phones() writes them. Values past
+ * @param length are ignored and reading stops at the first token which is not a number.
+ *
+ * @return The amount of values read, or -1 if the file could not be opened
+ */
+static long read_prototype(const char* filename, float* out, size_t length)
+{
+	FILE* fp = fopen(filename, "r");
+	if(fp == NULL) {
+		printf("Failed to open :: %s\n", filename);
+		return -1;
+	}
+	size_t n = 0;
+	while(n < length && fscanf(fp, "%f", &out[n]) == 1) {
+		n++;
+	}
+	fclose(fp);
+	return (long)n;
+}
+
+/**
+ * @brief Reads every prototype in the device folder
+ *
+ * @param base The device folder, holding a folder of <size>_<number>.phn files for each phoneme,
+ * each file @size values as \fn export_phones() writes them
+ * @param phonemes The amount of phonemes in p_codes
+ *
+ * A file which cannot be read or holds fewer than @size values is left out of the model.
+ *
+ * @return The model, released with \fn free_model(), or NULL if it could not be allocated
+ */
+struct Device_Model* load_model(const char* base, int phonemes)
+{
+	struct Model_File* files = NULL;
+	int count = 0;
+	for(int i = 0; i < phonemes; i++) {
+		count = find_files(base, i, &files, count);
+		if(count < 0) {
+			free(files);
+			return NULL;
+		}
+	}
+	qsort(files, count, sizeof(struct Model_File), filecomp);
+
+	struct Device_Model* model = (struct Device_Model*)calloc(1, sizeof(struct Device_Model));
+	if(model == NULL) {
+		printf("Failed to malloc 'model'\n");
+		free(files);
+		return NULL;
+	}
+	model->max_size = (count > 0) ? files[count - 1].size : 0;
+	model->bucket = (int*)calloc(model->max_size + 2, sizeof(int));
+	model->phoneme = (int*)malloc(sizeof(int) * (count + 1));
+	model->mfcc = (float**)malloc(sizeof(float*) * (count + 1));
+	size_t* offset = (size_t*)malloc(sizeof(size_t) * (count + 1));
+	if(model->bucket == NULL || model->phoneme == NULL || model->mfcc == NULL || offset == NULL) {
+		printf("Failed to malloc the index of a %d prototype device model\n", count);
+		free(offset);
+		free(files);
+		free_model(model);
+		return NULL;
+	}
+	for(int p = 0; p < count; p++) {
+		offset[p] = model->floats;
+		model->floats += ((size_t)files[p].size + MODEL_LINE - 1) / MODEL_LINE * MODEL_LINE;
+	}
+	void* data = NULL;
+	if(posix_memalign(&data, MODEL_LINE * sizeof(float), sizeof(float) * (model->floats + MODEL_LINE)) != 0) {
+		printf("Failed to malloc the %zu values of the device model\n", model->floats);
+		free(offset);
+		free(files);
+		free_model(model);
+		return NULL;
+	}
+	model->data = (float*)data;
+	memset(model->data, 0, sizeof(float) * (model->floats + MODEL_LINE));
+
+	// The files are in size order, so the prototypes kept are as well
+	char filename[1024];
+	for(int p = 0; p < count; p++) {
+		float* mfcc = &model->data[offset[p]];
+		snprintf(filename, sizeof(filename), "%s/%s/%d_%d.phn", base, p_codes[files[p].phoneme], files[p].size, files[p].number);
+		long read = read_prototype(filename, mfcc, (size_t)files[p].size);
+		if(read != files[p].size) {
+			if(read >= 0) {
+				printf("Skipping :: %s :: %ld of %d values\n", filename, read, files[p].size);
+			}
+			continue;
+		}
+		model->mfcc[model->count] = mfcc;
+		model->phoneme[model->count] = files[p].phoneme;
+		model->bucket[files[p].size + 1]++;
+		model->count++;
+	}
+	for(int s = 0; s <= model->max_size; s++) {
+		model->bucket[s + 1] += model->bucket[s];
+	}
+	free(offset);
+	free(files);
+	return model;
+}
+
+void free_model(struct Device_Model* model)
+{
+	if(model == NULL) {
+		return;
+	}
+	free(model->bucket);
+	free(model->phoneme);
+	free(model->mfcc);
+	free(model->data);
+	free(model);
+}
+
+/**
+ * @brief The prototypes of MFCC size @param size
+ *
+ * @param count Set to the amount of prototypes
+ * @param phoneme Set to the phoneme of each prototype
+ *
+ * @return The prototypes, @count of them
+ */
+float* const* model_prototypes(const struct Device_Model* model, int size, int* count, const int** phoneme)
+{
+	if(model == NULL || size < 0 || size > model->max_size) {
+		*count = 0;
+		*phoneme = NULL;
+		return NULL;
+	}
+	*count = model->bucket[size + 1] - model->bucket[size];
+	*phoneme = &model->phoneme[model->bucket[size]];
+	return &model->mfcc[model->bucket[size]];
+}
+
+/**
+ * @brief Reads the device model in the signal watcher thread each time a SIGHUP arrives
+ */
+static void* model_watcher(void* argp)
+{
+	sigset_t* set = (sigset_t*)argp;
+	int sig = 0;
+	while(sigwait(set, &sig) == 0) {
+		model_reload();
+	}
+	return NULL;
+}
+
+/**
+ * @brief Loads the device model and starts the thread reloading it on SIGHUP
+ * Must be called before any other thread is created, so SIGHUP is blocked in all of them.
+ *
+ * @return 0, or -1 if the model could not be allocated
+ */
+int model_init(const char* base, int phonemes)
+{
+	static sigset_t set;
+	model_base = strdup(base);
+	model_phonemes = phonemes;
+	struct Device_Model* model = load_model(model_base, model_phonemes);
+	if(model == NULL) {
+		return -1;
+	}
+	atomic_store(&current, model);
+	printf(":: Loaded device model, %d prototypes\n", model->count);
+
+	sigemptyset(&set);
+	sigaddset(&set, SIGHUP);
+	pthread_t tid;
+	if(pthread_sigmask(SIG_BLOCK, &set, NULL) != 0 || pthread_create(&tid, NULL, model_watcher, &set) != 0) {
+		printf("Failed to start the device model watcher, SIGHUP will not reload it\n");
+		return 0;
+	}
+	pthread_detach(tid);
+	return 0;
+}
+
+/**
+ * @brief The current model, which stays valid until \fn model_release()
+ */
+const struct Device_Model* model_acquire(void)
+{
+	atomic_fetch_add(&readers, 1);
+	return atomic_load(&current);
+}
+
+void model_release(void)
+{
+	atomic_fetch_sub(&readers, 1);
+}
+
+/**
+ * @brief Reads the device folder again and swaps the new model in, freeing the old one once unread
+ * Only called from the watcher thread, so reloads do not overlap.
+ *
+ * @return 0, or -1 if the new model could not be read and the old one was kept
+ */
+int model_reload(void)
+{
+	struct Device_Model* model = load_model(model_base, model_phonemes);
+	if(model == NULL) {
+		printf(":: Failed to reload the device model, keeping the current one\n");
+		return -1;
+	}
+	struct Device_Model* old = atomic_exchange(&current, model);
+	while(atomic_load(&readers) > 0) {
+		usleep(1000);
+	}
+	free_model(old);
+	printf(":: Reloaded device model, %d prototypes\n", model->count);
+	return 0;
+}
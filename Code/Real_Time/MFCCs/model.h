@@ -0,0 +1,50 @@
+#ifndef MODEL_H
+#define MODEL_H
+
+/**
+ * @file   model.h
+ * @brief  The device prototypes held in memory and indexed by MFCC size, replaced whole on SIGHUP
+ *
+ * The model is read from ../device once, then each classification takes the prototypes of the test's
+ * size with one lookup and no file I/O. The prototypes of each size are packed together in phoneme then
+ * file order, each starting on a cache line, so a KNN sweep reads memory in order.
+ *
+ * A SIGHUP makes a watcher thread read the device folder into a new model and swap it in atomically.
+ * Classifications in flight keep the model they acquired, the old model is freed once they release it.
+ * If the new model cannot be read the old one is kept.
+ */
+
+#include <stddef.h>
+
+#define MODEL_LINE 16 /* The floats in a cache line, each prototype starts on one */
+
+/**
+ * \struct Device_Model
+ * \brief The prototypes of every phoneme, ordered by size then phoneme then file number
+ * @max_size The largest size held
+ * @bucket The prototypes of size s are @mfcc[@bucket[s]] to @mfcc[@bucket[s + 1]], @max_size + 2 offsets
+ * @phoneme The phoneme of each prototype
+ * @mfcc Each prototype, pointing into @data
+ * @data The prototypes' values, @floats of them
+ * @count The amount of prototypes
+ */
+struct Device_Model {
+	int max_size;
+	int* bucket;
+	int* phoneme;
+	float** mfcc;
+	float* data;
+	size_t floats;
+	int count;
+};
+
+struct Device_Model* load_model(const char* base, int phonemes);
+void free_model(struct Device_Model* model);
+float* const* model_prototypes(const struct Device_Model* model, int size, int* count, const int** phoneme);
+
+int model_init(const char* base, int phonemes);
+const struct Device_Model* model_acquire(void);
+void model_release(void);
+int model_reload(void);
+
+#endif
@@ -12,7 +12,12 @@
 #include <dirent.h>
 
 #include "../MFCCs/mfccs.h"
+#include "../MFCCs/model.h"
 #include "../Misc/mfcc_vars.h"
+#include "../../Misc/wav.h"
+#include "../../Feature_Extraction/resample.h"
+#include "../../Feature_Extraction/entropy.h"
+#include "../Misc/ring.h"
 #include "../Test/test.h"
 #include "../DTW/dtw.h"
 #include "../Feature/mfcc.h"
@@ -9,6 +9,7 @@ float glbl_dtw_window = 0.1;
 int glbl_interval_div = 2;
 int glbl_nfft = 512;
 float glbl_test_trunc = 0.875f;
+int glbl_resample = RESAMPLE_INSERT;
 
 
 
@@ -12,5 +12,6 @@ extern float glbl_dtw_window;
 extern int glbl_interval_div;
 extern int glbl_nfft;
 extern float glbl_test_trunc;
+extern int glbl_resample;
 
 #endif
@@ -0,0 +1,109 @@
+/**
+ * @file   ring.c
+ * @brief  The lock-free sample ring, see @file ring.h
+ *
+ * Only the producer moves @head and only the consumer moves @tail, so the samples between them are
+ * never written while the consumer reads them. A block which does not fit is dropped by the producer.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ring.h"
+
+/**
+ * @brief Builds a ring
+ *
+ * @param capacity The least amount of samples held, rounded up to a power of two
+ *
+ * @return The ring, or NULL if it could not be allocated
+ */
+struct Sample_Ring* sample_ring(size_t capacity)
+{
+	size_t size = 1;
+	while(size < capacity) {
+		size <<= 1;
+	}
+	struct Sample_Ring* ring = (struct Sample_Ring*)aligned_alloc(RING_LINE, (sizeof(struct Sample_Ring) + RING_LINE - 1) / RING_LINE * RING_LINE);
+	if(ring == NULL) {
+		printf("Failed to malloc 'ring'\n");
+		return NULL;
+	}
+	ring->samples = (int16_t*)calloc(size, sizeof(int16_t));
+	if(ring->samples == NULL) {
+		printf("Failed to malloc the %zu samples of the ring\n", size);
+		free(ring);
+		return NULL;
+	}
+	ring->capacity = size;
+	ring->mask = size - 1;
+	atomic_init(&ring->head, 0);
+	atomic_init(&ring->tail, 0);
+	atomic_init(&ring->dropped, 0);
+	return ring;
+}
+
+void free_sample_ring(struct Sample_Ring* ring)
+{
+	if(ring == NULL) {
+		return;
+	}
+	free(ring->samples);
+	free(ring);
+}
+
+/**
+ * @brief Pushes a block of samples, called only by the producer
+ * A block which does not fit in the free space is dropped whole and counted, the ring is left as it was.
+ *
+ * @return The amount of samples dropped, 0 or @param length
+ */
+size_t ring_push(struct Sample_Ring* ring, const int16_t* in, size_t length)
+{
+	size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+	size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+	if(head - tail + length > ring->capacity) {
+		atomic_fetch_add_explicit(&ring->dropped, length, memory_order_relaxed);
+		return length;
+	}
+	size_t at = head & ring->mask;
+	size_t first = (length < ring->capacity - at) ? length : ring->capacity - at;
+	memcpy(&ring->samples[at], in, sizeof(int16_t) * first);
+	memcpy(ring->samples, &in[first], sizeof(int16_t) * (length - first));
+	atomic_store_explicit(&ring->head, head + length, memory_order_release);
+	return 0;
+}
+
+/**
+ * @brief The oldest samples which are contiguous in the ring, called only by the consumer
+ *
+ * A span shorter than what was pushed ends at the end of the ring, the rest is the next span.
+ */
+struct Ring_Span ring_peek(struct Sample_Ring* ring)
+{
+	size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+	size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+	size_t at = tail & ring->mask;
+	size_t length = head - tail;
+	struct Ring_Span span;
+	span.samples = &ring->samples[at];
+	span.length = (length < ring->capacity - at) ? length : ring->capacity - at;
+	span.start = tail;
+	return span;
+}
+
+/**
+ * @brief Releases the first @param length samples of a span to the producer, called only by the consumer
+ */
+void ring_consume(struct Sample_Ring* ring, struct Ring_Span span, size_t length)
+{
+	atomic_store_explicit(&ring->tail, span.start + length, memory_order_release);
+}
+
+/**
+ * @brief The amount of samples dropped since the ring was built
+ */
+size_t ring_dropped(struct Sample_Ring* ring)
+{
+	return atomic_load_explicit(&ring->dropped, memory_order_relaxed);
+}
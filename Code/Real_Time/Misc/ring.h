@@ -0,0 +1,54 @@
+#ifndef RING_H
+#define RING_H
+
+/**
+ * @file   ring.h
+ * @brief  A lock-free ring of samples from the record thread to the process thread
+ *
+ * One thread pushes blocks and one thread reads them. The positions only grow and are taken modulo
+ * the power of two capacity, each on its own cache line so the threads do not share one. When a push
+ * finds the ring full the new block is dropped and counted, rather than the program stopping.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+
+#define RING_LINE 64
+
+/**
+ * \struct Sample_Ring
+ * \brief A single producer, single consumer ring of int16 samples
+ * @head The position after the last sample pushed, only moved by the producer
+ * @tail The position of the oldest sample kept, only moved by the consumer
+ * @samples The ring, @capacity samples
+ * @mask @capacity - 1
+ * @dropped The amount of samples pushed but dropped as the ring was full
+ */
+struct Sample_Ring {
+	_Alignas(RING_LINE) atomic_size_t head;
+	_Alignas(RING_LINE) atomic_size_t tail;
+	_Alignas(RING_LINE) int16_t* samples;
+	size_t capacity;
+	size_t mask;
+	atomic_size_t dropped;
+};
+
+/**
+ * \struct Ring_Span
+ * \brief Samples which can be read in place, from position @start
+ */
+struct Ring_Span {
+	const int16_t* samples;
+	size_t length;
+	size_t start;
+};
+
+struct Sample_Ring* sample_ring(size_t capacity);
+void free_sample_ring(struct Sample_Ring* ring);
+size_t ring_push(struct Sample_Ring* ring, const int16_t* in, size_t length);
+struct Ring_Span ring_peek(struct Sample_Ring* ring);
+void ring_consume(struct Sample_Ring* ring, struct Ring_Span span, size_t length);
+size_t ring_dropped(struct Sample_Ring* ring);
+
+#endif
@@ -11,37 +11,28 @@ char* p_codes[] = {      "b", "d", "k", "p", "t", "g",
 			 "sil",                                                                              // Other [38] - OTHER
 	           "\0"};
 
-double cubic_interpolate(short y0, short y1, short y2, short y3, double mu)
+/**
+ * @brief Resizes @param shorter from @param s to @param l samples with the \var glbl_resample method, freeing it
+ */
+short* resize(short* shorter, size_t s, size_t l)
 {
-	short a0 = 0, a1 = 0, a2 = 0, a3 = 0, mu2  = 0;
-
-	mu2 = mu*mu;
-	a0 = y3 - y2 - y0 + y1;
-	a1 = y0 - y1 - a0;
-	a2 = y2 - y0;
-	a3 = y1;
-	return(a0*mu*mu2+a1*mu2+a2*mu+a3);
+	short* new_sequence = (short*)malloc(sizeof(short) * l);
+	resample_s16(shorter, s, new_sequence, l, glbl_resample, s / 2);
+	free(shorter);
+	return new_sequence;
 }
 
-short* resize(short* shorter, size_t s, size_t l)
+/**
+ * @brief The device's MFCC extractor, shared by \fn test_phoneme_utterance() and the stream in rt.c
+ */
+struct Mfcc_Plan* test_mfcc_plan(void)
 {
-	short* new_sequence = calloc(l, sizeof(short));
-	for(unsigned int i = 0; i < s; i++) {
-		new_sequence[i] = shorter[i];
+	static struct Mfcc_Plan* plan = NULL;
+	if(plan == NULL) {
+		int paa = (glbl_paa_op == 0) ? glbl_paa : 0;
+		plan = mfcc_plan(glbl_window_width, glbl_interval_div, glbl_banks, glbl_nfft, floor(glbl_banks * glbl_test_trunc), paa, INT_MAX, 1);
 	}
-	free(shorter);
-	size_t i = floor(s / 2);
-	while(s < l) {
-		for(size_t j = s-1; j >= i ; j--) {
-			new_sequence[ j + 1 ] = new_sequence[ j ];
-		}
-	        		
-	        new_sequence[i] = cubic_interpolate((short)new_sequence[i - 2], (short)new_sequence[i - 1], (short)new_sequence[i + 1], (short)new_sequence[i + 2], 0.5);
-		s++;
-		if(i + 2 >= s - 5){  i = 5; }
-		i+=2;	
-	}
-	return new_sequence;	
+	return plan;
 }
 
 int test_phoneme_utterance(short* h, int signal_length)
@@ -59,11 +50,21 @@ int test_phoneme_utterance(short* h, int signal_length)
 		signal_length = (glbl_window_width * glbl_paa);
 	}
 
-	float* signal = (float*)malloc(sizeof(float) * signal_length);
+	struct Mfcc_Plan* plan = test_mfcc_plan();
+	float* samples = (float*)malloc(sizeof(float) * signal_length);
 	for(int i = 0; i < signal_length; i++) {
-		signal[i] = h[i];
+		samples[i] = h[i];
 	}
-	signal = mfcc_quick(signal, signal_length, glbl_window_width, glbl_banks, glbl_paa_op);
+	free(h);
+	float* signal = NULL;
+	if(plan != NULL) {
+		signal = (float*)malloc(sizeof(float) * mfcc_frames(plan, signal_length) * plan->trunc);
+		if(signal != NULL && mfcc_execute(plan, samples, signal_length, signal) < 0) {
+			free(signal);
+			signal = NULL;
+		}
+	}
+	free(samples);
 
 	if(signal == NULL) {
 		for(int i = 1; i < num_ph; i++) {
@@ -76,9 +77,57 @@ int test_phoneme_utterance(short* h, int signal_length)
 		for(int i = 1; i < num_ph; i++) {
 			phones[i]->score = DBL_MAX;
 		}
+		free(signal);
 		return -1;
 	}
-	free(h);
+	int knn = knn_mfccs_size(signal, signal_length, 7);
+	free(signal);
+	return knn;
+}
+
+/**
+ * @brief Classifies a segment from the frames the stream has already produced for it
+ *
+ * @param stream The stream the segment's samples were pushed to
+ * @param start The first sample of the segment since the stream began
+ * @param signal_length The length of the segment
+ *
+ * The segment is given the same amount of frames as \fn test_phoneme_utterance() would, taken from the first
+ * frame at or after @param start and followed by the device's silent frame.
+ *
+ * @return The phoneme, or -1 if the frames are no longer in the stream's history or the plan applies PAA,
+ *         whose frames the stream cannot produce ahead of the segment
+ */
+int test_phoneme_stream(const struct Mfcc_Stream* stream, long start, int signal_length)
+{
+	struct Mfcc_Plan* plan = test_mfcc_plan();
+	if(plan == NULL || plan->paa != 0) {
+		return -1;
+	}
+	while(signal_length % glbl_window_width != 0) {
+		signal_length++;
+	}
+	if((signal_length / glbl_paa) < glbl_window_width) {
+		signal_length = (glbl_window_width * glbl_paa);
+	}
+	int frames = mfcc_frames(plan, signal_length);
+	if(frames <= 0 || mfcc_size(signal_length) <= 0) {
+		return -1;
+	}
+	float* signal = (float*)malloc(sizeof(float) * frames * plan->trunc);
+	if(signal == NULL) {
+		printf("Failed to malloc 'signal' in test\n");
+		return -1;
+	}
+	long first = mfcc_stream_frame_at(stream, start);
+	for(int i = 0; i < frames; i++) {
+		const float* frame = (i == frames - 1) ? stream->silence : mfcc_stream_frame(stream, first + i);
+		if(frame == NULL) {
+			free(signal);
+			return -1;
+		}
+		memcpy(&signal[i * plan->trunc], frame, sizeof(float) * plan->trunc);
+	}
 	int knn = knn_mfccs_size(signal, signal_length, 7);
 	free(signal);
 	return knn;
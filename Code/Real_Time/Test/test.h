@@ -2,9 +2,12 @@
 #define TEST_H
 
 #include "../Misc/includes.h"
+#include "../../Feature_Extraction/mfcc_stream.h"
 
 extern struct Phoneme** phones;
 
 int test_phoneme_utterance(short* h, int signal_length);
+int test_phoneme_stream(const struct Mfcc_Stream* stream, long start, int signal_length);
+struct Mfcc_Plan* test_mfcc_plan(void);
 
 #endif
@@ -0,0 +1,128 @@
+/**
+ * @file   model_test.c
+ * @brief  Checks which prototype files the device model keeps and the values it reads from them
+ *
+ * A device folder is written to a temporary directory in the layout \fn export_phones() produces, with
+ * some files damaged, and then loaded. Exits with 0 when every check passes.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "../MFCCs/model.h"
+
+char* p_codes[] = {"b", "d", "k"}; /* The phonemes of the test folder, "k" has no folder */
+
+int failures = 0;
+
+#define CHECK(cond, ...) do { if(!(cond)) { printf("FAIL %s:%d :: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); failures++; } } while(0)
+
+/**
+ * \struct Test_File
+ * \brief A prototype file written to the test folder
+ */
+struct Test_File {
+	const char* name;
+	const char* text;
+};
+
+static const struct Test_File test_files[] = {
+	{"b/3_0.phn",  "1.000000 2.000000 3.000000 \n"},         /* As exported, every token is a value */
+	{"b/3_1.phn",  "1.000000 2.000000 \n"},                  /* Short, left out */
+	{"d/3_0.phn",  "4.000000 5.000000 6.000000 7.000000 \n"}, /* Long, the extra value is ignored */
+	{"d/2_0.phn",  "x 1.000000 2.000000 \n"},                /* Not a number, left out */
+	{"d/16_0.phn", "0 1 2 3 4 5 6 7\n8 9 10 11 12 13 14 15\n"},
+	{"d/notes.txt", "not a prototype\n"},
+};
+
+#define TEST_FILES (int)(sizeof(test_files) / sizeof(test_files[0]))
+
+static char base[64];
+
+static void write_folder(void)
+{
+	char path[256];
+	for(int i = 0; i < 2; i++) {
+		snprintf(path, sizeof(path), "%s/%s", base, p_codes[i]);
+		mkdir(path, 0700);
+	}
+	for(int i = 0; i < TEST_FILES; i++) {
+		snprintf(path, sizeof(path), "%s/%s", base, test_files[i].name);
+		FILE* fp = fopen(path, "w");
+		if(fp == NULL) {
+			printf("Failed to write :: %s\n", path);
+			exit(1);
+		}
+		fputs(test_files[i].text, fp);
+		fclose(fp);
+	}
+}
+
+static void remove_folder(void)
+{
+	char path[256];
+	for(int i = 0; i < TEST_FILES; i++) {
+		snprintf(path, sizeof(path), "%s/%s", base, test_files[i].name);
+		unlink(path);
+	}
+	for(int i = 0; i < 2; i++) {
+		snprintf(path, sizeof(path), "%s/%s", base, p_codes[i]);
+		rmdir(path);
+	}
+	rmdir(base);
+}
+
+int main(void)
+{
+	snprintf(base, sizeof(base), "/tmp/model_test_%d", (int)getpid());
+	if(mkdir(base, 0700) != 0) {
+		printf("Failed to make the test folder\n");
+		return 1;
+	}
+	write_folder();
+	struct Device_Model* model = load_model(base, 3);
+	remove_folder();
+	CHECK(model != NULL, "the model was not loaded");
+	if(model == NULL) {
+		return 1;
+	}
+	CHECK(model->count == 3, "kept %d prototypes, expected 3", model->count);
+
+	int count = 0;
+	const int* phoneme = NULL;
+	float* const* mfcc = model_prototypes(model, 3, &count, &phoneme);
+	CHECK(count == 2, "%d prototypes of size 3, expected 2", count);
+	if(count == 2) {
+		CHECK(phoneme[0] == 0 && phoneme[1] == 1, "size 3 phonemes %d %d, expected 0 1", phoneme[0], phoneme[1]);
+		CHECK(mfcc[0][0] == 1 && mfcc[0][1] == 2 && mfcc[0][2] == 3, "b/3_0 read as %f %f %f", mfcc[0][0], mfcc[0][1], mfcc[0][2]);
+		CHECK(mfcc[1][0] == 4 && mfcc[1][1] == 5 && mfcc[1][2] == 6, "d/3_0 read as %f %f %f", mfcc[1][0], mfcc[1][1], mfcc[1][2]);
+	}
+
+	model_prototypes(model, 2, &count, &phoneme);
+	CHECK(count == 0, "%d prototypes of size 2, expected 0", count);
+
+	mfcc = model_prototypes(model, 16, &count, &phoneme);
+	CHECK(count == 1, "%d prototypes of size 16, expected 1", count);
+	if(count == 1) {
+		for(int i = 0; i < 16; i++) {
+			CHECK(mfcc[0][i] == i, "d/16_0 value %d read as %f", i, mfcc[0][i]);
+		}
+	}
+	for(int s = 0; s <= model->max_size; s++) {
+		mfcc = model_prototypes(model, s, &count, &phoneme);
+		for(int p = 0; p < count; p++) {
+			CHECK((uintptr_t)mfcc[p] % (MODEL_LINE * sizeof(float)) == 0, "prototype %d of size %d is not on a cache line", p, s);
+		}
+	}
+	free_model(model);
+
+	if(failures > 0) {
+		printf("%d model checks failed\n", failures);
+		return 1;
+	}
+	printf("Model checks passed\n");
+	return 0;
+}
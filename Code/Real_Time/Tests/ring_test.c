@@ -0,0 +1,135 @@
+/**
+ * @file   ring_test.c
+ * @brief  Checks what the consumer of a sample ring sees when the producer overruns it
+ *
+ * The samples pushed count up from 0, so the consumer can tell which were dropped and whether any it
+ * read were torn. Exits with 0 when every check passes.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "../Misc/ring.h"
+
+#define CAPACITY 1024
+#define BLOCK 128 /* Divides 65536, so a dropped block is still one in int16 counting */
+#define STRESS_SAMPLES 4000000
+
+int failures = 0;
+
+#define CHECK(cond, ...) do { if(!(cond)) { printf("FAIL %s:%d :: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); failures++; } } while(0)
+
+/**
+ * @brief Fills the ring past its capacity with nothing consuming, then drains it
+ * The blocks which fit are kept in order and the rest are dropped whole.
+ */
+void test_overrun(void)
+{
+	struct Sample_Ring* ring = sample_ring(CAPACITY);
+	int16_t block[BLOCK];
+	int16_t next = 0;
+	size_t dropped = 0;
+	int blocks = 0;
+	for(int i = 0; i < 2 * CAPACITY / BLOCK; i++) {
+		for(int j = 0; j < BLOCK; j++) {
+			block[j] = next++;
+		}
+		size_t d = ring_push(ring, block, BLOCK);
+		CHECK(d == 0 || d == BLOCK, "push dropped part of a block, %zu", d);
+		dropped += d;
+		blocks += (d == 0);
+	}
+	CHECK(blocks == CAPACITY / BLOCK, "kept %d blocks, expected %d", blocks, CAPACITY / BLOCK);
+	CHECK(ring_dropped(ring) == dropped, "ring counted %zu dropped, pushes returned %zu", ring_dropped(ring), dropped);
+	CHECK(dropped == (size_t)(2 * CAPACITY / BLOCK - blocks) * BLOCK, "dropped %zu", dropped);
+
+	int16_t expect = 0;
+	size_t seen = 0;
+	struct Ring_Span span;
+	while((span = ring_peek(ring)).length > 0) {
+		for(size_t i = 0; i < span.length; i++) {
+			CHECK(span.samples[i] == expect, "read %d, expected %d", span.samples[i], expect);
+			expect++;
+		}
+		seen += span.length;
+		ring_consume(ring, span, span.length);
+	}
+	CHECK(seen == (size_t)blocks * BLOCK, "consumer saw %zu samples, expected %d", seen, blocks * BLOCK);
+
+	for(int j = 0; j < BLOCK; j++) {
+		block[j] = j;
+	}
+	CHECK(ring_push(ring, block, BLOCK) == 0, "push dropped a block into a drained ring");
+	CHECK(ring_push(ring, block, CAPACITY + 1) == CAPACITY + 1, "a block larger than the ring was kept");
+	free_sample_ring(ring);
+}
+
+struct Stress {
+	struct Sample_Ring* ring;
+	size_t pushed;
+	size_t dropped;
+};
+
+void* producer(void* argp)
+{
+	struct Stress* st = (struct Stress*)argp;
+	int16_t block[BLOCK];
+	unsigned int n = 0;
+	while(st->pushed < STRESS_SAMPLES) {
+		for(int j = 0; j < BLOCK; j++) {
+			block[j] = (int16_t)(n + j);
+		}
+		st->dropped += ring_push(st->ring, block, BLOCK);
+		st->pushed += BLOCK;
+		n += BLOCK;
+	}
+	return NULL;
+}
+
+/**
+ * @brief One producer and one consumer at once, with the consumer slow enough that the ring overruns
+ * Every sample read must be the one after the sample before it, unless whole blocks were dropped
+ * between them, and every sample pushed must be either read or dropped.
+ */
+void test_stress(void)
+{
+	struct Stress st = { sample_ring(CAPACITY), 0, 0 };
+	pthread_t tid;
+	pthread_create(&tid, NULL, producer, &st);
+	size_t seen = 0;
+	int16_t last = -1;
+	int first = 1;
+	int done = 0;
+	while(!done) {
+		done = (seen + ring_dropped(st.ring) == STRESS_SAMPLES);
+		struct Ring_Span span = ring_peek(st.ring);
+		for(size_t i = 0; i < span.length; i++) {
+			int16_t x = span.samples[i];
+			if(!first && x != (int16_t)(last + 1)) {
+				CHECK((uint16_t)(x - last - 1) % BLOCK == 0 && (uint16_t)x % BLOCK == 0, "read %d after %d", x, last);
+			}
+			first = 0;
+			last = x;
+		}
+		seen += span.length;
+		ring_consume(st.ring, span, span.length);
+		for(volatile int spin = 0; spin < 2000; spin++) {}
+	}
+	pthread_join(tid, NULL);
+	CHECK(st.dropped > 0, "the ring never overran");
+	CHECK(st.dropped == ring_dropped(st.ring), "ring counted %zu dropped, pushes returned %zu", ring_dropped(st.ring), st.dropped);
+	CHECK(seen + st.dropped == st.pushed, "read %zu and dropped %zu of %zu", seen, st.dropped, st.pushed);
+	free_sample_ring(st.ring);
+}
+
+int main(void)
+{
+	test_overrun();
+	test_stress();
+	if(failures > 0) {
+		printf("%d ring checks failed\n", failures);
+		return 1;
+	}
+	printf("Ring checks passed\n");
+	return 0;
+}
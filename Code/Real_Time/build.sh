@@ -1,4 +1,4 @@
 #!/bin/bash
 
-    eval "gcc -g -Wall -Werror -pedantic -std=c11 ./Misc/*.c ./DTW/*.c ./MFCCs/*.c ./KNN/*.c ./Boundary/*.c ./Feature/*.c ./Test/*.c ./*.c -D_XOPEN_SOURCE=600 -pthread -onan -o rte.exe -lm;"
+    eval "gcc -g -Wall -Werror -pedantic -std=c11 ./Misc/*.c ./DTW/*.c ./MFCCs/*.c ./KNN/*.c ./Boundary/*.c ./Feature/*.c ./Test/*.c ./*.c ../Dynamic_Time_Warping/distance.c ../Feature_Extraction/fft.c ../Feature_Extraction/mel.c ../Feature_Extraction/mfcc_plan.c ../Feature_Extraction/mfcc_stream.c ../Feature_Extraction/resample.c ../Feature_Extraction/entropy.c ../Misc/wav.c -D_XOPEN_SOURCE=600 -pthread -onan -o rte.exe -lm;"
 
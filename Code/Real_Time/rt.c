@@ -1,28 +1,41 @@
 #include "rt.h"
 
-pthread_mutex_t lock;
-pthread_cond_t cond;
+#define PR_CAPACITY 64000   /* The longest unsegmented audio kept, 4 seconds */
+#define RING_CAPACITY 65536 /* The samples the record thread can be ahead of the process thread */
+#define RECORD_BLOCK 512    /* The samples pushed to the ring at once, 32ms */
 
-short in_array[64000] = {0};
-short pr_array[64000] = {0};
+struct Sample_Ring* ring = NULL; /* The samples recorded but not yet processed */
+
+short pr_array[PR_CAPACITY] = {0};
 
-int in_size = 0;
 int pr_size = 0;
+long pr_dropped = 0; /* The samples dropped from 'pr_array' as no boundary was found in them */
+
+struct Mfcc_Stream* stream = NULL; /* The MFCC of everything moved to 'pr_array', produced as it arrives, NULL with PAA */
+struct Bound_Detector detector; /* The boundary search over 'pr_array', which consumes each block once */
 
 void* process_thread(void* argp);
 void* record_thread(void* argp);
-void update_arrays(int in, int pr);
+void process(void);
 void boundary(void);
 
 int STOP = 0;
 
-short* read_wav(FILE* fp);
 
 int main(void)
 {
+	distance_init();
 	dtw_init();
-	pthread_mutex_init(&lock, NULL);
-	pthread_cond_init(&cond, NULL);
+	bound_detector_init(&detector);
+	// PAA'd frames depend on where the segment starts, so with PAA each segment is extracted on its own
+	struct Mfcc_Plan* plan = test_mfcc_plan();
+	if(plan != NULL && plan->paa == 0) {
+		stream = mfcc_stream(plan, 64000 / (glbl_window_width / glbl_interval_div), 0);
+	}
+	ring = sample_ring(RING_CAPACITY);
+	if(ring == NULL) {
+		exit(-1);
+	}
 		
 	pthread_t tid;
 
@@ -50,57 +63,41 @@ void* process_thread(void* argp)
 {
 	
 	while(1) {
-		// pr_count++;
-		// check_in();
 		sleep(1);
-		update_arrays(1, 0);
+		process();
 	}
 
 	return NULL;
 }
 
-/* void check_in(void) */
-/* { */
-/* 	if(in_size > 16) { */
-/* 		// update_arrays(1, 0); */
-/* 	} */
-/* 	return; */
-/* } */
-
-void update_arrays(int in, int pr)
+/* Moves everything recorded from the ring to 'pr_array' and the MFCC stream, and segments it */
+void process(void)
 {
-	pthread_mutex_lock(&lock); // lock the arrays
-	if((pr == 0) && (in_size > 16)) {
-		// move the in_buffer to the end of the process_buffer
-		for(int i = 0; i < in_size; i++) {
-			pr_array[i + pr_size] = in_array[i];
-			
+	static size_t reported = 0;
+	struct Ring_Span span;
+	while((span = ring_peek(ring)).length > 0) {
+		if(pr_size == PR_CAPACITY) {
+			// No boundary in the whole buffer, the older half is dropped to make room
+			int drop = PR_CAPACITY / 2;
+			pr_size = shift_and_reduce(pr_array, pr_size, drop);
+			bound_detector_shift(&detector, drop);
+			pr_dropped += drop;
+			printf(":: Dropped %ld unsegmented samples\n", pr_dropped);
 		}
-		// zero out the entire buffer
-		for(int i = 0; i < in_size; i++) {
-			in_array[i] = 0;
-		}
-		// reset the size to allow appending to the start
-		pr_size += in_size;
-		in_size = 0;
-		//for(int i = 0; i < pr_size; i++) {
-		//	printf("pr_size[%d] = %d\n", i, pr_array[i]);
-		// }
-		if(pr_size > 64000 || in_size > 64000) {
-			perror("Over 'pr' limit\n");
-			exit(-1);
+		int n = (span.length < (size_t)(PR_CAPACITY - pr_size)) ? (int)span.length : PR_CAPACITY - pr_size;
+		if(stream != NULL) {
+			mfcc_stream_push(stream, span.samples, n);
 		}
+		memcpy(&pr_array[pr_size], span.samples, sizeof(short) * n);
+		pr_size += n;
+		ring_consume(ring, span, n);
 		boundary(); //  { do_seperation -> dtw }
-	} else {
-		in_array[in_size] = in;
-		in_size++;
-		if(in_size > 64000 || pr_size > 64000) {
-			perror("Over 'in' limit\n");
-			exit(-1);
-		}
 	}
-	pthread_cond_signal(&cond);
-	pthread_mutex_unlock(&lock);
+	size_t dropped = ring_dropped(ring);
+	if(dropped != reported) {
+		printf(":: Dropped %zu recorded samples, processing is behind\n", dropped);
+		reported = dropped;
+	}
 
 	return;
 }
@@ -116,26 +113,24 @@ void record(void)
 		return;
 	}
 	char pathname[1024];
-	FILE* fp;
 	printf(":: Training folder :: %s\n", dir_name);
 	if (p != NULL) {
 		while ((pp = readdir (p)) != NULL) {
 			
-			short* sequence  = NULL;
 			int length = strlen(pp->d_name);
 			if (strncmp(pp->d_name + length - 4, ".wav", 4) == 0) {
 				sprintf(pathname, "%s%s", dir_name, pp->d_name);
-				fp = fopen(pathname, "rb");
-				if(!fp) { printf("Error opening '%s' file", pathname); }
 				printf("Opening '%s' file\n", pathname);
-				sequence = read_wav(fp);
-				int seq_length = sequence[0];
-				for(int i = 1; i < seq_length; i++) {
-					update_arrays(sequence[i], 1);
-					usleep(62.5);
+				struct Wav_Map* wv = wav_map(pathname);
+				if(wv == NULL) {
+					continue;
 				}
-				free(sequence);
-				
+				for(int i = 0; i < wv->length; i += RECORD_BLOCK) {
+					int n = (wv->length - i < RECORD_BLOCK) ? wv->length - i : RECORD_BLOCK;
+					ring_push(ring, &wv->samples[i], n);
+					usleep(62.5 * n);
+				}
+				wav_unmap(wv);
 			}
 			
 		}
@@ -145,70 +140,30 @@ void record(void)
 	return;
 }
 
-short* read_wav(FILE* fp)
-{
-
-	char *buffer;
-	long file_length;
-
-	fseek(fp, 0, SEEK_END);
-	file_length = ftell(fp);
-	rewind(fp);
-	buffer = (char *)malloc(file_length * sizeof(char));
-	size_t r = fread(buffer, sizeof(char), file_length, fp);
-	if(r != file_length) {
-		perror("Fread fail");
-		printf("Tried to read %ld but actually read %ld\n", file_length, r);
-	}
-	fclose(fp);
-
-	int sample_bits =(int)((unsigned char)(buffer[35]) << 8 |
-			       (unsigned char)(buffer[34]));
-
-	int sample_size =(int)((unsigned char)(buffer[43]) << 24 |
-			       (unsigned char)(buffer[42]) << 16 |
-			       (unsigned char)(buffer[41]) << 8 |
-			       (unsigned char)(buffer[40]));
-	
-	short* sequence = malloc((sample_size + 1) * sizeof(short));
-	short byte = 0;
-	if(sample_bits == 16) { // short size
-		int incr = 44, pos = 0;
-		while(incr != sample_size) {
-			byte = (short)((unsigned char)(buffer[incr+1]) << 8|
-					      (unsigned char)(buffer[incr]));
-			memcpy(&sequence[pos], &byte, sizeof(byte));
-			pos++;
-			incr +=2;
-		}
-	}
-	sequence[0] = sample_size;
-	free(buffer);
-	return sequence;
-
-}
-
 void boundary(void)
 {
 	int bound = 0, result = 0; // result = 0; // (send result to buzzer handler)
-	while(1) {
-		bound = next_boundary(pr_array, pr_size);
-		if(bound == 0) {
-			pr_size = shift_and_reduce(pr_array, pr_size, 32);
-			pr_size = pr_size - 32;
-			continue;
+	while((bound = bound_detector_next(&detector, pr_array, pr_size)) != -1) {
+		result = -1;
+		if(stream != NULL) {
+			result = test_phoneme_stream(stream, stream->samples - pr_size, bound);
 		}
-		if(bound == -1) {
-			break;
+		if(result == -1) {
+			short* h = calloc(bound, sizeof(short));
+			if(h == NULL) {
+				printf("Failed to malloc 'h' in boundary\n");
+			} else {
+				for(int i = 0; i < bound; i++) {
+					h[i] = pr_array[i];
+				}
+				result = test_phoneme_utterance(h, bound);
+			}
 		}
-		short* h = calloc(bound, sizeof(short));
-		for(int i = 0; i < bound; i++) {
-			h[i] = pr_array[i];
+		if(result >= 0) {
+			printf("Result :: %s\n", phones[result]->index->name);
 		}
-		result = test_phoneme_utterance(h, bound);
-		printf("Result :: %s\n", phones[result]->index->name);
 		pr_size = shift_and_reduce(pr_array, pr_size, bound);
-		pr_size = pr_size - bound;
+		bound_detector_shift(&detector, bound);
 	}
 	
 
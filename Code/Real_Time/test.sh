@@ -0,0 +1,4 @@
+#!/bin/bash
+
+    eval "gcc -g -Wall -Werror -pedantic -std=c11 ./Tests/ring_test.c ./Misc/ring.c -D_XOPEN_SOURCE=600 -pthread -o ring_test.exe && ./ring_test.exe"
+    eval "gcc -g -Wall -Werror -pedantic -std=c11 ./Tests/model_test.c ./MFCCs/model.c -D_XOPEN_SOURCE=600 -pthread -o model_test.exe && ./model_test.exe"
@@ -8,29 +8,91 @@
  */
 #include "bounds.h"
 
-float get_entropy(short* sequence, int inc);
+/** 
+ * @brief Starts a boundary search at the first sample of a signal
+ * 
+ * @param index The features of the signal, which must outlive the search
+ */
+void bound_detector_init(struct Bound_Detector* bd, const struct Feature_Index* index)
+{
+	bd->index = index;
+	bd->inc = 32;
+	bd->next = 0;
+	bd->start = 0;
+	bd->gap = 0;
+	bd->last_zc = 0;
+	bd->last_ste = 0;
+	bd->prev_entropy = 0;
+}
 
 /** 
- * @brief Creates a new array and moves the remaining values to the new array
+ * @brief Consumes the block at @param bd->next
  * 
- * @param sequence The sequence to procces
- * @param length The length of @param sequence
- * @param shift The amount of data indexed from 0 to remove
+ * @return 1 if the block is a boundary and starts a new segment, otherwise 0
+ *
+ * The boundary is found using entropy, zero cross and short time energy change
+ * thresholds which are defined by the user when running the program.
+ */
+int bound_detector_push(struct Bound_Detector* bd)
+{
+	int inc = bd->inc, at = bd->next;
+	int i = bd->next - bd->start;
+	bd->next += inc;
+	if(i == 0) {
+		return 0;
+	}
+	float zc = index_crossings(bd->index, at, inc);
+	float change = abs(bd->last_zc - zc);
+
+	float ste = index_ste(bd->index, at, inc);
+	if(bd->last_ste == 0) {
+		bd->last_ste = 1;
+	}
+	float ste_change = ((ste-bd->last_ste) / fabs(bd->last_ste)) * 100;
+	
+	float entropy = index_entropy(bd->index, at, inc), entropy_change = 0;
+	if(bd->prev_entropy == 0) {
+		entropy_change = fabs(entropy - bd->prev_entropy);
+	} else {
+		entropy_change = ((entropy-bd->prev_entropy) / fabs(bd->prev_entropy)) * 100;
+	}
+	
+	if((i != inc) && (bd->gap > 6) && 
+	   ((change >= glbl_zc_incr && ste_change <= glbl_ste_incr && entropy_change <= glbl_entr_incr) ||
+	   (ste_change > glbl_larg_ste_incr && entropy_change > glbl_larg_entr_incr))) {
+		bd->start = at;
+		bd->gap = 0;
+		bd->last_zc = 0;
+		bd->last_ste = 0;
+		bd->prev_entropy = 0;
+		return 1;
+	}
+	bd->gap++;
+	bd->prev_entropy = entropy;
+	bd->last_zc = zc;
+	bd->last_ste = ste;
+	return 0;
+}
+
+/** 
+ * @brief Consumes the blocks of the signal up to its next boundary
  * 
- * @return The new array with the data from 0 -> @param shift
+ * @param length The amount of the indexed signal which has arrived
+ * 
+ * @return The boundary, or -1 if there is none in the samples so far
  *
- * Once a boundary has been found and processed this data needs to be removed
- * from the array, this removes this data and returns a new array to save memory
- * and prevent a memory leak.
+ * A block is only consumed once a sample follows it, as the search did when it rescanned the
+ * signal from the last boundary, so the boundaries do not depend on how the signal arrives.
  */
-short* shift_and_reduce(short* sequence, int length, int shift)
+int bound_detector_next(struct Bound_Detector* bd, int length)
 {
-	short* new = (short*)calloc((length - shift), sizeof(short));
-	for(int i = shift; i < length; i++) {
-		new[i - shift] = sequence[i];			  
+	length = (length < bd->index->length) ? length : bd->index->length;
+	while(bd->next + bd->inc < length) {
+		if(bound_detector_push(bd)) {
+			return bd->start;
+		}
 	}
-	free(sequence);
-	return new;
+	return -1;
 }
 
 /** 
@@ -39,51 +101,21 @@ short* shift_and_reduce(short* sequence, int length, int shift)
  * @param sequence The audio signal to process
  * @param length The length of @param sequence
  * 
- * @return The next boundary found in the audio sequence
+ * @return The next boundary found in the audio sequence, or -1 if there is none
  *
- * The boundary is found using entropy, zero cross and short time energy change
- * thresholds which are defined by the user when running the program.
+ * Searching a whole signal from its start, see \fn bound_detector_next().
  */
 int next_boundary(short* sequence, int length)
 {
-	if(length <= 32)
+	struct Feature_Index* index = feature_index(sequence, length);
+	if(index == NULL) {
 		return -1;
-	int inc = 32, gap = 0;
-	float change = 0, last_zc = 0, ste_change = 0, last_ste = 0; 
-	float entropy = 0, prev_entropy = 0, entropy_change = 0;
-	
-	for(int i = inc; i < length - inc; i+=inc) {
-		entropy = 0;
-		float zc = cross_rate(&sequence[i], inc);
-		change = abs(last_zc - zc);
-
-		float ste = short_time_energy(&sequence[i], inc, inc);
-		if(last_ste == 0) {
-			last_ste = 1;
-		}
-		ste_change = ((ste-last_ste) / fabs(last_ste)) * 100;
-		
-		
-		entropy = get_entropy(&sequence[i], inc); 
-		if(prev_entropy == 0) {
-			entropy_change = fabs(entropy - prev_entropy);
-		} else {
-			entropy_change = ((entropy-prev_entropy) / fabs(prev_entropy)) * 100;
-		}
-		
-		
-		if((i != 32) && (gap > 6) && 
-		   ((change >= glbl_zc_incr && ste_change <= glbl_ste_incr && entropy_change <= glbl_entr_incr) ||
-		   (ste_change > glbl_larg_ste_incr && entropy_change > glbl_larg_entr_incr))) {
-			return i;
-		}
-		gap++;
-		prev_entropy = entropy;
-		last_zc = zc;
-		last_ste = ste;
-		change = 0;
 	}
-	return -1;
+	struct Bound_Detector bd;
+	bound_detector_init(&bd, index);
+	int bound = bound_detector_next(&bd, length);
+	free_feature_index(index);
+	return bound;
 }
 
 /** 
@@ -92,21 +124,10 @@ int next_boundary(short* sequence, int length)
  * @param sequence The audio chunk to process
  * @param inc The length of @param sequence
  * 
- * @return The entropy value of @param sequence
+ * @return The entropy value of @param sequence, which is left as it was
  */
-float get_entropy(short* sequence, int inc)
+float get_entropy(const short* sequence, int inc)
 {
-	float entropy = 0;
-	for(int m = 0; m < inc; m++) {
-		if(sequence[m] == 0) {
-			sequence[m] = 1;
-		}
-		sequence[m] = abs(sequence[m]);
-		if(sequence[m] == -32768) {
-			sequence[m] = 32767;
-		}
-		entropy += (float)(sequence[m]) * (log(sequence[m]) / log(2));
-	}
-	return entropy;
+	return s16_entropy(sequence, inc);
 }
 
@@ -8,9 +8,37 @@
 #include <float.h>
 #include "cross_rate.h"
 #include "ste.h"
+#include "feature_index.h"
 #include "../Feature_Extraction/fft.h"
+#include "../Feature_Extraction/entropy.h"
 
+/**
+ * \struct Bound_Detector
+ * \brief The state of a boundary search which consumes each block of a signal once
+ * @index The features of the signal, which each block is measured from
+ * @inc The length of a block
+ * @next The first sample of the next block to be consumed
+ * @start The first sample of the current segment, the block found as its boundary
+ * @gap The amount of blocks measured since @start
+ * @last_zc,@last_ste,@prev_entropy The measures of the previous block, 0 at the start of a segment
+ *
+ * The first block of a segment is never measured, so a boundary is at least two blocks after the last.
+ */
+struct Bound_Detector {
+	const struct Feature_Index* index;
+	int inc;
+	int next;
+	int start;
+	int gap;
+	float last_zc;
+	float last_ste;
+	float prev_entropy;
+};
+
+void bound_detector_init(struct Bound_Detector* bd, const struct Feature_Index* index);
+int bound_detector_push(struct Bound_Detector* bd);
+int bound_detector_next(struct Bound_Detector* bd, int length);
 int next_boundary(short* sequence, int length);
-short* shift_and_reduce(short* sequence, int length, int shift);
+float get_entropy(const short* sequence, int inc);
 	
 #endif
@@ -125,40 +125,41 @@ float stavg_cross_rate_no_overlap(float* signal, int signal_length)
 
 	int last = floor(signal_length / glbl_window_width);
         float** chunks =  hanning_chunks_no_overlap(signal, signal_length, glbl_window_width);
+	// Each chunk's rate is used three times
+	float* rates = (float*)malloc(sizeof(float) * (last + 1));
+	for(int i = 0; i < last; i++) {
+		rates[i] = f_cross_rate(chunks[i], glbl_window_width);
+		free(chunks[i]);
+	}
+	free(chunks);
 
 	double sum = 0, mean = 0, std = 0;
 	
 	for(int i = 0; i < last; i++) {
-		result += f_cross_rate(chunks[i], glbl_window_width);	    
+		result += rates[i];	    
 	}
 
 	mean = result;
 	for(int i = 0; i < last; i++) {
-		sum += pow( ( (f_cross_rate(chunks[i], glbl_window_width)) - mean), 2);
+		sum += pow( (rates[i] - mean), 2);
 	}
 	if(sum == 0) {
-		for(int i = 0; i < last; i++) {
-			free(chunks[i]);
-		}
-		free(chunks);
+		free(rates);
 		return 0;
 	}
 	std = sqrt(sum / (last + 1));
 	result = 0;
 	int tot = 0;
 	for(int i = 0; i < last; i++) {
-		double Z_score = ((f_cross_rate(chunks[i], glbl_window_width)) - mean) / std;
+		double Z_score = (rates[i] - mean) / std;
 		if(Z_score < 2.0 && Z_score > -2.0) {
-			result += f_cross_rate(chunks[i], glbl_window_width);
+			result += rates[i];
 			tot++;
 		}
 	}
 	result /= tot;
 	
-	for(int i = 0; i < last; i++) {
-		free(chunks[i]);
-	}
-	free(chunks);
+	free(rates);
 	return result;
 }
 
@@ -0,0 +1,146 @@
+/**
+ * @file   feature_index.c
+ * @brief  Building and reading the running feature sums of a signal, see @file feature_index.h
+ *
+ * The sums are kept in doubles. The squares of int16 samples are integers, so their sums stay exact
+ * while they are below 2^53, some 8 million full scale samples, which is far longer than an utterance.
+ * Past that a window's energy is a difference of rounded sums and loses the low bits.
+ */
+#include "feature_index.h"
+#include "../Dynamic_Time_Warping/dtw.h"
+
+int is_positive(short num);
+int f_is_positive(float num);
+
+/**
+ * @brief Allocates an index of @param length samples, with the sums before the first sample set
+ *
+ * @return The index, or NULL if it could not be allocated
+ */
+static struct Feature_Index* new_index(int length)
+{
+	struct Feature_Index* index = (struct Feature_Index*)calloc(1, sizeof(struct Feature_Index));
+	if(index == NULL) {
+		printf("Failed to malloc 'index' in feature index\n");
+		return NULL;
+	}
+	index->length = (length > 0) ? length : 0;
+	index->energy = (double*)malloc(sizeof(double) * (index->length + 2));
+	index->crossings = (int*)malloc(sizeof(int) * (index->length + 2));
+	index->entropy = (double*)malloc(sizeof(double) * (index->length + 2));
+	if(index->energy == NULL || index->crossings == NULL || index->entropy == NULL) {
+		printf("Failed to malloc the sums of a %d sample feature index\n", length);
+		free_feature_index(index);
+		return NULL;
+	}
+	index->energy[0] = 0;
+	index->crossings[0] = 0;
+	index->crossings[1] = 0;
+	index->entropy[0] = 0;
+	return index;
+}
+
+/**
+ * @brief Indexes an int16 signal
+ *
+ * @param signal The signal, which must outlive the index
+ * @param length The length of @param signal
+ *
+ * @return The index, released with \fn free_feature_index(), or NULL if it could not be allocated
+ */
+struct Feature_Index* feature_index(const short* signal, int length)
+{
+	struct Feature_Index* index = new_index(length);
+	if(index == NULL) {
+		return NULL;
+	}
+	const double* table = entropy_table();
+	index->signal = signal;
+	for(int i = 0; i < index->length; i++) {
+		int x = signal[i];
+		index->energy[i + 1] = index->energy[i] + (double)(x * x);
+		index->entropy[i + 1] = index->entropy[i] + s16_entropy_term(table, signal[i]);
+		if(i > 0) {
+			index->crossings[i + 1] = index->crossings[i] + (is_positive(signal[i - 1]) != is_positive(signal[i]));
+		}
+	}
+	return index;
+}
+
+/**
+ * @brief Indexes a float signal, as \fn feature_index()
+ */
+struct Feature_Index* f_feature_index(const float* signal, int length)
+{
+	struct Feature_Index* index = new_index(length);
+	if(index == NULL) {
+		return NULL;
+	}
+	const double* table = entropy_table();
+	for(int i = 0; i < index->length; i++) {
+		index->energy[i + 1] = index->energy[i] + (double)signal[i] * signal[i];
+		index->entropy[i + 1] = index->entropy[i] + f_entropy_term(table, signal[i]);
+		if(i > 0) {
+			index->crossings[i + 1] = index->crossings[i] + (f_is_positive(signal[i - 1]) != f_is_positive(signal[i]));
+		}
+	}
+	return index;
+}
+
+void free_feature_index(struct Feature_Index* index)
+{
+	if(index == NULL) {
+		return;
+	}
+	free(index->energy);
+	free(index->crossings);
+	free(index->entropy);
+	free(index);
+}
+
+/**
+ * @brief The sum of the squared samples @param from to @param from + @param length - 1
+ */
+double index_energy(const struct Feature_Index* index, int from, int length)
+{
+	return index->energy[from + length] - index->energy[from];
+}
+
+/**
+ * @brief The short time energy of a window, as \fn short_time_energy() gives it
+ */
+float index_ste(const struct Feature_Index* index, int from, int length)
+{
+	return index_energy(index, from, length) / (1 + length / glbl_window_width);
+}
+
+/**
+ * @brief The zero crossings within a window, as \fn cross_rate() counts them
+ */
+int index_crossings(const struct Feature_Index* index, int from, int length)
+{
+	if(length < 2) {
+		return 0;
+	}
+	return index->crossings[from + length] - index->crossings[from + 1];
+}
+
+/**
+ * @brief The entropy of a window, as \fn get_entropy() gives it
+ */
+double index_entropy(const struct Feature_Index* index, int from, int length)
+{
+	return index->entropy[from + length] - index->entropy[from];
+}
+
+/**
+ * @brief The log entropy of a window, as \fn log_entropy() gives it
+ */
+float index_log_entropy(const struct Feature_Index* index, int from, int length)
+{
+	double entropy = index_entropy(index, from, length);
+	if(entropy == 0.0) {
+		return 0;
+	}
+	return (float)log(fabs(entropy));
+}
@@ -0,0 +1,43 @@
+#ifndef FEATURE_INDEX_H
+#define FEATURE_INDEX_H
+
+/**
+ * @file   feature_index.h
+ * @brief  Running sums of a signal's energy, zero crossings and entropy, so each over any window is a subtraction
+ *
+ * The index is built in one pass over the signal, then the short time energy, zero cross rate and
+ * entropy of any block, frame or segment of it are read without touching the samples again.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "../Feature_Extraction/entropy.h"
+
+/**
+ * \struct Feature_Index
+ * \brief The running sums of a signal, each @length + 1 values with the sum before sample i at i
+ * @signal The indexed samples, NULL if the index was built from floats
+ * @energy The sum of the squared samples
+ * @crossings The amount of zero crossings between the samples before i
+ * @entropy The sum of |x|log2|x|, where 0 adds nothing and -32768 counts as 32767
+ */
+struct Feature_Index {
+	const short* signal;
+	int length;
+	double* energy;
+	int* crossings;
+	double* entropy;
+};
+
+struct Feature_Index* feature_index(const short* signal, int length);
+struct Feature_Index* f_feature_index(const float* signal, int length);
+void free_feature_index(struct Feature_Index* index);
+double index_energy(const struct Feature_Index* index, int from, int length);
+float index_ste(const struct Feature_Index* index, int from, int length);
+int index_crossings(const struct Feature_Index* index, int from, int length);
+double index_entropy(const struct Feature_Index* index, int from, int length);
+float index_log_entropy(const struct Feature_Index* index, int from, int length);
+
+#endif
@@ -21,25 +21,11 @@
 float short_time_energy(short* signal, int signal_length, int window_length)
 {
 	float result = 0;
-	float* window = hanning_window(window_length);
-	float* ste_buff = calloc(signal_length, sizeof(float));
-	int pos = 0, incr = 1;
+	int incr = 1 + signal_length / glbl_window_width;
 	for(int i = 0; i < signal_length; i++) {
-		ste_buff[i] = (signal[i] * signal[i]); // * window[pos];
-		pos++;
-		if(pos == glbl_window_width) {
-			pos = 0;
-			incr++;
-		}
-	}
-
-	for(int i = 0; i < signal_length; i++) {
-		result += ste_buff[i];
-		
+		result += (float)(signal[i] * signal[i]);
 	}
 	result /= incr;
-	free(window);
-	free(ste_buff);
 	return result;
 }
 
@@ -56,25 +42,11 @@ float short_time_energy(short* signal, int signal_length, int window_length)
 float f_short_time_energy(float* signal, int signal_length, int window_length)
 {
 	float result = 0;
-	float* window = hanning_window(window_length);
-	float* ste_buff = calloc(signal_length, sizeof(float));
-	int pos = 0, incr = 1;
+	int incr = 1 + signal_length / glbl_window_width;
 	for(int i = 0; i < signal_length; i++) {
-		ste_buff[i] = (signal[i] * signal[i]); // * window[pos];
-		pos++;
-		if(pos == glbl_window_width) {
-			pos = 0;
-			incr++;
-		}
-	}
-
-	for(int i = 0; i < signal_length; i++) {
-		result += ste_buff[i];
-		
+		result += (float)(signal[i] * signal[i]);
 	}
 	result /= incr;
-	free(window);
-	free(ste_buff);
 	return result;
 }
 
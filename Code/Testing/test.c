@@ -9,6 +9,7 @@
  */
 
 #include "test.h"
+#include <stdatomic.h>
 
 struct guess {
 	long start;
@@ -52,6 +53,9 @@ int current_chunk = 0;            /* The current index of chunks when using SPLI
 int group_matrix[7][7] = {0};     /* The final confusion matrix for phoneme groups */
 int voice_matrix[3][3] = {0};     /* The final confusion matrix for phoneme voice types */
 
+static struct Score_Context test_ctx; /* The scoring context of serial tests; merged and released at the end of \fn test() */
+static pthread_mutex_t results_lock = PTHREAD_MUTEX_INITIALIZER; /* Guards the result files and @var done between test workers */
+
 char* best_file;                  /* The filename of the reference file with the lowest WER */
 char* worst_file;                 /* The filename of the reference file with the highest WER */
 
@@ -81,7 +85,7 @@ struct codes {
 }; /* Stores the codes found in a reference files or result (.res) files */
 
 void export_results_pca(char* ph_code);
-int test_phoneme_utterance(short* h, int signal_length);
+int test_phoneme_utterance(short* h, int signal_length, const struct Feature_Index* index, int from);
 void minimum_edit_distance(char* res_filename, char* phn_filename);
 void merge_silences(char* filename);
 struct codes* get_codes(char* filename);
@@ -161,6 +165,101 @@ void reset(void)
 	return;
 }
 
+/** 
+ * @brief Allocates a scoring context for one test worker, sized for the current phonemes and prototypes
+ * 
+ * @param ctx The context to initialise
+ */
+void init_score_context(struct Score_Context* ctx)
+{
+	memset(ctx, 0, sizeof(struct Score_Context));
+	ctx->score = (double*)calloc(num_ph, sizeof(double));
+	ctx->per_correct = (float*)calloc(num_ph, sizeof(float));
+	ctx->matrix = (int**)calloc(num_ph, sizeof(int*));
+	ctx->used = (int**)calloc(num_ph, sizeof(int*));
+	ctx->correct = (float**)calloc(num_ph, sizeof(float*));
+	ctx->error = (float**)calloc(num_ph, sizeof(float*));
+	for(int i = 1; i < num_ph; i++) {
+		ctx->matrix[i] = (int*)calloc(num_ph, sizeof(int));
+		ctx->used[i] = (int*)calloc(phones[i]->size_count, sizeof(int));
+		ctx->correct[i] = (float*)calloc(phones[i]->size_count, sizeof(float));
+		ctx->error[i] = (float*)calloc(phones[i]->size_count, sizeof(float));
+	}
+	ctx->mfcc = default_mfcc_plan();
+	if(ctx->mfcc == NULL) {
+		exit(-1);
+	}
+	return;
+}
+
+/** 
+ * @brief Adds a worker's results to the global results and each prototype's statistics
+ * 
+ * @param ctx The context to merge
+ *
+ * Every result is a count, so merging the workers one after another gives the same totals as a serial run.
+ */
+void merge_score_context(struct Score_Context* ctx)
+{
+	for(int i = 1; i < num_ph; i++) {
+		per_correct[i] += ctx->per_correct[i];
+		for(int j = 1; j < num_ph; j++) {
+			matrix[i][j] += ctx->matrix[i][j];
+		}
+		for(int j = 0; j < phones[i]->size_count; j++) {
+			phones[i]->used[j] += ctx->used[i][j];
+			phones[i]->correct[j] += ctx->correct[i][j];
+			phones[i]->error[j] += ctx->error[i][j];
+		}
+	}
+	for(int i = 0; i < 7; i++) {
+		for(int j = 0; j < 7; j++) {
+			group_matrix[i][j] += ctx->group_matrix[i][j];
+		}
+	}
+	for(int i = 0; i < 3; i++) {
+		for(int j = 0; j < 3; j++) {
+			voice_matrix[i][j] += ctx->voice_matrix[i][j];
+		}
+	}
+	tested += ctx->tested;
+	correct += ctx->n_correct;
+	fails += ctx->fails;
+	group += ctx->group;
+	zero_fails += ctx->zero_fails;
+	abandoned += ctx->abandoned;
+	lb_kim_pruned += ctx->lb_kim_pruned;
+	lb_keogh_pruned += ctx->lb_keogh_pruned;
+	mismatched += ctx->mismatched;
+	total_test_time += ctx->total_test_time;
+	total_dtw_tests += ctx->total_dtw_tests;
+	return;
+}
+
+/** 
+ * @brief Releases a scoring context and its DTW workspace
+ * 
+ * @param ctx The context to release
+ */
+void free_score_context(struct Score_Context* ctx)
+{
+	for(int i = 1; i < num_ph; i++) {
+		free(ctx->matrix[i]);
+		free(ctx->used[i]);
+		free(ctx->correct[i]);
+		free(ctx->error[i]);
+	}
+	free(ctx->matrix);
+	free(ctx->used);
+	free(ctx->correct);
+	free(ctx->error);
+	free(ctx->score);
+	free(ctx->per_correct);
+	dtw_workspace_free(&ctx->ws);
+	free_mfcc_plan(ctx->mfcc);
+	return;
+}
+
 /** 
   * @brief Extracts the labels (start, end and code) from a given file
   * 
@@ -325,18 +424,111 @@ void minimum_edit_distance(char* res_filename, char* phn_filename)
 	return;
 }
 
+/** 
+ * @brief Computes the features of a test sequence once, to be shared by every comparison made for it
+ * 
+ * @param h The audio signal to test
+ * @param signal_length The length of @param h
+ * @param norm If the MFCC should be normalised, the deltas are then taken from the normalised MFCC
+ * @param plan The MFCC extractor of the calling thread
+ * @param index The features of the utterance @param h is an unaltered part of, or NULL to measure @param h itself
+ * @param from The first sample of @param h in @param index
+ * 
+ * @return The test's features, NULL if no MFCC could be produced. Released with \fn free_test_features()
+ */
+struct Test_Features* test_features(short* h, int signal_length, int norm, struct Mfcc_Plan* plan, const struct Feature_Index* index, int from)
+{
+	struct Test_Features* test = (struct Test_Features*)calloc(1, sizeof(struct Test_Features));
+	float* signal = (float*)malloc(sizeof(float) * signal_length);
+	for(int i = 0; i < signal_length; i++) {
+		signal[i] = h[i];
+	}
+	test->length = signal_length;
+	test->windows = floor(signal_length / glbl_window_width);
+	test->zc = (float*)calloc(test->windows, sizeof(float));
+	test->ste = (float*)calloc(test->windows, sizeof(float));
+	test->kurtosis = (float*)calloc(test->windows, sizeof(float));
+	test->flatness = (float*)calloc(test->windows, sizeof(float));
+	for(int m = 0; m < test->windows; m++) {
+		if(index != NULL) {
+			test->zc[m] = index_crossings(index, from + m * glbl_window_width, glbl_window_width);
+			test->ste[m] = index_ste(index, from + m * glbl_window_width, glbl_window_width);
+		} else {
+			test->zc[m] = f_cross_rate(&signal[m * glbl_window_width], glbl_window_width);
+			test->ste[m] = short_time_energy(&h[m * glbl_window_width], glbl_window_width, glbl_window_width);
+		}
+		test->kurtosis[m] = kurtosis(&signal[m * glbl_window_width], glbl_window_width);
+		test->flatness[m] = flatness(&signal[m * glbl_window_width], glbl_window_width);
+	}
+
+	test->mfcc = mfcc(plan, signal, signal_length);
+	free(signal);
+	if(test->mfcc == NULL) {
+		free_test_features(test);
+		return NULL;
+	}
+	test->mfcc_length = mfcc_size(signal_length);
+	if(norm) {
+		normalise_mfcc(test->mfcc, test->mfcc_length);
+	}
+	if(DELTA || DELTA_DELTA) {
+		float* signal_delta = delta(test->mfcc, test->mfcc_length);
+		if(DELTA_DELTA) {
+			test->delta_delta = delta_delta(signal_delta, test->mfcc_length);
+			if(NORM) {
+				normalise_delta_delta(test->delta_delta, test->mfcc_length);
+			}
+		}
+		if(DELTA) {
+			if(NORM) {
+				normalise_delta(signal_delta, test->mfcc_length);
+			}
+			test->delta = signal_delta;
+		} else {
+			free(signal_delta);
+		}
+	}
+	if(LB) {
+		int trunc = floor(glbl_banks * glbl_test_trunc);
+		test->min = (float*)malloc(sizeof(float) * trunc);
+		test->max = (float*)malloc(sizeof(float) * trunc);
+		mfcc_extremes(test->mfcc, test->mfcc_length, trunc, test->min, test->max);
+	}
+	return test;
+}
+
+/** 
+ * @brief Releases the features produced by \fn test_features()
+ */
+void free_test_features(struct Test_Features* test)
+{
+	free(test->mfcc);
+	free(test->delta);
+	free(test->delta_delta);
+	free(test->zc);
+	free(test->ste);
+	free(test->kurtosis);
+	free(test->flatness);
+	free(test->min);
+	free(test->max);
+	free(test);
+}
+
 /** 
  * @brief Tests files without knowing the boundaries, will use the boundary detection to find them.
  * 
  * @param h The audio signal to test
  * @param signal_length The length of @param h
+ * @param index The features of the utterance @param h was taken from
+ * @param from The first sample of @param h in the utterance
  * 
  * @return The classified phoneme's index
  */
-int test_phoneme_utterance(short* h, int signal_length)
+int test_phoneme_utterance(short* h, int signal_length, const struct Feature_Index* index, int from)
 {
+	struct Score_Context* ctx = &test_ctx;
 	// int test_length = signal_length;
-	int sil = is_sil_ste(h, signal_length);
+	int sil = is_sil_ste(index, from, signal_length);
 	// int sil_zc = is_sil_zc(h, signal_length);
 	if(sil == 0  || signal_length <= 256) {
 		free(h);
@@ -346,6 +538,8 @@ int test_phoneme_utterance(short* h, int signal_length)
 	// 	return (num_ph - 1);
 	// }
 	int new_length = signal_length;
+	// A resized segment is no longer the indexed samples
+	const struct Feature_Index* measured = index;
 	// by width / div_interval ?
 	if(signal_length % glbl_window_width != 0) {
 		while(new_length % glbl_window_width != 0) {
@@ -353,104 +547,85 @@ int test_phoneme_utterance(short* h, int signal_length)
 		}
 		h = resize(h, signal_length, new_length);
 		signal_length = new_length;
+		measured = NULL;
 	}
 	if((signal_length / glbl_paa) < glbl_window_width) {
 		h = resize(h, signal_length, (glbl_window_width * glbl_paa));
 		signal_length = (glbl_window_width * glbl_paa);
+		measured = NULL;
 	}
 	int j = 1;
 	while(strcmp(p_codes[j], "\0") != 0) {
 		j++;	
 	}
-	num_ph = j;
 
 	// double ste = short_time_energy(h, signal_length, glbl_window_width);
-	float** complete_signal = (float**)malloc(sizeof(float*) * 3);
-	float* signal = (float*)malloc(sizeof(float) * signal_length);
-	for(int i = 0; i < signal_length; i++) {
-		signal[i] = h[i];
-	}
-	
-	int extra_size = floor(signal_length / glbl_window_width);
-
-	complete_signal[1] = (float*)calloc(extra_size, sizeof(float));
-	complete_signal[2] = (float*)calloc(extra_size, sizeof(float));
-	for(int m = 0; m < extra_size; m++) {
-		complete_signal[1][m] = f_cross_rate(&signal[m * glbl_window_width], glbl_window_width);
-		complete_signal[2][m] = short_time_energy(&h[m * glbl_window_width], glbl_window_width, glbl_window_width); 
-	}
-
-	signal = mfcc(signal, signal_length, glbl_window_width, glbl_banks, glbl_paa_op);
-	
-	complete_signal[0] = signal;
-	if(signal == NULL) {
+	struct Test_Features* test = test_features(h, signal_length, 0, ctx->mfcc, measured, from);
+	if(test == NULL) {
 		printf("Unable to produce mfcc for phoneme\n");
 		for(int i = 1; i < j; i++) {
-			phones[i]->score = DBL_MAX;
+			ctx->score[i] = DBL_MAX;
 		}
 		free(h);
 		return - 1;
 	}
-	int new_size = mfcc_size(signal_length);
+	int new_size = test->mfcc_length;
 	if(new_size <= 0) {
 		printf("No length found for a test sequence, possibly too short or window too large\nNo testing has been done\n length : %d :: || incr :: %d || mfcc_size :: %d\n", signal_length, glbl_window_width, new_size);
 		for(int i = 1; i < j; i++) {
-			phones[i]->score = DBL_MAX;
+			ctx->score[i] = DBL_MAX;
 		}
+		free_test_features(test);
 		free(h);
 		return -1;
 	}
 		
 	
-	DTW_ERROR = 0;
-	best_so_far = DBL_MAX;
+	ctx->dtw_error = 0;
 	int knn = 0;
 	for(int i = 1; i < j; i++) {
-		phones[i]->score = 0;
+		ctx->score[i] = 0;
 		// if(zc < ph_zc_max[i] && zc > ph_zc_min[i] && DTW_ERROR != NO_SIG_LEN &&
 		//	ste < ste_max[i] && ste > ste_min[i]) {
 		if(CLUST && !(KNN)) {
-			dtw_clust(complete_signal, signal_length, phones[i], glbl_dtw_window);
+			dtw_clust(test, phones[i], glbl_dtw_window, ctx);
 		} else if(KNN && !(CLUST)) {
-			knn = knn_mfccs_size(complete_signal, signal_length, glbl_k, NULL);
+			knn = knn_mfccs_size(test, glbl_k, NULL, ctx);
 			break;
 		} else if(KNN && CLUST) {
-			knn = k_means(signal, signal_length, glbl_k);
+			knn = k_means(test, glbl_k, ctx);
 			break;
 		} else {
-			dtw_frame(complete_signal, signal_length, phones[i], glbl_dtw_window);
+			dtw_frame(test, phones[i], glbl_dtw_window, ctx);
 		}
 	}
 	if(KNN) {
 		for(int i = 1; i < num_ph; i++) {
 			if(i == knn) {
-				phones[i]->score = 0;
+				ctx->score[i] = 0;
 			} else {
-				phones[i]->score = 1;
+				ctx->score[i] = 1;
 			}
 		}
 	}
 
-	if(failed == 1) {
+	if(ctx->failed == 1) {
 		printf("Failed Phoneme\n");
-		failed = 0;
+		ctx->failed = 0;
 	} else {
-		tested++;
+		ctx->tested++;
 	}
 	double sml = DBL_MAX;
 	int pos = 1;
 	for(int i = 1; i < j; i++) {
-		if(phones[i]->score < sml) {
-			sml = phones[i]->score;
+		if(ctx->score[i] < sml) {
+			sml = ctx->score[i];
 			pos = i;
 		}
 	}
 	// export_results(phones[1]->index->name);
 	free(h);
-	free(complete_signal[0]);
-	free(complete_signal[1]);
-	free(complete_signal[2]);
-	free(complete_signal);
+	free_test_features(test);
 	if(KNN) {
 		if(phones[knn]->index->group_i == 0 && sil == 2) {
 			return (num_ph - 1);
@@ -468,11 +643,12 @@ int test_phoneme_utterance(short* h, int signal_length)
  * @param h The signal to be classified
  * @param signal_length The length of @param h
  * @param p The previous phoneme, used for the grammar functions
+ * @param ctx The scoring context of the calling worker
  *
  * This is the main one-to-one testing function and can test phonemes using basic DTW, KNN, K-means, etc.
- * A 'complete_signal' can be produced which stores the STE and ZC values for each frame to be used in voice type KNN classification
+ * The test's MFCC, deltas and the STE, ZC, kurtosis and flatness of each window are produced once by \fn test_features() and shared by every comparison
  */
-void test_phoneme(short* h, int signal_length, char* p)
+void test_phoneme(short* h, int signal_length, char* p, struct Score_Context* ctx)
 {
 
 	int j = 1;
@@ -485,18 +661,12 @@ void test_phoneme(short* h, int signal_length, char* p)
 	if(new_size <= 0) {
 		printf("No length found for a test sequence, possibly too short or window too large\nNo testing has been done\n length : %d :: || incr :: %d || mfcc_size :: %d\n", signal_length, glbl_window_width, new_size);
 		for(int i = 1; i < j; i++) {
-			phones[i]->score = DBL_MAX;
+			ctx->score[i] = DBL_MAX;
 		}
 		return;
 	}
-	num_ph = j;
 
 	// float ste = short_time_energy(h, signal_length, glbl_window_width);
-	float** complete_signal = (float**)malloc(sizeof(float*) * 5);
-	float* signal = (float*)malloc(sizeof(float) * signal_length);
-	for(int i = 0; i < signal_length; i++) {
-		signal[i] = h[i];
-	}
 
 	/* int sil = is_sil_ste(h, signal_length); */
 	/* // int sil_zc = is_sil_zc(h, signal_length); */
@@ -535,78 +705,54 @@ void test_phoneme(short* h, int signal_length, char* p)
 	/* int sil = is_sil_ste(h, signal_length); */
 	/* int sil_zc = is_sil_zc(h, signal_length); */
 	
-	int extra_size = floor(signal_length / glbl_window_width);
-
-	complete_signal[1] = (float*)calloc(extra_size, sizeof(float));
-	complete_signal[2] = (float*)calloc(extra_size, sizeof(float));
-	complete_signal[3] = (float*)calloc(extra_size, sizeof(float));
-	complete_signal[4] = (float*)calloc(extra_size, sizeof(float));
-	for(int m = 0; m < extra_size; m++) {
-		complete_signal[1][m] = f_cross_rate(&signal[m * glbl_window_width], glbl_window_width);
-		complete_signal[2][m] = short_time_energy(&h[m * glbl_window_width], glbl_window_width, glbl_window_width);
-		complete_signal[3][m] = kurtosis(&signal[m * glbl_window_width], glbl_window_width);
-		complete_signal[4][m] = flatness(&signal[m * glbl_window_width], glbl_window_width);
-	}
-	
-	signal = mfcc(signal, signal_length, glbl_window_width, glbl_banks, glbl_paa_op);
-	
-	if(NORM) {
-		normalise_mfcc(signal, new_size);
-	}
-	complete_signal[0] = signal;
-	if(signal == NULL) {
+	struct Test_Features* test = test_features(h, signal_length, NORM, ctx->mfcc, NULL, 0);
+	if(test == NULL) {
 		printf("Unable to produce mfcc for phoneme :: %s\n", p);
 		for(int i = 1; i < j; i++) {
-			phones[i]->score = DBL_MAX;
+			ctx->score[i] = DBL_MAX;
 		}
 		return;
 	}
 	
-	DTW_ERROR = 0;
-	best_so_far = DBL_MAX;
+	ctx->dtw_error = 0;
 	int knn = 0;
 	for(int i = start; i < end; i++) {
-		phones[i]->score = 0;
+		ctx->score[i] = 0;
 		// if(stavg > stavg_noov[i] * 0.75 && stavg < stavg_noov[i] * 1.25) {
-		if(DTW_ERROR != NO_SIG_LEN) { // &&
+		if(ctx->dtw_error != NO_SIG_LEN) { // &&
 		   // ste < ste_max[i] && ste > ste_min[i]) {
 			if(CLUST && !(KNN)) {
-				dtw_clust(complete_signal, signal_length, phones[i], glbl_dtw_window);
+				dtw_clust(test, phones[i], glbl_dtw_window, ctx);
 			} else if(KNN && !(CLUST)) {
-				knn = knn_mfccs_size(complete_signal, signal_length, glbl_k, p);
+				knn = knn_mfccs_size(test, glbl_k, p, ctx);
 				break;
 			} else if(KNN && CLUST) {
-				knn = k_means(signal, signal_length, glbl_k);
+				knn = k_means(test, glbl_k, ctx);
 				break;
 			} else {
-				dtw_frame(complete_signal, signal_length, phones[i], glbl_dtw_window);
+				dtw_frame(test, phones[i], glbl_dtw_window, ctx);
 			}
 		} else {
-			phones[i]->score = DBL_MAX;
+			ctx->score[i] = DBL_MAX;
 		}
 	}
 	if(KNN || SVM) {
 		for(int i = 1; i < num_ph; i++) {
 			if(i == knn) {
-				phones[i]->score = 0;
+				ctx->score[i] = 0;
 			} else {
-				phones[i]->score = 1;
+				ctx->score[i] = 1;
 			}
 		}
 	}
-	if(failed == 1) {
+	if(ctx->failed == 1) {
 		printf("Failed Phoneme :: %s\n", p);
-		failed = 0;
+		ctx->failed = 0;
 	} else {
-		tested++;
-	}
-	export_results(p);
-	free(complete_signal[0]);
-	free(complete_signal[1]);
-	free(complete_signal[2]);
-	free(complete_signal[3]);
-	free(complete_signal[4]);
-	free(complete_signal);
+		ctx->tested++;
+	}
+	export_results(p, ctx);
+	free_test_features(test);
 		
 	return;
 }
@@ -615,12 +761,13 @@ void test_phoneme(short* h, int signal_length, char* p)
  * @brief Exports the results of a test. Used for one-to-one testing, not boundary testing.
  * 
  * @param ph_code The code of the phoneme which has been tested.
+ * @param ctx The scoring context holding the test's scores, which also receives the result counts
  *
  * A result may be exported to correct, group or fail. If the classification is correct then 'correct' will be used, if it is was within the same
  * group then 'group' will be used, if neither then 'fail' will be used. This export will contain what the correct phoneme's score was and what the
  * classifications score was at the top with a list of all tested phonemes with their scores below.
  */
-void export_results(char* ph_code)
+void export_results(char* ph_code, struct Score_Context* ctx)
 {
 	// init structs - load the proto sequence
 	int j = 1, index = 0;
@@ -629,40 +776,39 @@ void export_results(char* ph_code)
 	while(strcmp(p_codes[j], "\0") != 0) {
 		j++;	
 	}
-	num_ph = j;
 	int t_index = 0;
 	int zero_scores = 0;
 	// short results[3] = {SHRT_MAX, SHRT_MAX, SHRT_MAX};
 	// int s_indexes[3] = {0, 0, 0};
 	/* for(int i = 1; i < j; i++) { */
 	/* 	if(strcmp(phones[i]->index->name, ph_code) == 0) { */
-	/* 		actual = phones[i]->score; */
+	/* 		actual = ctx->score[i]; */
 	/* 		t_index = i; */
-	/* 		if(phones[i]->score == 0) { */
+	/* 		if(ctx->score[i] == 0) { */
 	/* 			zero_scores++; */
 	/* 		} */
 	/* 	} */
-	/* 	if(fabs(phones[i]->score) < fabs(smallest)) { */
-	/* 		smallest = phones[i]->score; */
+	/* 	if(fabs(ctx->score[i]) < fabs(smallest)) { */
+	/* 		smallest = ctx->score[i]; */
 	/* 		index = i; */
 	/* 	}	 */
 	/* } */
 	for(int i = 1; i < j; i++) {
 		if(strcmp(phones[i]->index->name, ph_code) == 0) {
-			actual = phones[i]->score;
+			actual = ctx->score[i];
 			t_index = i;
-			/* if(phones[i]->score == 0) { */
-			/* 	smallest = phones[i]->score; */
+			/* if(ctx->score[i] == 0) { */
+			/* 	smallest = ctx->score[i]; */
 			/* 	index = i; */
 			/* 	sil_corr++; */
 			/* 	break; */
 			/* } */
 		}
-		if(phones[i]->score == 0) { 
+		if(ctx->score[i] == 0) { 
 			zero_scores++; 
 		}
-		if(fabs(phones[i]->score) < fabs(smallest)) {
-			smallest = phones[i]->score;
+		if(fabs(ctx->score[i]) < fabs(smallest)) {
+			smallest = ctx->score[i];
 			index = i;
 		}	
 	}
@@ -673,32 +819,33 @@ void export_results(char* ph_code)
 	}
 	if(strcmp(ph_code, "h#") == 0
 	   && (strcmp(phones[index]->index->name, "epi") == 0 || strcmp(phones[index]->index->name, "pau") == 0)) {
-		correct++;
+		ctx->n_correct++;
 		strcat(file_name, "./correct/");
 	} else if(strcmp(ph_code, "epi") == 0
 		  && (strcmp(phones[index]->index->name, "h#") == 0 || strcmp(phones[index]->index->name, "pau") == 0)) {
-		correct++;
+		ctx->n_correct++;
 		strcat(file_name, "./correct/");
 	} else if(strcmp(ph_code, "pau") == 0
 		  && (strcmp(phones[index]->index->name, "epi") == 0 || strcmp(phones[index]->index->name, "h#") == 0)) {
-		correct++;
+		ctx->n_correct++;
 		strcat(file_name, "./correct/");
 	} else if(zero_scores > 1) {
-		zero_fails++;
-		fails++;
+		ctx->zero_fails++;
+		ctx->fails++;
 		strcat(file_name, "./fails/");	
 	} else if(strcmp(ph_code, phones[index]->index->name) == 0) {
-		correct++;
+		ctx->n_correct++;
 		strcat(file_name, "./correct/");
 	} else if(strcmp(phones[index]->index->group, phones[t_index]->index->group) == 0) {
-		group++;
+		ctx->group++;
 		strcat(file_name, "./group/");
 	} else {
-		fails++;
+		ctx->fails++;
 		strcat(file_name, "./fails/");
 	}
 	strcat(file_name, ph_code);
 	strcat(file_name, ".txt");
+	pthread_mutex_lock(&results_lock);
 	FILE* fp = fopen(file_name, "a");
 	// printf("test filename = %s\n", file_name);
 	if(fp == NULL) {
@@ -709,21 +856,22 @@ void export_results(char* ph_code)
 	// printf("results = %d\n", results[0]);
 	fprintf(fp, "==== testing %s (pos %d, group %s) and got %s (pos %d, group %s) with a score of %f | actual phone got a score of %f \n", ph_code, t_index, phones[t_index]->index->group, phones[index]->index->name, phones[index]->index->i, phones[index]->index->group, smallest, actual);
 	for(int i =1; i < j; i++) {
-		if(phones[i]->score != DBL_MAX) {
-			fprintf(fp, "Score : %f | ph_code : %s\n", phones[i]->score, phones[i]->index->name);
+		if(ctx->score[i] != DBL_MAX) {
+			fprintf(fp, "Score : %f | ph_code : %s\n", ctx->score[i], phones[i]->index->name);
 		}
-		phones[i]->score = 0;
+		ctx->score[i] = 0;
 	}
 	// printf("t_index %d | index %d | num_ph %d\n", t_index, index, num_ph);
-	matrix[t_index][index]++;
+	ctx->matrix[t_index][index]++;
 	memset(file_name, 0, sizeof(file_name));
 	fclose(fp);
 	for(int i = 1; i < j; i++) {
-		phones[i]->score = 0;
+		ctx->score[i] = 0;
 	}
 	done++;
 	if(done % (BOUNDS ? 500 : 2500) == 0)
 		printf("::     COMPLETED TEST     ::  %02d:%02d:%02d  ::  %05d\n", hour(difftime(time(NULL), start)), minu(difftime(time(NULL), start)), seco(difftime(time(NULL), start)), done);
+	pthread_mutex_unlock(&results_lock);
 	return;
 }
 
@@ -735,6 +883,8 @@ void export_results(char* ph_code)
  * @param length The length of @param sequence
  * @param offset The offset of the file, used when NOSIL is used as the start of testing is no longer the start of the .wav file due to the removal of the
  * leading and trailing silence.
+ *
+ * The sequence is searched once from its start, each segment being tested as its boundary is found.
  */
 void utterance_test(char* filename, short* sequence, int length, int offset)
 {
@@ -765,32 +915,30 @@ void utterance_test(char* filename, short* sequence, int length, int offset)
 	if(!fp) { printf("Error opening res '%s' file\n", file); }
 	int bound = 0, res = 0;
 	int current_pos = 0;
-	while(1) {
-		bound = next_boundary(sequence, length);
-		if(bound == 0) {
-			sequence = shift_and_reduce(sequence, length, 32);
-			length = (length - 32);
-			continue;
-		}
-		if(bound == -1) {
-			break;
-		}
-		fprintf(fp, "%d ", current_pos + offset);
-		current_pos += bound;
+	struct Feature_Index* index = feature_index(sequence, length);
+	if(index == NULL) {
+		free(sequence);
+		if(fp) { fclose(fp); }
+		return;
+	}
+	struct Bound_Detector bd;
+	bound_detector_init(&bd, index);
+	while((bound = bound_detector_next(&bd, length)) != -1) {
 		fprintf(fp, "%d ", current_pos + offset);
-		short* h = calloc(bound, sizeof(short));
-		for(int i = 0; i < bound; i++) {
-			h[i] = sequence[i];
+		short* h = calloc(bound - current_pos, sizeof(short));
+		for(int i = current_pos; i < bound; i++) {
+			h[i - current_pos] = sequence[i];
 		}
-		res = test_phoneme_utterance(h, bound);
+		res = test_phoneme_utterance(h, bound - current_pos, index, current_pos);
+		current_pos = bound;
+		fprintf(fp, "%d ", current_pos + offset);
 		if(res == -1) {
 			printf("none found...\n");
 		} else {
 			fprintf(fp, "%s \n", phones[res]->index->name);
 		}
-		sequence = shift_and_reduce(sequence, length, bound);
-		length = (length - bound);
 	}
+	free_feature_index(index);
 	free(sequence);
 	fclose(fp);
 }
@@ -863,6 +1011,9 @@ void merge_silences(char* filename)
  */
 float data_size(void)
 {
+	if(store.mfcc != NULL) {
+		return (store.bytes / 1024.0F / 1024);
+	}
 	float bytes_saved = 0;
 	int j = 1;
 	while(strcmp(p_codes[j], "\0") != 0) {
@@ -950,16 +1101,14 @@ float reduce_data(void)
 				continue;
 			if(phones[i]->used[m] <= 1) {
 				bytes_saved += (phones[i]->size[m] * sizeof(float));
-				free(phones[i]->mfcc[m]);
+				remove_prototype(i, m);
 				phones[i]->mfcc[m] = NULL;
-				phones[i]->size[m] = 0;
 				phones[i]->reduced_count--;
 			} else if(strcmp(phones[i]->index->name, "sil")  == 0) {
 				if(phones[i]->size[m] > 1024) {
 					bytes_saved += (phones[i]->size[m] * sizeof(float));
-					free(phones[i]->mfcc[m]);
+					remove_prototype(i, m);
 					phones[i]->mfcc[m] = NULL;
-					phones[i]->size[m] = 0;
 					phones[i]->reduced_count--;
 				}
 			} else {
@@ -1126,13 +1275,13 @@ void test_output(FILE* m_fp)
  * @brief Trims the silence data from a given .wav file
  * 
  * @param fp The reference file associated with the .wav file
- * @param sequence The associated .wav file in an array
+ * @param sequence The associated .wav file in an array, which is not modified
  * 
  * @return The new wav structure with silence removed, the size updated and the offset
  *
  * When using a NOSIL dataset this function returns the structure with the silence removed and provides the offset so that the boundary .res files are correct.
  */
-struct wav_file* trim_silence(FILE* fp, short* sequence)
+struct wav_file* trim_silence(FILE* fp, const short* sequence)
 {
 	fseek(fp, 0, SEEK_SET);
 	long start = 0, end = 0, f_start = 0, f_end = 0, length = 0;
@@ -1163,60 +1312,126 @@ struct wav_file* trim_silence(FILE* fp, short* sequence)
 		result->seq[i - f_start] = sequence[i];
 	}
 	result->offset = f_start;
-	free(sequence);
 	fseek(fp, 0, SEEK_SET);
 	return result;
 	
 }
 
 /** 
- * @brief The main control function of the testing process.
+ * @brief Tests every phoneme of one .wav file using its .PHN reference file
+ * 
+ * @param dir_name The test dataset folder
+ * @param name The name of the .wav file within @param dir_name
+ * @param ctx The scoring context of the calling worker
+ */
+static void test_file(const char* dir_name, const char* name, struct Score_Context* ctx)
+{
+	char pathname[1024];
+	sprintf(pathname, "%s%s", dir_name, name);
+	struct Wav_Map* wv = wav_map(pathname);
+	if(wv == NULL) {
+		return;
+	}
+	sprintf(pathname, "%s%.*s.PHN", dir_name, (int)strlen(name) - 4, name);
+	FILE* fp = fopen(pathname, "r");
+	if(!fp) {
+		printf("Error opening phone '%s' file\n", pathname);
+		wav_unmap(wv);
+		return;
+	}
+	allocate_ph(fp, wv->samples, wv->length, 1, ctx);
+	wav_unmap(wv);
+	return;
+}
+
+/**
+ * \struct Test_Worker
+ * \brief A test thread, its scoring context and the shared list of files, or utterances of @corpus, to test
+ */
+struct Test_Worker {
+	pthread_t thread;
+	struct Score_Context ctx;
+	const char* dir_name;
+	char** files;
+	const struct Corpus* corpus;
+	int first;
+	int file_count;
+	atomic_int* next_file;
+};
+
+static void* test_worker(void* argv)
+{
+	struct Test_Worker* worker = (struct Test_Worker*)argv;
+	mask_sig();
+	int f = 0;
+	while((f = atomic_fetch_add(worker->next_file, 1)) < worker->file_count) {
+		if(worker->corpus != NULL) {
+			allocate_corpus(worker->corpus, worker->first + f, TEST, &worker->ctx);
+		} else {
+			test_file(worker->dir_name, worker->files[f], &worker->ctx);
+		}
+	}
+	return NULL;
+}
+
+/** 
+ * @brief Tests the files with \var glbl_test_threads workers, each taking the next untested file
+ * 
+ * @param dir_name The test dataset folder
+ * @param files The .wav files to test
+ * @param corpus The packed corpus to test instead of @param files, or NULL
+ * @param first The first utterance of @param corpus to test
+ * @param file_count The amount of @param files, or utterances
  *
- * Determines and sets the test dataset file path, iterates of the files in the dataset file path, produces and outputs the results of the testing process.
+ * Each worker scores into its own \struct Score_Context, which are merged in worker order once all have finished.
  */
-void test(void)
+static void test_files_threaded(const char* dir_name, char** files, const struct Corpus* corpus, int first, int file_count)
 {
-	reset();
-	done = 0;
-	if(BOUNDS) {
-		best_file = (char*)calloc(1, sizeof(char));
-		worst_file = (char*)calloc(1, sizeof(char));
+	atomic_int next_file = 0;
+	struct Test_Worker* workers = (struct Test_Worker*)malloc(sizeof(struct Test_Worker) * glbl_test_threads);
+	for(int t = 0; t < glbl_test_threads; t++) {
+		init_score_context(&workers[t].ctx);
+		workers[t].dir_name = dir_name;
+		workers[t].files = files;
+		workers[t].corpus = corpus;
+		workers[t].first = first;
+		workers[t].file_count = file_count;
+		workers[t].next_file = &next_file;
+		if(pthread_create(&workers[t].thread, NULL, test_worker, &workers[t]) != 0) {
+			printf("Failed to create test thread %d\n", t);
+			exit(-1);
+		}
+	}
+	for(int t = 0; t < glbl_test_threads; t++) {
+		if(pthread_join(workers[t].thread, NULL) != 0) {
+			printf("Thread join failed\n");
+			exit(-1);
+		}
+	}
+	for(int t = 0; t < glbl_test_threads; t++) {
+		merge_score_context(&workers[t].ctx);
+		free_score_context(&workers[t].ctx);
 	}
+	free(workers);
+	return;
+}
+
+/** 
+ * @brief Tests the .wav files of a dataset folder
+ * 
+ * @param dir_name The test dataset folder
+ * @param res_dir_name The folder of the boundary detection results
+ * @param threaded If one-to-one tests should be shared among \var glbl_test_threads workers
+ *
+ * @return 0, or -1 if the folder could not be read
+ */
+static int test_files(const char* dir_name, const char* res_dir_name, int threaded)
+{
 	DIR *p;
 	struct dirent *pp;
-	char dir_name[35];
-	char res_dir_name[55];
-	if(MALE) {
-		memcpy(dir_name, male_dir, sizeof(char) * (strlen(male_dir) + 1));
-		memcpy(res_dir_name, res_male_dir, sizeof(char) * (strlen(res_male_dir) + 1));
-	} else if (FEMALE) {
-		memcpy(dir_name, female_dir, sizeof(char) * (strlen(female_dir) + 1));
-		memcpy(res_dir_name, res_female_dir, sizeof(char) * (strlen(res_female_dir) + 1));
-	} else if (SPKR1 && !(CAR || STRT || CAFE || WHITE)) {
-		memcpy(dir_name, spkr1_dir, sizeof(char) * (strlen(spkr1_dir) + 1));
-		memcpy(res_dir_name, res_spkr1_dir, sizeof(char) * (strlen(res_spkr1_dir) + 1));
-	} else if (SPKR1 && CAR) {
-		memcpy(dir_name, spkr1_car_dir, sizeof(char) * (strlen(spkr1_car_dir) + 1));
-		memcpy(res_dir_name, res_spkr1_car_dir, sizeof(char) * (strlen(res_spkr1_car_dir) + 1));
-	} else if (SPKR1 && STRT) {
-		memcpy(dir_name, spkr1_strt_dir, sizeof(char) * (strlen(spkr1_strt_dir) + 1));
-		memcpy(res_dir_name, res_spkr1_strt_dir, sizeof(char) * (strlen(res_spkr1_strt_dir) + 1));
-	} else if (SPKR1 && CAFE) {
-		memcpy(dir_name, spkr1_cafe_dir, sizeof(char) * (strlen(spkr1_cafe_dir) + 1));
-		memcpy(res_dir_name, res_spkr1_cafe_dir, sizeof(char) * (strlen(res_spkr1_cafe_dir) + 1));
-	} else if (SPKR1 && WHITE) {
-		memcpy(dir_name, spkr1_white_dir, sizeof(char) * (strlen(spkr1_white_dir) + 1));
-		memcpy(res_dir_name, res_spkr1_white_dir, sizeof(char) * (strlen(res_spkr1_white_dir) + 1));
-	} else if (SPKR1_NOSIL) {
-		memcpy(dir_name, spkr1_nosil_dir, sizeof(char) * (strlen(spkr1_nosil_dir) + 1));
-		memcpy(res_dir_name, res_spkr1_nosil_dir, sizeof(char) * (strlen(res_spkr1_nosil_dir) + 1));
-	} else {
-		memcpy(dir_name, test_dir, sizeof(char) * (strlen(test_dir) + 1));
-		memcpy(res_dir_name, res_test_dir, sizeof(char) * (strlen(res_test_dir) + 1));
-	}
 	if(!(p = opendir (dir_name))) {
 		printf("Failed to open folder %s\n", dir_name);
-		return;
+		return -1;
 	}
 	char pathname[1024];
 	FILE* fp;
@@ -1230,7 +1445,7 @@ void test(void)
 	(void) closedir (p);
 	if(!(p = opendir (dir_name))) {
 		printf("Failed to open folder %s after counting files\n", dir_name);
-		return;
+		return -1;
 	}
 	
 	int chunk = files_to_test;
@@ -1240,6 +1455,12 @@ void test(void)
 	}
 	int current_file = 0;
 	printf(":: Testing folder :: %s :: %d files to test\n", dir_name, files_to_test);
+
+	char** files = NULL;
+	int file_count = 0;
+	if(threaded) {
+		files = (char**)malloc(sizeof(char*) * files_to_test);
+	}
 	if(p != NULL) {
 		while ((pp = readdir (p)) != NULL) {
 			if(current_file < current_chunk) {
@@ -1254,53 +1475,181 @@ void test(void)
 			// printf("current file: %d :: current_chunk : %d :: chunk :: %d\n", current_file, current_chunk, chunk);
 			short* sequence  = NULL;
 			int length = strlen(pp->d_name);
-			struct wav_file* wv = NULL;
+			struct Wav_Map* wv = NULL;
 			int seq_len = 0;
 			if (strncmp(pp->d_name + length - 4, ".wav", 4) == 0 || strncmp(pp->d_name + length - 4, ".WAV", 4) == 0) {
+				if(threaded) {
+					files[file_count] = (char*)malloc(sizeof(char) * (length + 1));
+					strcpy(files[file_count], pp->d_name);
+					file_count++;
+					continue;
+				}
+				if(!BOUNDS) {
+					test_file(dir_name, pp->d_name, &test_ctx);
+					continue;
+				}
 				int len = 4;
 				sprintf(pathname, "%s%s", dir_name, pp->d_name);
-				fp = fopen(pathname, "rb");
-				if(!fp) { printf("Error opening wav '%s' file\n", pathname); continue; }
-				wv = read_wav(fp);
-				sequence = wv->seq;
+				wv = wav_map(pathname);
+				if(wv == NULL) { continue; }
 				seq_len = wv->length;
 			        pp->d_name[length-len] = '\0';
 				strcat(pp->d_name, ".PHN");
 				sprintf(pathname, "%s%s", dir_name, pp->d_name);
 				fp = fopen(pathname, "r");
-				if(!fp) { printf("Error opening phone '%s' file\n", pathname); continue; }
-				if(BOUNDS) {
-					int offset = 0;
-					struct wav_file* trimmed = NULL;
-					if(SPKR1_NOSIL) {
-						trimmed = trim_silence(fp, sequence);
-						sequence = trimmed->seq;
-						offset = trimmed->offset;
-						seq_len = trimmed->length;
-					}
-					utterance_test(pp->d_name, sequence, seq_len, offset);
-					char res_pathname[1024];
-					pp->d_name[length-len] = '\0';
-					strcat(pp->d_name, ".res");
-					sprintf(res_pathname, "%s%s", res_dir_name, pp->d_name);
-					merge_silences(res_pathname);
-					minimum_edit_distance(res_pathname, pathname);
-					tested_files++;
-					if(trimmed != NULL) {
-						free(trimmed);
-					}
-					if(tested_files % 250 == 0)
-						printf("::     COMPLETED TEST     ::  %02d:%02d:%02d  ::  %05d\n", hour(difftime(time(NULL), start)), minu(difftime(time(NULL), start)), seco(difftime(time(NULL), start)), tested_files);
+				if(!fp) { printf("Error opening phone '%s' file\n", pathname); wav_unmap(wv); continue; }
+				int offset = 0;
+				struct wav_file* trimmed = NULL;
+				if(SPKR1_NOSIL) {
+					trimmed = trim_silence(fp, wv->samples);
+					sequence = trimmed->seq;
+					offset = trimmed->offset;
+					seq_len = trimmed->length;
 				} else {
-					allocate_ph(fp, sequence, 1);
-					free(sequence);
+					// utterance_test() frees the sequence it is given
+					sequence = (short*)malloc(sizeof(short) * seq_len);
+					memcpy(sequence, wv->samples, sizeof(short) * seq_len);
+				}
+				wav_unmap(wv);
+				utterance_test(pp->d_name, sequence, seq_len, offset);
+				char res_pathname[1024];
+				pp->d_name[length-len] = '\0';
+				strcat(pp->d_name, ".res");
+				sprintf(res_pathname, "%s%s", res_dir_name, pp->d_name);
+				merge_silences(res_pathname);
+				minimum_edit_distance(res_pathname, pathname);
+				tested_files++;
+				if(trimmed != NULL) {
+					free(trimmed);
 				}
+				if(tested_files % 250 == 0)
+					printf("::     COMPLETED TEST     ::  %02d:%02d:%02d  ::  %05d\n", hour(difftime(time(NULL), start)), minu(difftime(time(NULL), start)), seco(difftime(time(NULL), start)), tested_files);
 			}
-			free(wv);
-			
 		}
 		(void) closedir (p);
 	}
+	if(threaded) {
+		test_files_threaded(dir_name, files, NULL, 0, file_count);
+		for(int f = 0; f < file_count; f++) {
+			free(files[f]);
+		}
+		free(files);
+	}
+	return 0;
+}
+
+/** 
+ * @brief Tests the packed corpus of a dataset folder, see \fn pack_corpus()
+ * 
+ * @param dir_name The test dataset folder
+ * @param threaded If the utterances should be shared among \var glbl_test_threads workers
+ *
+ * With SPLIT_DATA the corpus is divided by utterances.
+ *
+ * @return 0, or -1 if the corpus could not be read
+ */
+static int test_corpus(const char* dir_name, int threaded)
+{
+	char corpus_name[64];
+	struct Corpus* corpus = corpus_map(corpus_path(dir_name, corpus_name), num_ph);
+	if(corpus == NULL) {
+		return -1;
+	}
+	int utterances = corpus->header->utterances;
+	int chunk = utterances;
+	if(SPLIT_DATA) {
+		chunk = floor(utterances / glbl_test_iter);
+	}
+	int first = (current_chunk < utterances) ? current_chunk : utterances;
+	int last = (first + chunk < utterances) ? first + chunk : utterances;
+	current_chunk += chunk;
+	printf(":: Testing corpus :: %s :: %d utterances to test\n", corpus_name, last - first);
+	if(threaded) {
+		test_files_threaded(dir_name, NULL, corpus, first, last - first);
+	} else {
+		for(int u = first; u < last; u++) {
+			allocate_corpus(corpus, u, TEST, &test_ctx);
+		}
+	}
+	corpus_unmap(corpus);
+	return 0;
+}
+
+/**
+ * @brief The test dataset folder chosen by the dataset and noise flags
+ *
+ * @param res_dir_name Set to the folder of the boundary detection results when not NULL
+ */
+const char* test_folder(const char** res_dir_name)
+{
+	const char* dir_name = test_dir;
+	const char* res = res_test_dir;
+	if(MALE) {
+		dir_name = male_dir; res = res_male_dir;
+	} else if (FEMALE) {
+		dir_name = female_dir; res = res_female_dir;
+	} else if (SPKR1 && !(CAR || STRT || CAFE || WHITE)) {
+		dir_name = spkr1_dir; res = res_spkr1_dir;
+	} else if (SPKR1 && CAR) {
+		dir_name = spkr1_car_dir; res = res_spkr1_car_dir;
+	} else if (SPKR1 && STRT) {
+		dir_name = spkr1_strt_dir; res = res_spkr1_strt_dir;
+	} else if (SPKR1 && CAFE) {
+		dir_name = spkr1_cafe_dir; res = res_spkr1_cafe_dir;
+	} else if (SPKR1 && WHITE) {
+		dir_name = spkr1_white_dir; res = res_spkr1_white_dir;
+	} else if (SPKR1_NOSIL) {
+		dir_name = spkr1_nosil_dir; res = res_spkr1_nosil_dir;
+	}
+	if(res_dir_name != NULL) {
+		*res_dir_name = res;
+	}
+	return dir_name;
+}
+
+/** 
+ * @brief The main control function of the testing process.
+ *
+ * Determines and sets the test dataset file path, iterates of the files in the dataset file path, produces and outputs the results of the testing process.
+ * With threads N the files of one-to-one testing are shared among N workers by \fn test_files_threaded().
+ * With CORPUS the folder's packed corpus is tested instead, except when detecting boundaries.
+ * The prototypes are indexed by size for the iteration by \fn index_prototypes().
+ */
+void test(void)
+{
+	reset();
+	done = 0;
+	index_prototypes();
+	init_score_context(&test_ctx);
+	if(BOUNDS) {
+		best_file = (char*)calloc(1, sizeof(char));
+		worst_file = (char*)calloc(1, sizeof(char));
+	}
+	const char* res_dir_name = NULL;
+	const char* dir_name = test_folder(&res_dir_name);
+	// GROUP and VOICED toggle the global feature flags while classifying
+	int threaded = glbl_test_threads > 1 && !(BOUNDS || GROUP || VOICED);
+	if(glbl_test_threads > 1 && !threaded) {
+		printf(":: Testing with one thread, BOUNDS, GROUP and VOICED are not thread safe\n");
+	}
+	int failed = 0;
+	if(CORPUS && !BOUNDS) {
+		if(test_corpus(dir_name, threaded) != 0) {
+			failed = 1;
+			goto cleanup;
+		}
+	} else if(test_files(dir_name, res_dir_name, threaded) != 0) {
+		failed = 1;
+		goto cleanup;
+	}
+cleanup:
+	// The counts gathered before a failure are kept
+	merge_score_context(&test_ctx);
+	free_score_context(&test_ctx);
+	free_prototype_index();
+	if(failed) {
+		return;
+	}
 
 	FILE* m_fp = fopen("../Testing/TEST/matrix.txt", "a");
 	if(m_fp == NULL) {
@@ -9,10 +9,16 @@
 #include "../Seperation/bounds.h"
 #include "../Clustering/knn.h"
 
-void export_results(char* ph_code);
+void export_results(char* ph_code, struct Score_Context* ctx);
 void export_results_aao(char* ph_code);
 void test(void);
-void test_phoneme(short* h, int signal_length, char* p);
+const char* test_folder(const char** res_dir_name);
+void test_phoneme(short* h, int signal_length, char* p, struct Score_Context* ctx);
+struct Test_Features* test_features(short* h, int signal_length, int norm, struct Mfcc_Plan* plan, const struct Feature_Index* index, int from);
+void free_test_features(struct Test_Features* test);
+void init_score_context(struct Score_Context* ctx);
+void merge_score_context(struct Score_Context* ctx);
+void free_score_context(struct Score_Context* ctx);
 void test_phoneme_aao(short* h, long start_end[2], char* p);
 void test_phoneme_pca(short* h, long start_end[2], char* p);
 float reduce_data(void);
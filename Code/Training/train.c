@@ -145,32 +145,21 @@ int frame_amount(int signal_length)
 }
 
 /**
- * \fn cubic_interpolate()
- * \brief Interpolates between points @y1 and @y2 using @y0 and @y3 to apply the cubic function
- * @mu is the distance between @y1 and @y2 the user wishes the return to be and so a value between 0 and 1 is used
- */ 
-double cubic_interpolate(short y0, short y1, short y2, short y3, double mu)
-{
-	short a0 = 0, a1 = 0, a2 = 0, a3 = 0, mu2  = 0;
-
-	mu2 = mu*mu;
-	a0 = y3 - y2 - y0 + y1;
-	a1 = y0 - y1 - a0;
-	a2 = y2 - y0;
-	a3 = y1;
-	return(a0*mu*mu2+a1*mu2+a2*mu+a3);
-}
-
-long double ld_cubic_interpolate(long double y0, long double y1, long double y2, long double y3, long double mu)
+ * \fn train_folder()
+ * \brief The training dataset folder chosen by the dataset flags
+ */
+const char* train_folder(void)
 {
-	long double a0 = 0, a1 = 0, a2 = 0, a3 = 0, mu2  = 0;
-
-	mu2 = mu*mu;
-	a0 = y3 - y2 - y0 + y1;
-	a1 = y0 - y1 - a0;
-	a2 = y2 - y0;
-	a3 = y1;
-	return(a0*mu*mu2+a1*mu2+a2*mu+a3);
+	if(MALE) {
+		return male_dir;
+	} else if (FEMALE) {
+		return female_dir;
+	} else if (SPKR1) {
+		return spkr1_dir;
+	} else if (SPKR1_NOSIL) {
+		return spkr1_nosil_dir;
+	}
+	return train_dir;
 }
 
 /**
@@ -178,23 +167,26 @@ long double ld_cubic_interpolate(long double y0, long double y1, long double y2,
  * \brief is the main control function for training
  * \fn train() handles reading in all files from the specified folder, a .wav is found a read then a corresponding
  * .PHN file found. These are passed to \fn allocate_ph() to read, MFCC'd and applied to a phoneme prototype
+ * With CORPUS the folder's packed corpus is read instead, see \fn pack_corpus()
  */
 void train(void)
 {
 	
 	DIR *p;
 	struct dirent *pp;
-	char dir_name[35];
-	if(MALE) {
-		memcpy(dir_name, male_dir, sizeof(char) * (strlen(male_dir) + 1));
-	} else if (FEMALE) {
-		memcpy(dir_name, female_dir, sizeof(char) * (strlen(female_dir) + 1));
-	} else if (SPKR1) {
-		memcpy(dir_name, spkr1_dir, sizeof(char) * (strlen(spkr1_dir) + 1));
-	} else if (SPKR1_NOSIL) {
-		memcpy(dir_name, spkr1_nosil_dir, sizeof(char) * (strlen(spkr1_nosil_dir) + 1));
-	} else {
-		memcpy(dir_name, train_dir, sizeof(char) * (strlen(train_dir) + 1));
+	const char* dir_name = train_folder();
+	if(CORPUS) {
+		char corpus_name[64];
+		struct Corpus* corpus = corpus_map(corpus_path(dir_name, corpus_name), num_ph);
+		if(corpus == NULL) {
+			return;
+		}
+		printf(":: Training corpus :: %s :: %u utterances to train\n", corpus_name, corpus->header->utterances);
+		for(uint32_t u = 0; u < corpus->header->utterances; u++) {
+			allocate_corpus(corpus, u, TRAIN, NULL);
+		}
+		corpus_unmap(corpus);
+		return;
 	}
 	if(!(p = opendir (dir_name))) {
 		printf("Failed to open foder %s\n", dir_name);
@@ -220,28 +212,27 @@ void train(void)
 	if (p != NULL) {
 		while ((pp = readdir (p)) != NULL) {
 			
-			short* sequence  = NULL;
-			struct wav_file* wv = NULL;
+			struct Wav_Map* wv = NULL;
 			int length = strlen(pp->d_name);
 			if (strncmp(pp->d_name + length - 4, ".wav", 4) == 0 || strncmp(pp->d_name + length - 4, ".WAV", 4) == 0) {
 				int len = 8;
 				if(strncmp(pp->d_name + length - 4, ".wav", 4) == 0)
 					len = 4;
 				sprintf(pathname, "%s%s", dir_name, pp->d_name);
-				fp = fopen(pathname, "rb");
-				if(!fp) { printf("Error opening '%s' file", pathname); }
-				wv = read_wav(fp);
-				sequence = wv->seq;
+				wv = wav_map(pathname);
+				if(wv == NULL) { continue; }
 			        pp->d_name[length-len] = '\0';
 				strcat(pp->d_name, ".PHN");
 				sprintf(pathname, "%s%s", dir_name, pp->d_name);
 				fp = fopen(pathname, "r");
-				if(!fp) { printf("Error opening '%s' file", pathname); }
-				allocate_ph(fp, sequence, 0);
-				free(sequence);
-				
+				if(!fp) {
+					printf("Error opening '%s' file\n", pathname);
+					wav_unmap(wv);
+					continue;
+				}
+				allocate_ph(fp, wv->samples, wv->length, 0, NULL);
+				wav_unmap(wv);
 			}
-			free(wv);			
 		}
 		(void) closedir (p);
 	}
@@ -249,49 +240,26 @@ void train(void)
 
 /**
  * \fn resize()
- * \brief resizes a given signal (@shorter) from size @s to size @l using cubic interpolation
+ * \brief resizes a given signal (@shorter) from size @s to size @l with the \var glbl_resample method, see \fn resample_s16()
+ * @shorter is freed and the resized signal returned
  */ 
 short* resize(short* shorter, size_t s, size_t l)
 {
-	short* new_sequence = calloc(l, sizeof(short));
-	for(unsigned int i = 0; i < s; i++) {
-		new_sequence[i] = shorter[i];
-	}
+	short* new_sequence = (short*)malloc(sizeof(short) * l);
+	resample_s16(shorter, s, new_sequence, l, glbl_resample, s / 4);
 	free(shorter);
-	size_t i = floor(s / 4);
-	while(s < l) {
-		for(size_t j = s-1; j >= i ; j--) {
-			new_sequence[ j + 1 ] = new_sequence[ j ];
-		}
-	        		
-	        new_sequence[i] = cubic_interpolate((short)new_sequence[i - 2], (short)new_sequence[i - 1], (short)new_sequence[i + 1], (short)new_sequence[i + 2], 0.5);
-		s++;
-		if(i + 2 >= s - 5){  i = 5; }
-		i+=2;	
-	}
 	return new_sequence;
-
-	
 }
 
+/**
+ * \fn ld_resize()
+ * \brief The long double equivalent of \fn resize(), used on the summed signals of the phoneme prototypes
+ */ 
 long double* ld_resize(long double* shorter, size_t s, size_t l)
 {
-	long double* new_sequence = calloc(l, sizeof(long double));
-	for(unsigned int i = 0; i < s; i++) {
-		new_sequence[i] = shorter[i];
-	}
+	long double* new_sequence = (long double*)malloc(sizeof(long double) * l);
+	resample_ld(shorter, s, new_sequence, l, glbl_resample, s / 2);
 	free(shorter);
-	size_t i = floor(s / 2);
-	while(s < l) {
-		for(size_t j = s-1; j >= i ; j--) {
-			new_sequence[ j + 1 ] = new_sequence[ j ];
-		}
-		
-	        new_sequence[i] = ld_cubic_interpolate((long double)new_sequence[i - 2], (long double)new_sequence[i - 1], (long double)new_sequence[i + 1], (long double)new_sequence[i + 2], 0.5);
-		s++;
-		if(i + 2 >= s - 5){  i = 5; }
-		i+=2;	
-	}
 	return new_sequence;
 }
 
@@ -309,8 +277,9 @@ long double* ld_resize(long double* shorter, size_t s, size_t l)
 short* train_ph_mfcc(int new, short* sequence, struct Phoneme* phone)
 {
 
-	if(new == 0 || mfcc_size(new) == 0) {
-		printf("Zero size not permitted :: new : %d || mfcc(new) : %d\n", new, mfcc_size(new));
+	int new_size = mfcc_size(new);
+	if(new == 0 || new_size == 0) {
+		printf("Zero size not permitted :: new : %d || mfcc(new) : %d\n", new, new_size);
 		return sequence;
 	}
 
@@ -326,8 +295,9 @@ short* train_ph_mfcc(int new, short* sequence, struct Phoneme* phone)
 		phone->size_count++;
 		return sequence;
 	}
-	for(int i = 0; i < phone->size_count; i++) { 
-		if(mfcc_size(new) == mfcc_size(phone->size[i]) && phone->size_count >= glbl_mfcc_num) {
+	// Below the prototype limit every new sequence is a new prototype
+	for(int i = 0; i < phone->size_count && phone->size_count >= glbl_mfcc_num; i++) { 
+		if(new_size == mfcc_size(phone->size[i])) {
 			if(new > phone->size[i]) {
 				for(int j = 0; j < phone->size[i]; j++) {
 					long double temp = phone->sequence[i][j];
@@ -427,117 +397,131 @@ short* train_ph_mfcc(int new, short* sequence, struct Phoneme* phone)
 	return sequence;
 }
 
+/**
+ * \fn allocate_segment()
+ * \brief Trains or tests one labelled phoneme, the samples @from to @to of @wav labelled as phoneme @n
+ * If training the signal is passed to \fn train_ph_mfcc() and min max values for silence, ste and zc values are updated here as well
+ * If testing the signal for the phoneme is passed to \fn test_phoneme() with @ctx, the tester's \struct Score_Context; NULL when training
+ * @filename The .PHN file the label came from
+ */
+void allocate_segment(const short* wav, long from, long to, int n, unsigned char t_t, struct Score_Context* ctx, char* filename)
+{
+	if(strcmp(p_codes[n], "sil") == 0) {
+		to = (to + from) / 2;
+	}
+	int length = to - from;
+	if(length <= 0) {
+		printf("Negative length from wav :: %ld - %ld\n", from, to);
+		return;
+	}
+	short* h = (short*)calloc(length, sizeof(short));
+	memcpy(h, &wav[from], sizeof(short) * length);
+	for(int i = 1; i < length; i++) {
+		h[i] = h[i] - (0.95 * h[i-1]);
+	}
+	int signal_length = length - 1;
+	int new_length = signal_length;
+	// by width / div_interval ?
+	if(signal_length % glbl_window_width != 0) {
+		while(new_length % glbl_window_width != 0) {
+			new_length++;
+		}
+		h = resize(h, signal_length, new_length);
+		signal_length = new_length;
+	}
+	if((signal_length / glbl_paa) < glbl_window_width) {
+		h = resize(h, signal_length, (glbl_window_width * glbl_paa));
+		signal_length = (glbl_window_width * glbl_paa);
+	}
+	// h = resize(h, signal_length, (signal_length * 2));
+	// signal_length = (signal_length * 2);
+	if(t_t == TRAIN) {
+		// int end =  floor((to - from - 1));
+		
+		// update_pca(h, signal_length, n); 
+		float* signal = (float*)calloc(signal_length, sizeof(float));
+		for(int i = 0; i < signal_length; i++) {
+			signal[i] = h[i];
+		}
+		update_zc(signal, signal_length, n);
+		update_ste(h, signal_length, n);
+		
+		if(strcmp("sil", phones[n]->index->name) == 0) {
+			update_sil_zc(h, signal_length, filename);
+			update_sil_ste(h, signal_length, filename);
+		}
+		h = train_ph_mfcc(signal_length, h, phones[n]);
+		trained++;
+		phones[n]->trained++;
+							
+		if(trained % 5000 == 0)
+			printf("::       TRAINED P#       ::  %02d:%02d:%02d  ::  %05d\n", hour(difftime(time(NULL), start)), minu(difftime(time(NULL), start)), seco(difftime(time(NULL), start)), trained);
+		free(signal);
+	} else {
+		ctx->per_correct[n]++;
+		test_phoneme(h, signal_length, p_codes[n], ctx);
+	}
+	free(h);
+}
+
+/**
+ * \fn read_phn_line()
+ * \brief Reads the start, end and phoneme of a .PHN line into @start_end
+ * @return The index of the phoneme within @p_codes, or 0 if the line's length is negative or its phoneme unknown
+ */
+static int read_phn_line(char* line, long* start_end)
+{
+	char* end_ptr;
+	char* save_ptr;
+	char *p; 
+	p = strtok_r(line, " ", &save_ptr);
+	start_end[0] = strtol(p, &end_ptr, 10);
+      	p = strtok_r(NULL, " ", &save_ptr);
+	start_end[1] = strtol(p, &end_ptr, 10);
+	p = strtok_r(NULL, " ", &save_ptr);
+	while(p[strlen(p) - 1] == '\n' || p[strlen(p) - 1] == ' ') {
+		p[strlen(p) - 1] = '\0';
+	}
+
+	if((start_end[1] - start_end[0]) <= 0) {
+		printf("Negative length from wav %s :: %ld - %ld\n", p, start_end[0], start_end[1]);
+		return 0;
+	}
+	for(int n = 1; n < num_ph ; n++) {
+		if(strcmp(p_codes[n], p) == 0) {
+			return n;
+		}
+	}
+	return 0;
+}
+
 /**
  * \fn allocate_ph()
  * \brief This function is used by \fn train() and \fn test() to read phoneme sequences from .wav files using .PHN data
- * If training then the signal is passed to \fn train_ph_mfcc() and min max values for silence, ste and zc values are updated here as well
- * If testing the signal for the phoneme is found then passed to \fn test_phoneme()
+ * Each labelled phoneme is passed to \fn allocate_segment(), @ctx is the tester's \struct Score_Context; NULL when training
+ * Labels are clamped to the @samples of @wav as \fn pack_corpus() clamps them, so a .PHN past the audio is not read beyond it
  */
-void allocate_ph(FILE* fp, short* wav, unsigned char t_t)
+void allocate_ph(FILE* fp, const short* wav, int samples, unsigned char t_t, struct Score_Context* ctx)
 {
 	char line[256];
-	char* end_ptr;
-	char *p; 
 	long start_end[2];
+	char filename[0xFFF] = "";
+	if(t_t == TRAIN) {
+		char proclnk[64];
+		sprintf(proclnk, "/proc/self/fd/%d", fileno(fp));
+		ssize_t r = readlink(proclnk, filename, sizeof(filename) - 1);
+		filename[(r < 0) ? 0 : r] = '\0';
+	}
 	
 	while(fgets(line, sizeof(line), fp)) {
-		p = strtok(line," ");
-		start_end[0] = strtol(p, &end_ptr, 10);
-	      	p = strtok(NULL, " ");
-		start_end[1] = strtol(p, &end_ptr, 10);
-		p = strtok(NULL, " ");
-		while(p[strlen(p) - 1] == '\n' || p[strlen(p) - 1] == ' ') {
-			p[strlen(p) - 1] = '\0';
-		}
-
-		if((start_end[1] - start_end[0]) <= 0) {
-			printf("Negative length from wav %s :: %ld - %ld\n", p, start_end[0], start_end[1]);
+		int n = read_phn_line(line, start_end);
+		if(n == 0 || start_end[0] < 0 || start_end[0] >= samples || start_end[1] < start_end[0]) {
 			continue;
 		}
-		if(strcmp(p, "sil") == 0) {
-			start_end[1] = (start_end[1] + start_end[0]) / 2;
+		if(start_end[1] > samples) {
+			start_end[1] = samples;
 		}
-		short* h = (short*)calloc((start_end[1] - start_end[0]), sizeof(short));
-		for(int n = 1; n < num_ph ; n++) {
-			if(strcmp(p_codes[n], p) == 0) {
-				int m  = 0;
-				// printf("length :: %ld\nstart :: %ld\nend :: %ld\nph :: %s\n", (start_end[1] - start_end[0]), start_end[0], start_end[1], p);
-				for(int j = start_end[0]; j < start_end[1]; j++) {
-					h[m] = wav[j];
-					m++;	
-				}
-				int length = start_end[1] - start_end[0];
-				
-				if(length <= 0) {
-					printf("Negative length from wav :: %ld - %ld\n", start_end[0], start_end[1]);
-					break;
-				}
-				for(int i = 1; i < length; i++) {
-					h[i] = h[i] - (0.95 * h[i-1]);
-				}
-				int signal_length = start_end[1] - start_end[0] - 1;
-				int new_length = signal_length;
-				// by width / div_interval ?
-				if(signal_length % glbl_window_width != 0) {
-					while(new_length % glbl_window_width != 0) {
-						new_length++;
-					}
-					h = resize(h, signal_length, new_length);
-					signal_length = new_length;
-				}
-				if((signal_length / glbl_paa) < glbl_window_width) {
-					h = resize(h, signal_length, (glbl_window_width * glbl_paa));
-					signal_length = (glbl_window_width * glbl_paa);
-				}
-				// h = resize(h, signal_length, (signal_length * 2));
-				// signal_length = (signal_length * 2);
-				if(t_t == TRAIN) {
-					// int end =  floor((start_end[1] - start_end[0] - 1));
-					
-					// update_pca(h, signal_length, n); 
-					float* signal = (float*)calloc(signal_length, sizeof(float));
-					for(int i = 0; i < signal_length; i++) {
-						signal[i] = h[i];
-					}
-					int MAXSIZE = 0xFFF;
-					char proclnk[0xFFF];
-					char filename[0xFFF];
-					int fno;
-					ssize_t r;
-					
-					fno = fileno(fp);
-					sprintf(proclnk, "/proc/self/fd/%d", fno);
-					r = readlink(proclnk, filename, MAXSIZE);
-					filename[r] = '\0';
-					
-					update_zc(signal, signal_length, n);
-					update_ste(h, signal_length, n);
-					
-					if(strcmp("sil", phones[n]->index->name) == 0) {
-						update_sil_zc(h, signal_length, filename);
-						update_sil_ste(h, signal_length, filename);
-					}
-					// printf("fp -> fno -> filename: %p -> %d -> %s\n",
-					// (void*)fp, fno, filename);
-					h = train_ph_mfcc(signal_length, h, phones[n]);
-					trained++;
-					phones[n]->trained++;
-										
-					if(trained % 5000 == 0)
-						printf("::       TRAINED P#       ::  %02d:%02d:%02d  ::  %05d\n", hour(difftime(time(NULL), start)), minu(difftime(time(NULL), start)), seco(difftime(time(NULL), start)), trained);
-					free(signal);
-				} else {
-					per_correct[n]++;
-					test_phoneme(h, signal_length, p);
-					// test_phoneme_pca(h, start_end, p);
-					// test_phoneme_aao(h, start_end, p);
-				}
-			}
-		}
-		if(h != NULL) {
-			free(h);
-		}
-		
+		allocate_segment(wav, start_end[0], start_end[1], n, t_t, ctx, filename);
 	}
 
 	fclose(fp);
@@ -546,50 +530,96 @@ void allocate_ph(FILE* fp, short* wav, unsigned char t_t)
 }
 
 /**
- * \fn read_wav()
- * \brief reads the wav file in full and returns a \struct wav_file containing the data and length of data
+ * \fn allocate_corpus()
+ * \brief The packed equivalent of \fn allocate_ph(), passes the segments of utterance @u of @corpus to \fn allocate_segment()
  */
-struct wav_file* read_wav(FILE* fp)
+void allocate_corpus(const struct Corpus* corpus, int u, unsigned char t_t, struct Score_Context* ctx)
 {
+	const struct Corpus_Utterance* utt = &corpus->utterances[u];
+	char* filename = (char*)corpus_name(corpus, u);
+	for(uint32_t s = utt->first; s < utt->first + utt->count; s++) {
+		const struct Corpus_Segment* seg = &corpus->segments[s];
+		allocate_segment(&corpus->audio[utt->offset], seg->start, seg->end, seg->phoneme, t_t, ctx, filename);
+	}
+}
 
-	char *buffer;
-	long file_length;
-	struct wav_file* wv = (struct wav_file*)malloc(sizeof(struct wav_file));
-	fseek(fp, 0, SEEK_END);
-	file_length = ftell(fp);
-	rewind(fp);
-	buffer = (char *)malloc(file_length * sizeof(char));
-	fread(buffer, file_length, 1, fp);
-	fclose(fp);
-
-	int sample_bits =(int)((unsigned char)(buffer[35]) << 8 |
-			       (unsigned char)(buffer[34]));
+/**
+ * \fn corpus_path()
+ * \brief Writes the path of the packed corpus of @dir_name to @path, the folder without its trailing slash and with .corpus
+ */
+char* corpus_path(const char* dir_name, char* path)
+{
+	int length = strlen(dir_name);
+	if(length > 0 && dir_name[length - 1] == '/') {
+		length--;
+	}
+	sprintf(path, "%.*s.corpus", length, dir_name);
+	return path;
+}
 
-	int sample_size =(int)((unsigned char)(buffer[43]) << 24 |
-			       (unsigned char)(buffer[42]) << 16 |
-			       (unsigned char)(buffer[41]) << 8 |
-			       (unsigned char)(buffer[40]));
-	
-	short* sequence = calloc((sample_size / 2), sizeof(short));
-	short byte = 0;
-	if(sample_bits == 16) { // short size
-		int incr = 44, pos = 0;
-		while(incr != (sample_size + 44)) {
-			byte = (short)((unsigned char)(buffer[incr+1]) << 8|
-					      (unsigned char)(buffer[incr]));
-			memcpy(&sequence[pos], &byte, sizeof(byte));
-			pos++;
-			incr +=2;
+/**
+ * \fn pack_corpus()
+ * \brief Packs the .wav and .PHN files of @dir_name into one corpus, read by \fn train() and \fn test() with CORPUS
+ * The files are packed in the order the folder lists them so a packed pass matches a pass over the folder. Only the
+ * labels \fn allocate_ph() would use are kept, their ends clamped to the utterance.
+ * @return 0, or -1 if the corpus could not be written
+ */
+int pack_corpus(const char* dir_name)
+{
+	DIR* p;
+	struct dirent* pp;
+	char pathname[1024];
+	char corpus_name[64];
+	if(!(p = opendir(dir_name))) {
+		printf("Failed to open folder %s\n", dir_name);
+		return -1;
+	}
+	struct Corpus_Writer* cw = corpus_writer(corpus_path(dir_name, corpus_name));
+	if(cw == NULL) {
+		closedir(p);
+		return -1;
+	}
+	while((pp = readdir(p)) != NULL) {
+		int length = strlen(pp->d_name);
+		if(length < 4 || !(strncmp(pp->d_name + length - 4, ".wav", 4) == 0 || strncmp(pp->d_name + length - 4, ".WAV", 4) == 0)) {
+			continue;
 		}
-	} else {
-		printf("Samples bits != 16...\n");
-		exit(-1);
+		sprintf(pathname, "%s%s", dir_name, pp->d_name);
+		struct Wav_Map* wv = wav_map(pathname);
+		if(wv == NULL) {
+			continue;
+		}
+		sprintf(pathname, "%s%.*s.PHN", dir_name, length - 4, pp->d_name);
+		FILE* fp = fopen(pathname, "r");
+		if(!fp) {
+			printf("Error opening phone '%s' file\n", pathname);
+			wav_unmap(wv);
+			continue;
+		}
+		sprintf(pathname, "%.*s", length - 4, pp->d_name);
+		corpus_add_utterance(cw, pathname, wv->samples, wv->length);
+		char line[256];
+		long start_end[2];
+		while(fgets(line, sizeof(line), fp)) {
+			int n = read_phn_line(line, start_end);
+			if(n == 0 || start_end[0] < 0 || start_end[0] >= wv->length || start_end[1] < start_end[0]) {
+				continue;
+			}
+			if(start_end[1] > wv->length) {
+				start_end[1] = wv->length;
+			}
+			corpus_add_segment(cw, start_end[0], start_end[1], n, phones[n]->index->group_i, phones[n]->index->voice);
+		}
+		fclose(fp);
+		wav_unmap(wv);
 	}
-	wv->seq = sequence;
-	wv->length = (sample_size / 2);
-	free(buffer);
-	return wv;
-
+	closedir(p);
+	if(corpus_finish(cw) != 0) {
+		printf("Failed writing the corpus %s\n", corpus_name);
+		return -1;
+	}
+	printf(":: Packed corpus :: %s\n", corpus_name);
+	return 0;
 }
 
 void update_sil_mean(short* signal, int signal_length)
@@ -13,9 +13,12 @@
 #include "../Clustering/cluster.h"
 #include "../Dynamic_Time_Warping/dtw.h"
 #include "../Misc/realloc.h"
+#include "../Misc/wav.h"
+#include "../Misc/corpus.h"
 #include "../Testing/test.h"
 #include "../Feature_Extraction/paa.h"
 #include "../Feature_Extraction/mfcc.h"
+#include "../Feature_Extraction/resample.h"
 #include "../Seperation/cross_rate.h"
 #include "../Seperation/ste.h"
 
@@ -28,10 +31,13 @@ struct wav_file {
 	int offset;
 };
 
-double cubic_interpolate(short y0, short y1, short y2, short y3, double mu);
 void train(void);
-struct wav_file* read_wav(FILE* fp);
-void allocate_ph(FILE* fp, short* wav, unsigned char t_t);
+void allocate_ph(FILE* fp, const short* wav, int samples, unsigned char t_t, struct Score_Context* ctx);
+void allocate_segment(const short* wav, long from, long to, int n, unsigned char t_t, struct Score_Context* ctx, char* filename);
+void allocate_corpus(const struct Corpus* corpus, int u, unsigned char t_t, struct Score_Context* ctx);
+const char* train_folder(void);
+char* corpus_path(const char* dir_name, char* path);
+int pack_corpus(const char* dir_name);
 short* train_ph(int new, short* sequence, struct Phoneme* ph); 
 short* init_new_phone(struct Phoneme* phone, short* sequence, int new);
 short* resize(short* shorter, size_t s, size_t l);